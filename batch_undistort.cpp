@@ -0,0 +1,298 @@
+#include <opencv2/opencv.hpp>
+#include "kitti360_calibration/calibration_registry.h"
+#include "frame_pipeline/batch_reader.h"
+#include "frame_pipeline/buffer_pool.h"
+#include "frame_pipeline/disparity.h"
+#include "frame_pipeline/frame_cache.h"
+#include "frame_pipeline/frame_convert.h"
+#include "frame_pipeline/jpeg_decoder.h"
+#include "frame_pipeline/png_decoder.h"
+#include "frame_pipeline/tiled_remap.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <filesystem>
+#include <future>
+#include <atomic>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+// Rectifies (image_00/01) or unwraps (image_02/03) a directory of frames at full resolution
+// through the same registry maps and tiled remap as the viewer. In disparity mode the
+// image_00 frames are matched against the image_01 frames of the same name instead.
+class BatchUndistorter {
+private:
+    std::string cameraName;
+    std::shared_ptr<const kitti360::CalibrationSnapshot> calibration;
+    std::shared_ptr<const kitti360::UndistortionMaps> maps;
+    std::unique_ptr<frame_pipeline::TiledRemap> remap;
+    
+    // Disparity mode: right camera of the stereo pair and full-resolution matcher settings
+    std::string stereoDirectory;
+    std::shared_ptr<const kitti360::UndistortionMaps> stereoMaps;
+    std::unique_ptr<frame_pipeline::TiledRemap> stereoRemap;
+    frame_pipeline::DisparitySettings disparitySettings;
+    
+    const std::string CALIBRATION_DIRECTORY = "kitti360_calibration";
+    const std::string MAP_CACHE_DIRECTORY = "kitti360_calibration/map_cache";
+    const size_t BATCH_FRAMES = 32; // Frames read while the previous batch is processed
+    
+    std::atomic<size_t> written;
+    std::atomic<size_t> skipped;
+    
+public:
+    explicit BatchUndistorter(const std::string& camera) : cameraName(camera), written(0), skipped(0) {}
+    
+    // Must be called before loadCalibration(); the frames are then image_00 frames
+    void setStereoDirectory(const std::string& rightDirectory) {
+        stereoDirectory = rightDirectory;
+    }
+    
+    bool loadCalibration() {
+        try {
+            auto& registry = kitti360::CalibrationRegistry::instance();
+            registry.setMapCacheDirectory(MAP_CACHE_DIRECTORY);
+            calibration = registry.load(CALIBRATION_DIRECTORY);
+            
+            if (cameraName == "image_00" || cameraName == "image_01") {
+                maps = registry.rectificationMaps(calibration, cameraName);
+                std::cout << "Rectifying " << cameraName << " with K, D, R_rect and P_rect from perspective.txt" << std::endl;
+            } else {
+                maps = registry.tunedMaps(calibration, cameraName);
+                if (!maps) maps = registry.undistortionMaps(calibration, cameraName);
+                std::cout << "Unwrapping " << cameraName << " fisheye frames" << std::endl;
+            }
+            
+            remap = std::make_unique<frame_pipeline::TiledRemap>(maps->map1, maps->map2, maps->inputSize, 3);
+            std::cout << "  " << maps->inputSize << " -> " << maps->outputSize << ", "
+                      << remap->tiles().size() << " remap tiles" << std::endl;
+            std::cout << "  New camera matrix:" << std::endl << maps->newCameraMatrix << std::endl;
+            
+            if (!stereoDirectory.empty()) {
+                if (cameraName != "image_00") {
+                    throw std::runtime_error("disparity is matched from image_00 against image_01");
+                }
+                stereoMaps = registry.rectificationMaps(calibration, "image_01");
+                stereoRemap = std::make_unique<frame_pipeline::TiledRemap>(
+                    stereoMaps->map1, stereoMaps->map2, stereoMaps->inputSize, 3);
+                std::cout << "Matching against image_01 frames from " << stereoDirectory << ", "
+                          << disparitySettings.numDisparities << " disparities at full resolution" << std::endl;
+            }
+            return true;
+            
+        } catch (const std::exception& e) {
+            std::cerr << "✗ Failed to load calibration of " << cameraName << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+    
+    // Frames are read in batches with every read in flight at once, and the next batch is
+    // read while the current one is decoded, remapped and written by OpenCV's worker threads
+    bool processDirectory(const std::string& inputDirectory, const std::string& outputDirectory) {
+        std::vector<std::string> filenames;
+        for (const auto& entry : fs::directory_iterator(inputDirectory)) {
+            if (!entry.is_regular_file()) continue;
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (extension == ".jpg" || extension == ".jpeg" || extension == ".png") {
+                filenames.push_back(entry.path().string());
+            }
+        }
+        std::sort(filenames.begin(), filenames.end());
+        if (filenames.empty()) {
+            std::cerr << "✗ No images found in " << inputDirectory << std::endl;
+            return false;
+        }
+        fs::create_directories(outputDirectory);
+        
+        frame_pipeline::BatchFileReader reader(static_cast<unsigned>(BATCH_FRAMES));
+        std::cout << "Processing " << filenames.size() << " frames (reader backend: " << reader.backendName() << ")" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        
+        auto readBatch = [&](size_t first) {
+            std::vector<std::string> batch(filenames.begin() + first,
+                                           filenames.begin() + std::min(first + BATCH_FRAMES, filenames.size()));
+            // Disparity mode reads the image_01 frame of each image_00 frame in the same batch
+            size_t count = batch.size();
+            if (!stereoDirectory.empty()) {
+                for (size_t i = 0; i < count; ++i) {
+                    batch.push_back((fs::path(stereoDirectory) / fs::path(batch[i]).filename()).string());
+                }
+            }
+            std::vector<cv::Mat> contents(batch.size());
+            reader.readFiles(batch, [&](size_t i, const cv::Mat& encoded) { contents[i] = encoded; });
+            return contents;
+        };
+        
+        std::future<std::vector<cv::Mat>> next = std::async(std::launch::async, readBatch, 0);
+        for (size_t first = 0; first < filenames.size(); first += BATCH_FRAMES) {
+            std::vector<cv::Mat> batch = next.get();
+            if (first + BATCH_FRAMES < filenames.size()) {
+                next = std::async(std::launch::async, readBatch, first + BATCH_FRAMES);
+            }
+            
+            size_t count = std::min(BATCH_FRAMES, filenames.size() - first);
+            cv::parallel_for_(cv::Range(0, static_cast<int>(count)), [&](const cv::Range& range) {
+                for (int i = range.start; i < range.end; ++i) {
+                    if (stereoDirectory.empty()) {
+                        processFrame(batch[i], filenames[first + i], outputDirectory);
+                    } else {
+                        processStereoPair(batch[i], batch[count + i], filenames[first + i], outputDirectory);
+                    }
+                }
+            });
+            
+            size_t done = std::min(first + BATCH_FRAMES, filenames.size());
+            if (done / 500 > first / 500 || done == filenames.size()) {
+                std::cout << "  " << done << "/" << filenames.size() << " frames" << std::endl;
+            }
+        }
+        
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "✓ Wrote " << written << " frames to " << outputDirectory << " in " << seconds << " s ("
+                  << (seconds > 0.0 ? written / seconds : 0.0) << " frames/s)";
+        if (skipped) {
+            std::cout << ", skipped " << skipped << " unreadable or differently sized frames";
+        }
+        std::cout << std::endl;
+        return true;
+    }
+    
+private:
+    static cv::Mat decodeFrame(const cv::Mat& encoded) {
+        cv::Mat image;
+        if (!encoded.empty() && frame_pipeline::isPng(encoded.data, encoded.total())) {
+            image = frame_pipeline::decodePng(encoded, 3);
+        } else if (!encoded.empty() && frame_pipeline::isJpeg(encoded.data, encoded.total())) {
+            image = frame_pipeline::decodeJpegImage(encoded, 3);
+        }
+        if (image.empty() && !encoded.empty()) {
+            image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+        }
+        return image;
+    }
+    
+    static std::string outputPath(const std::string& outputDirectory, const std::string& filename) {
+        return (fs::path(outputDirectory) / (fs::path(filename).stem().string() + ".png")).string();
+    }
+    
+    void processFrame(const cv::Mat& encoded, const std::string& filename, const std::string& outputDirectory) {
+        cv::Mat image = decodeFrame(encoded);
+        if (image.empty() || image.size() != maps->inputSize) {
+            std::cerr << "Skipping " << filename << std::endl;
+            ++skipped;
+            return;
+        }
+        
+        // Each OpenCV worker reuses its own full-size target
+        thread_local cv::Mat output;
+        remap->apply(image, output, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+        
+        // Fast PNG compression: batch output is usually consumed by further processing
+        std::string path = outputPath(outputDirectory, filename);
+        if (!cv::imwrite(path, output, {cv::IMWRITE_PNG_COMPRESSION, 1})) {
+            std::cerr << "Unable to write " << path << std::endl;
+            ++skipped;
+            return;
+        }
+        ++written;
+    }
+    
+    // Rectify both frames at full resolution and write the left disparity as a 16-bit PNG
+    // in the KITTI convention: disparity * 256, 0 where unknown
+    void processStereoPair(const cv::Mat& leftEncoded, const cv::Mat& rightEncoded, const std::string& filename,
+                           const std::string& outputDirectory) {
+        cv::Mat left = decodeFrame(leftEncoded);
+        cv::Mat right = decodeFrame(rightEncoded);
+        if (left.empty() || right.empty() || left.size() != maps->inputSize || right.size() != stereoMaps->inputSize) {
+            std::cerr << "Skipping " << filename << std::endl;
+            ++skipped;
+            return;
+        }
+        
+        thread_local cv::Mat leftRectified, rightRectified;
+        remap->apply(left, leftRectified, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+        stereoRemap->apply(right, rightRectified, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+        cv::Mat disparity = frame_pipeline::computeDisparity(leftRectified, rightRectified, disparitySettings);
+        
+        cv::Mat output;
+        disparity.convertTo(output, CV_16U, 256.0 / 16.0);
+        output.setTo(0, disparity < 0);
+        
+        std::string path = outputPath(outputDirectory, filename);
+        if (!cv::imwrite(path, output, {cv::IMWRITE_PNG_COMPRESSION, 1})) {
+            std::cerr << "Unable to write " << path << std::endl;
+            ++skipped;
+            return;
+        }
+        ++written;
+    }
+};
+
+// KITTI-360 camera name (image_00 ... image_03) in a path like .../image_00/data_raw, or empty
+std::string cameraNameFromPath(const std::string& directory) {
+    for (const fs::path& part : fs::path(directory)) {
+        std::string name = part.string();
+        if (name.size() == 8 && name.compare(0, 7, "image_0") == 0 && name[7] >= '0' && name[7] <= '3') {
+            return name;
+        }
+    }
+    return "";
+}
+
+int main(int argc, char* argv[]) {
+    cv::Mat::setDefaultAllocator(frame_pipeline::BufferPool::instance().matAllocator());
+    
+    std::string cameraName;
+    std::string stereoDirectory;
+    std::vector<std::string> directories;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--camera" && i + 1 < argc) {
+            cameraName = argv[++i];
+        } else if (argument == "--disparity" && i + 1 < argc) {
+            stereoDirectory = argv[++i];
+        } else {
+            directories.push_back(argument);
+        }
+    }
+    
+    if (directories.size() != 2) {
+        std::cerr << "Usage: " << argv[0] << " [--camera image_0X] [--disparity <image_01_directory>] <input_directory> <output_directory>" << std::endl;
+        std::cerr << "Example: " << argv[0] << " <drive>/image_00/data_raw /tmp/image_00_rect" << std::endl;
+        std::cerr << "  image_00 and image_01 are rectified, image_02 and image_03 unwrapped" << std::endl;
+        std::cerr << "  --camera     Camera of the frames, if the input path has no image_0X component" << std::endl;
+        std::cerr << "  --disparity  Write 16-bit disparity maps (disparity * 256) of image_00 against the" << std::endl;
+        std::cerr << "               image_01 frames of the same name in the given directory" << std::endl;
+        return 1;
+    }
+    
+    if (cameraName.empty()) {
+        cameraName = cameraNameFromPath(directories[0]);
+    }
+    if (cameraName.empty()) {
+        std::cerr << "Error: cannot tell the camera from " << directories[0] << ", pass --camera" << std::endl;
+        return 1;
+    }
+    
+    if (!fs::is_directory(directories[0])) {
+        std::cerr << "Error: " << directories[0] << " is not a valid directory" << std::endl;
+        return 1;
+    }
+    if (!stereoDirectory.empty() && !fs::is_directory(stereoDirectory)) {
+        std::cerr << "Error: " << stereoDirectory << " is not a valid directory" << std::endl;
+        return 1;
+    }
+    
+    BatchUndistorter undistorter(cameraName);
+    if (!stereoDirectory.empty()) {
+        undistorter.setStereoDirectory(stereoDirectory);
+    }
+    if (!undistorter.loadCalibration()) {
+        return 1;
+    }
+    
+    return undistorter.processDirectory(directories[0], directories[1]) ? 0 : 1;
+}
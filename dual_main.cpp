@@ -1,7 +1,21 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <opencv2/opencv.hpp>
-#include "kitti360_calibration/load_calibration.h"
+#include "kitti360_calibration/bboxes.h"
+#include "kitti360_calibration/calibration_registry.h"
+#include "kitti360_calibration/calibration_watcher.h"
+#include "kitti360_calibration/poses.h"
+#include "frame_pipeline/batch_reader.h"
+#include "frame_pipeline/buffer_pool.h"
+#include "frame_pipeline/disparity.h"
+#include "frame_pipeline/filmstrip_atlas.h"
+#include "frame_pipeline/frame_cache.h"
+#include "frame_pipeline/frame_convert.h"
+#include "frame_pipeline/jpeg_decoder.h"
+#include "frame_pipeline/png_decoder.h"
+#include "frame_pipeline/sequence_index.h"
+#include "frame_pipeline/thumbnails.h"
+#include "frame_pipeline/tiled_remap.h"
 #include <iostream>
 #include <vector>
 #include <string>
@@ -13,83 +27,289 @@
 #include <atomic>
 #include <chrono>
 #include <set>
+#include <map>
+#include <deque>
+#include <condition_variable>
+#include <cstdlib>
+#include <cmath>
+#include <iomanip>
 
 namespace fs = std::filesystem;
 
-struct StereoImageData {
-    // Left eye data
-    SDL_Texture* leftTexture;
-    SDL_Surface* leftSurface;
-    std::string leftFilename;
-    std::atomic<bool> leftSurfaceLoaded;
-    std::atomic<bool> leftTextureCreated;
-    
-    // Right eye data
-    SDL_Texture* rightTexture;
-    SDL_Surface* rightSurface;
-    std::string rightFilename;
-    std::atomic<bool> rightSurfaceLoaded;
-    std::atomic<bool> rightTextureCreated;
-    
-    // Common data
-    std::string baseName; // e.g., "0000007667"
-    
-    StereoImageData() : leftTexture(nullptr), leftSurface(nullptr), leftSurfaceLoaded(false), leftTextureCreated(false),
-                        rightTexture(nullptr), rightSurface(nullptr), rightSurfaceLoaded(false), rightTextureCreated(false) {}
-    
-    ~StereoImageData() {
-        if (leftTexture) {
-            SDL_DestroyTexture(leftTexture);
-        }
-        if (leftSurface) {
-            SDL_FreeSurface(leftSurface);
-        }
-        if (rightTexture) {
-            SDL_DestroyTexture(rightTexture);
-        }
-        if (rightSurface) {
-            SDL_FreeSurface(rightSurface);
+// How the frames of a camera are turned into display frames
+enum class CameraProcessing {
+    Unwrap,  // Fisheye (image_02/03): ultra-flat unwrap through the registry's undistortion maps
+    Rectify, // Perspective (image_00/01): undistort with K/D and rectify with R_rect/P_rect
+    None     // Uncalibrated: only scaled for display
+};
+
+// One camera stream of the frame sets
+struct CameraStream {
+    std::string name;      // e.g., "image_02"
+    std::string directory;
+    CameraProcessing processing;
+};
+
+// Display projection of one camera
+struct CameraProjection {
+    std::shared_ptr<const kitti360::UndistortionMaps> maps;    // Null for uncalibrated cameras
+    std::shared_ptr<const frame_pipeline::TiledRemap> remap;   // Cache-blocked traversal of maps
+};
+
+// Undistortion maps in use, swapped atomically when the calibration is reloaded
+struct UndistortionState {
+    std::vector<CameraProjection> cameras; // Indexed like the viewer's camera streams
+    uint64_t generation;                   // Incremented on every swap
+};
+
+// Frames of all cameras taken together, loaded and cached as one unit
+struct FrameSet {
+    std::vector<std::string> filenames; // One per camera stream
+    std::string baseName;               // First camera's file stem, e.g., "0000007667"
+    int64_t timestamp;                  // First camera's timestamp in nanoseconds, 0 if matched by name
+};
+
+// 4x4 transform of a 3x3 rotation (e.g., R_rect_XX)
+cv::Matx44d rotationTransform(const cv::Mat& rotation) {
+    cv::Matx44d transform = cv::Matx44d::eye();
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            transform(row, column) = rotation.at<double>(row, column);
         }
     }
+    return transform;
+}
+
+// Projected edge of an annotated 3D box, in pixels of the camera's maps' output
+struct BoxEdge {
+    cv::Point2f from;
+    cv::Point2f to;
+    bool dynamic; // Edge of a moving object
 };
 
-class StereoFisheyeViewer {
+// KITTI-360 camera name (image_00 ... image_03) in a path like .../image_02/data_rgb, or empty
+std::string cameraNameFromPath(const std::string& directory) {
+    for (const fs::path& part : fs::path(directory)) {
+        std::string name = part.string();
+        if (name.size() == 8 && name.compare(0, 7, "image_0") == 0 && name[7] >= '0' && name[7] <= '3') {
+            return name;
+        }
+    }
+    return "";
+}
+
+CameraProcessing cameraProcessing(const std::string& cameraName) {
+    if (cameraName == "image_02" || cameraName == "image_03") return CameraProcessing::Unwrap;
+    if (cameraName == "image_00" || cameraName == "image_01") return CameraProcessing::Rectify;
+    return CameraProcessing::None;
+}
+
+class MultiCameraViewer {
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
-    std::vector<std::unique_ptr<StereoImageData>> stereoPairs;
-    int currentIndex;
+    std::vector<CameraStream> cameras; // Shown in a grid, in this order
+    std::vector<FrameSet> frameSets;
+    std::atomic<int> currentIndex;
     int windowWidth, windowHeight;
-    bool running;
-    
-    // Calibration and undistortion
-    kitti360::FisheyeParams leftCameraParams;  // image_02
-    kitti360::FisheyeParams rightCameraParams; // image_03
-    cv::Mat leftCameraMatrix, leftDistCoeffs;
-    cv::Mat rightCameraMatrix, rightDistCoeffs;
-    cv::Mat leftMapX, leftMapY, rightMapX, rightMapY;
-    cv::Size outputImageSize;  // Size for the unwrapped output images
-    cv::Size displayImageSize; // Size for screen-friendly display
+    std::atomic<bool> running;
+    
+    // Layout of cached frames and display textures (BGR, YUV 4:2:0 at half the bytes, or gray at a third)
+    frame_pipeline::FrameFormat frameFormat;
+    std::vector<uchar> neutralChroma; // Constant U/V planes for showing gray frames through IYUV textures
+    
+    // Renderer-native packed format BGR display frames are converted to on the workers,
+    // so texture uploads are plain copies (textureConversion is -1 if BGR24 is used as is)
+    Uint32 textureFormat;
+    int textureConversion;
+    
+    // Textures of the displayed frame set, refreshed from the frame cache when it changes
+    // (one per grid view: the cameras, then the disparity view if shown)
+    std::vector<SDL_Texture*> cameraTextures;
+    std::vector<bool> cameraTextureValid;
+    std::atomic<bool> displayDirty;
+    
+    // Disparity of the rectified image_00/image_01 pair (--disparity), matched at reduced
+    // resolution by the prefetch workers and cached in the undistorted tier like a camera frame
+    bool disparityEnabled;
+    int disparityCameras[2]; // Indices of the left and right camera
+    frame_pipeline::DisparitySettings disparitySettings;
+    
+    // Calibration and undistortion (shared through the calibration registry)
+    const std::string CALIBRATION_DIRECTORY = "kitti360_calibration";
+    const std::string MAP_CACHE_DIRECTORY = "kitti360_calibration/map_cache";
+    const std::string SEQUENCE_CACHE_DIRECTORY = "kitti360_calibration/map_cache"; // Sequence indexes live next to the maps
+    std::shared_ptr<const kitti360::CalibrationSnapshot> calibration; // Accessed with std::atomic_load/store
+    std::shared_ptr<const UndistortionState> undistortion; // Accessed with std::atomic_load/store
     bool calibrationLoaded;
+    kitti360::CalibrationWatcher calibrationWatcher;
     
-    // Background loading
-    std::vector<std::thread> backgroundLoaders;
-    std::mutex imagesMutex;
-    std::atomic<bool> backgroundLoadingComplete;
-    std::atomic<size_t> nextImageToLoad;
-    const int INITIAL_LOAD_COUNT = 10;
+    // Tiered frame cache: encoded files keep the sequence in RAM, raw decodes let
+    // calibration changes re-undistort without decoding, undistorted frames are uploaded as is
+    const size_t ENCODED_CACHE_BUDGET_BYTES = 4096ull << 20;
+    const size_t RAW_CACHE_BUDGET_BYTES = 1024ull << 20;
+    const size_t UNDISTORTED_CACHE_BUDGET_BYTES = 512ull << 20;
+    frame_pipeline::TieredFrameCache frameCache;
+    std::thread sequenceReader; // Reads encoded files of the whole sequence in order
+    bool mappedInput;           // Encoded files are memory-mapped instead of copied (--mmap)
+    
+    // Prefetch workers fill the cache around the current frame set, nearest first.
+    // A frame set is one unit of work: every camera's frame is prepared by the same worker.
+    std::vector<std::thread> prefetchWorkers;
+    std::mutex prefetchMutex;
+    std::condition_variable prefetchCondition;
+    std::deque<size_t> prefetchQueue;
+    std::set<size_t> prefetchInFlight; // Frame sets being prepared (guarded by prefetchMutex)
+    std::set<size_t> readaheadIssued;  // Queued frame sets whose files were advised (guarded by prefetchMutex)
+    const int PREFETCH_RADIUS = 10;
     const int NUM_LOADING_THREADS = 4;
+    const size_t READAHEAD_SETS = 8;  // Queued frame sets whose files are read ahead of decoding
+    const size_t SEQUENCE_BATCH_SETS = 16; // Frame sets the sequence reader has in flight at once
+    const double DISPLAY_MAX_WIDTH = 800.0; // Width display frames are scaled down to
+    
+    // Pose-indexed navigation: the drive's trajectory, where each frame set lies on it,
+    // and the outline drawn in the minimap
+    std::string poseFile;
+    std::unique_ptr<kitti360::PoseTrack> poseTrack;
+    std::vector<long> frameSetPoses;      // Pose index of each frame set, -1 before the trajectory
+    std::vector<uint32_t> frameSetFrames; // Frame number of each frame set's first camera
+    std::vector<size_t> trajectoryOutline;
+    double distanceStep;                  // Metres per up/down key press
+    bool minimapVisible;
+    const double DEFAULT_DISTANCE_STEP = 10.0;
+    const int MINIMAP_SIZE = 260;
+    const int MINIMAP_MARGIN = 12;
+    
+    // Stationary skipping (S): frame sets where the cameras moved less than minMotion since the
+    // last shown one are stepped over by navigation and never prefetched or read ahead
+    std::vector<double> frameSetMotion;  // Metres the cameras moved since the previous frame set
+    std::vector<size_t> movingFrameSets; // Frame sets shown while skipping, ascending
+    std::atomic<bool> skipStationary;    // Set only once movingFrameSets is built (workers read both)
+    bool skipStationaryAtStart;
+    double minMotion;
+    const double DEFAULT_MIN_MOTION = 0.25;
+    
+    // 3D box overlay (B): the drive's annotations, projected into the camera views whenever the
+    // frame set or the maps change rather than on every redraw
+    std::string boxFile;
+    std::unique_ptr<kitti360::BoxAnnotations> boxAnnotations;
+    std::vector<std::vector<BoxEdge>> boxEdges; // Per camera
+    std::vector<uint32_t> visibleBoxes;         // Boxes of the current frame set near the vehicle
+    int boxOverlayFrameSet;                     // Frame set and map generation boxEdges belong to
+    uint64_t boxOverlayGeneration;
+    bool boxesVisible;
+    double boxOverlayMilliseconds;              // Time spent projecting, over all frame sets
+    size_t boxOverlayUpdates;
+    const double BOX_VISIBILITY_RADIUS = 80.0;  // Metres around the vehicle boxes are drawn within
+    const double BOX_NEAR_PLANE = 0.5;          // Metres in front of the camera edges are clipped at
+    
+    // Filmstrip (F): thumbnails of the first camera around the current frame set, rendered from
+    // reduced decodes by a low-priority thread into a cache file next to the sequence index and
+    // packed into atlas textures, so the strip draws with one call per atlas page
+    std::unique_ptr<frame_pipeline::ThumbnailStore> thumbnailStore;
+    frame_pipeline::ThumbnailGenerator thumbnailGenerator;
+    frame_pipeline::FilmstripAtlas filmstrip;
+    bool filmstripVisible;
     
 public:
-    StereoFisheyeViewer() : window(nullptr), renderer(nullptr), currentIndex(0), 
-                            windowWidth(1800), windowHeight(900), running(true), 
-                            calibrationLoaded(false), backgroundLoadingComplete(false), 
-                            nextImageToLoad(0) {}
+    MultiCameraViewer() : window(nullptr), renderer(nullptr), currentIndex(0), 
+                          windowWidth(1800), windowHeight(900), running(true), 
+                          frameFormat(frame_pipeline::FrameFormat::BGR),
+                          textureFormat(SDL_PIXELFORMAT_BGR24), textureConversion(-1),
+                          displayDirty(true), disparityEnabled(false), disparityCameras{-1, -1},
+                          calibrationLoaded(false),
+                          frameCache(ENCODED_CACHE_BUDGET_BYTES, RAW_CACHE_BUDGET_BYTES, UNDISTORTED_CACHE_BUDGET_BYTES),
+                          mappedInput(false), distanceStep(DEFAULT_DISTANCE_STEP), minimapVisible(true),
+                          skipStationary(false), skipStationaryAtStart(false), minMotion(DEFAULT_MIN_MOTION),
+                          boxOverlayFrameSet(-1), boxOverlayGeneration(0), boxesVisible(true),
+                          boxOverlayMilliseconds(0.0), boxOverlayUpdates(0), filmstripVisible(true) {}
     
-    ~StereoFisheyeViewer() {
+    ~MultiCameraViewer() {
         cleanup();
     }
     
+    // Must be called before frames are loaded
+    void setFrameFormat(frame_pipeline::FrameFormat format) {
+        frameFormat = format;
+        std::cout << "Frame format: " << frame_pipeline::frameFormatName(frameFormat) << std::endl;
+        
+        // Full-range conversion shows luminance values unchanged with neutral chroma
+        if (frameFormat == frame_pipeline::FrameFormat::Gray) {
+            SDL_SetYUVConversionMode(SDL_YUV_CONVERSION_JPEG);
+        }
+    }
+    
+    // Must be called before the calibration and frames are loaded
+    void setCameras(const std::vector<CameraStream>& streams) {
+        cameras = streams;
+        cameraTextures.assign(cameras.size(), nullptr);
+        cameraTextureValid.assign(cameras.size(), false);
+        for (const CameraStream& camera : cameras) {
+            const char* processing = camera.processing == CameraProcessing::Unwrap ? "unwrapped fisheye"
+                : camera.processing == CameraProcessing::Rectify ? "rectified perspective" : "unprocessed";
+            std::cout << "Camera " << camera.name << " (" << processing << "): " << camera.directory << std::endl;
+        }
+    }
+    
+    // Must be called after setCameras() and before frames are loaded
+    void setDisparity(bool enabled) {
+        disparityCameras[0] = disparityCameras[1] = -1;
+        for (int camera = 0; camera < static_cast<int>(cameras.size()); ++camera) {
+            if (cameras[camera].processing != CameraProcessing::Rectify) continue;
+            disparityCameras[cameras[camera].name == "image_00" ? 0 : 1] = camera;
+        }
+        disparityEnabled = enabled && disparityCameras[0] >= 0 && disparityCameras[1] >= 0;
+        if (enabled && !disparityEnabled) {
+            std::cerr << "Warning: disparity needs both perspective cameras (image_00 and image_01)" << std::endl;
+        }
+        
+        // Interactive matching at half resolution: a quarter of the work of the batch tool
+        disparitySettings.scaleDenominator = 2;
+        cameraTextures.assign(viewCount(), nullptr);
+        cameraTextureValid.assign(viewCount(), false);
+        if (disparityEnabled) {
+            std::cout << "Disparity: " << cameras[disparityCameras[0]].name << "/" << cameras[disparityCameras[1]].name
+                      << ", " << disparitySettings.numDisparities << " disparities matched at 1/"
+                      << disparitySettings.scaleDenominator << " resolution" << std::endl;
+        }
+    }
+    
+    // Grid views: one per camera, then the disparity view
+    int viewCount() const {
+        return static_cast<int>(cameras.size()) + (disparityEnabled ? 1 : 0);
+    }
+    
+    bool showsDisparity() const {
+        return disparityEnabled;
+    }
+    
+    int disparityView() const {
+        return static_cast<int>(cameras.size());
+    }
+    
+    // Pose file to navigate by; found next to the drive's frames if not set
+    void setPoseFile(const std::string& filename) {
+        poseFile = filename;
+    }
+    
+    void setBoxFile(const std::string& filename) {
+        boxFile = filename;
+    }
+    
+    // Must be called before frames are loaded
+    // Skipping can only start once the poses are loaded
+    void setStationarySkipping(bool enabled, double metres) {
+        skipStationaryAtStart = enabled;
+        minMotion = metres;
+    }
+    
+    void setMappedInput(bool mapped) {
+        mappedInput = mapped;
+        if (mappedInput) {
+            std::cout << "Frame input: memory-mapped files (decoded in place, page cache shared)" << std::endl;
+        }
+    }
+    
     bool initialize() {
         if (SDL_Init(SDL_INIT_VIDEO) < 0) {
             std::cerr << "SDL could not initialize! SDL Error: " << SDL_GetError() << std::endl;
@@ -101,7 +321,11 @@ public:
             return false;
         }
         
-        window = SDL_CreateWindow("Ultra-Flat Dual Fisheye Unwrapped Viewer (Screen-Scaled) - Left & Right",
+        std::string title = "KITTI-360 Camera Viewer (Screen-Scaled) -";
+        for (const CameraStream& camera : cameras) {
+            title += " " + camera.name;
+        }
+        window = SDL_CreateWindow(title.c_str(),
                                   SDL_WINDOWPOS_CENTERED,
                                   SDL_WINDOWPOS_CENTERED,
                                   windowWidth, windowHeight,
@@ -119,587 +343,1147 @@ public:
         }
         
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        chooseTextureFormat();
         
         return true;
     }
     
+    // Pick the renderer's preferred 32-bit texture format, if OpenCV can produce its byte order
+    void chooseTextureFormat() {
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(renderer, &info) == 0) {
+            bool littleEndian = SDL_BYTEORDER == SDL_LIL_ENDIAN;
+            for (Uint32 i = 0; i < info.num_texture_formats && textureConversion < 0; ++i) {
+                Uint32 format = info.texture_formats[i];
+                if (format == SDL_PIXELFORMAT_BGRA32 || (littleEndian && format == SDL_PIXELFORMAT_RGB888)) {
+                    textureFormat = format;
+                    textureConversion = cv::COLOR_BGR2BGRA;
+                } else if (format == SDL_PIXELFORMAT_RGBA32 || (littleEndian && format == SDL_PIXELFORMAT_BGR888)) {
+                    textureFormat = format;
+                    textureConversion = cv::COLOR_BGR2RGBA;
+                }
+            }
+        }
+        std::cout << "Texture format: " << SDL_GetPixelFormatName(textureFormat) << std::endl;
+    }
+    
+    // Convert a BGR display frame to the texture format on the calling worker thread
+    cv::Mat toTextureLayout(const cv::Mat& bgr) {
+        if (textureConversion < 0 || bgr.empty()) {
+            return bgr;
+        }
+        cv::Mat native;
+        cv::cvtColor(bgr, native, textureConversion);
+        return native;
+    }
+    
     bool loadCalibration() {
         try {
-            std::cout << "=== LOADING DUAL FISHEYE CALIBRATION PARAMETERS ===" << std::endl;
+            std::cout << "=== LOADING CAMERA CALIBRATION PARAMETERS ===" << std::endl;
             
-            // Load fisheye parameters for left (image_02) and right (image_03) cameras
-            leftCameraParams = kitti360::loadFisheyeParams("kitti360_calibration/image_02.yaml");
-            rightCameraParams = kitti360::loadFisheyeParams("kitti360_calibration/image_03.yaml");
+            // Fisheye parameters come from image_02.yaml / image_03.yaml, perspective ones from perspective.txt
+            auto& registry = kitti360::CalibrationRegistry::instance();
+            registry.setMapCacheDirectory(MAP_CACHE_DIRECTORY);
+            auto snapshot = registry.load(CALIBRATION_DIRECTORY);
+            std::atomic_store(&calibration, snapshot);
             
             std::cout << "✓ Successfully loaded calibration files" << std::endl;
-            std::cout << "Left camera (image_02): " << leftCameraParams.camera_name << std::endl;
-            std::cout << "  Image size: " << leftCameraParams.image_width << "x" << leftCameraParams.image_height << std::endl;
-            std::cout << "  Xi: " << leftCameraParams.xi << std::endl;
-            std::cout << "  Distortion: k1=" << leftCameraParams.distortion[0] << ", k2=" << leftCameraParams.distortion[1] 
-                      << ", p1=" << leftCameraParams.distortion[2] << ", p2=" << leftCameraParams.distortion[3] << std::endl;
-            
-            std::cout << "Right camera (image_03): " << rightCameraParams.camera_name << std::endl;
-            std::cout << "  Image size: " << rightCameraParams.image_width << "x" << rightCameraParams.image_height << std::endl;
-            std::cout << "  Xi: " << rightCameraParams.xi << std::endl;
-            std::cout << "  Distortion: k1=" << rightCameraParams.distortion[0] << ", k2=" << rightCameraParams.distortion[1] 
-                      << ", p1=" << rightCameraParams.distortion[2] << ", p2=" << rightCameraParams.distortion[3] << std::endl;
-            
-            // Convert fisheye parameters to OpenCV format
-            setupCameraMatrices();
+            printCalibratedCameras(*snapshot);
             
             // Create undistortion maps with wider output format
-            createUndistortionMaps();
+            std::atomic_store(&undistortion, createUndistortionMaps(snapshot, 1));
             
             calibrationLoaded = true;
-            std::cout << "✓ Dual camera calibration loaded and undistortion maps created successfully!" << std::endl;
+            std::cout << "✓ Camera calibration loaded and undistortion maps created successfully!" << std::endl;
             std::cout << "==================================================================" << std::endl;
             return true;
             
         } catch (const std::exception& e) {
-            std::cerr << "✗ CRITICAL ERROR: Failed to load dual calibration: " << e.what() << std::endl;
-            std::cerr << "✗ Make sure both kitti360_calibration/image_02.yaml and image_03.yaml exist" << std::endl;
+            std::cerr << "✗ CRITICAL ERROR: Failed to load camera calibration: " << e.what() << std::endl;
+            std::cerr << "✗ Make sure kitti360_calibration/ has image_02.yaml and image_03.yaml for the fisheye cameras "
+                      << "and perspective.txt for image_00 and image_01" << std::endl;
             calibrationLoaded = false;
             return false;
         }
     }
     
-    void setupCameraMatrices() {
-        // Setup left camera matrix from fisheye parameters
-        leftCameraMatrix = cv::Mat::eye(3, 3, CV_64F);
-        leftCameraMatrix.at<double>(0, 0) = leftCameraParams.projection[0]; // gamma1 (fx)
-        leftCameraMatrix.at<double>(1, 1) = leftCameraParams.projection[1]; // gamma2 (fy)
-        leftCameraMatrix.at<double>(0, 2) = leftCameraParams.projection[2]; // u0 (cx)
-        leftCameraMatrix.at<double>(1, 2) = leftCameraParams.projection[3]; // v0 (cy)
-        
-        // Setup right camera matrix from fisheye parameters
-        rightCameraMatrix = cv::Mat::eye(3, 3, CV_64F);
-        rightCameraMatrix.at<double>(0, 0) = rightCameraParams.projection[0]; // gamma1 (fx)
-        rightCameraMatrix.at<double>(1, 1) = rightCameraParams.projection[1]; // gamma2 (fy)
-        rightCameraMatrix.at<double>(0, 2) = rightCameraParams.projection[2]; // u0 (cx)
-        rightCameraMatrix.at<double>(1, 2) = rightCameraParams.projection[3]; // v0 (cy)
-        
-        std::cout << "Left camera matrix:" << std::endl << leftCameraMatrix << std::endl;
-        std::cout << "Right camera matrix:" << std::endl << rightCameraMatrix << std::endl;
-        
-        // For fisheye model, use ALL 4 distortion parameters from calibration
-        // Map MEI model parameters to OpenCV fisheye model: k1, k2, p1->k3, p2->k4
-        leftDistCoeffs = cv::Mat::zeros(4, 1, CV_64F);
-        leftDistCoeffs.at<double>(0) = leftCameraParams.distortion[0]; // k1
-        leftDistCoeffs.at<double>(1) = leftCameraParams.distortion[1]; // k2
-        leftDistCoeffs.at<double>(2) = leftCameraParams.distortion[2]; // k3 (was p1)
-        leftDistCoeffs.at<double>(3) = leftCameraParams.distortion[3]; // k4 (was p2)
-        
-        rightDistCoeffs = cv::Mat::zeros(4, 1, CV_64F);
-        rightDistCoeffs.at<double>(0) = rightCameraParams.distortion[0]; // k1
-        rightDistCoeffs.at<double>(1) = rightCameraParams.distortion[1]; // k2
-        rightDistCoeffs.at<double>(2) = rightCameraParams.distortion[2]; // k3 (was p1)
-        rightDistCoeffs.at<double>(3) = rightCameraParams.distortion[3]; // k4 (was p2)
-        
-        std::cout << "Left distortion coefficients (k1, k2, k3, k4): " << leftDistCoeffs.t() << std::endl;
-        std::cout << "Right distortion coefficients (k1, k2, k3, k4): " << rightDistCoeffs.t() << std::endl;
-        std::cout << "Note: Using ALL calibration parameters (no zeros)" << std::endl;
-    }
-    
-    void createUndistortionMaps() {
-        cv::Size inputImageSize(leftCameraParams.image_width, leftCameraParams.image_height);
-        
-        // Create a much larger output size for the unwrapped fisheye
-        // For ultra-flat projection, we need extreme width to spread angular changes linearly
-        outputImageSize.width = static_cast<int>(inputImageSize.width * 4.0);
-        outputImageSize.height = static_cast<int>(inputImageSize.height * 2.0);
-        
-        std::cout << "Creating dual fisheye undistortion maps:" << std::endl;
-        std::cout << "  Input image size: " << inputImageSize << std::endl;
-        std::cout << "  Output image size: " << outputImageSize << " (wider for unwrapped view)" << std::endl;
-        
-        // Create new camera matrices for larger output and fisheye expansion
-        cv::Mat newLeftCameraMatrix = leftCameraMatrix.clone();
-        cv::Mat newRightCameraMatrix = rightCameraMatrix.clone();
-        
-        // Adjust principal points to center of new larger image
-        newLeftCameraMatrix.at<double>(0, 2) = outputImageSize.width / 2.0;  // cx
-        newLeftCameraMatrix.at<double>(1, 2) = outputImageSize.height / 2.0; // cy
-        newRightCameraMatrix.at<double>(0, 2) = outputImageSize.width / 2.0;  // cx
-        newRightCameraMatrix.at<double>(1, 2) = outputImageSize.height / 2.0; // cy
-        
-        // For ultra-flat projection, use much more aggressive focal length scaling
-        double expandScale = 5.0;  // Much higher for flatter projection
-        newLeftCameraMatrix.at<double>(0, 0) *= expandScale; // fx
-        newLeftCameraMatrix.at<double>(1, 1) *= expandScale; // fy
-        newRightCameraMatrix.at<double>(0, 0) *= expandScale; // fx
-        newRightCameraMatrix.at<double>(1, 1) *= expandScale; // fy
-        
-        std::cout << "Camera matrix scaling factor: " << expandScale << std::endl;
-        std::cout << "New left camera matrix:" << std::endl << newLeftCameraMatrix << std::endl;
-        std::cout << "New right camera matrix:" << std::endl << newRightCameraMatrix << std::endl;
-        
-        // Create undistortion maps for left camera using fisheye model
-        try {
-            cv::fisheye::initUndistortRectifyMap(
-                leftCameraMatrix, leftDistCoeffs, cv::Mat(),
-                newLeftCameraMatrix, outputImageSize, CV_16SC2,
-                leftMapX, leftMapY
-            );
-            std::cout << "✓ Left camera undistortion maps created successfully!" << std::endl;
-        } catch (const cv::Exception& e) {
-            std::cerr << "Left camera undistortion failed: " << e.what() << std::endl;
-            std::cerr << "Falling back to standard undistortion for left camera..." << std::endl;
-            cv::initUndistortRectifyMap(
-                leftCameraMatrix, leftDistCoeffs, cv::Mat(),
-                newLeftCameraMatrix, outputImageSize, CV_16SC2,
-                leftMapX, leftMapY
-            );
-        }
-        
-        // Create undistortion maps for right camera using fisheye model
+    void printCalibratedCameras(const kitti360::CalibrationSnapshot& snapshot) {
+        for (const CameraStream& camera : cameras) {
+            if (camera.processing == CameraProcessing::Unwrap) {
+                printCameraInfo("Fisheye camera (" + camera.name + ")", snapshot.fisheye(camera.name));
+            }
+        }
+    }
+    
+    void printCameraInfo(const std::string& label, const kitti360::FisheyeCamera& camera) {
+        const kitti360::FisheyeParams& params = camera.params;
+        std::cout << label << ": " << params.camera_name << std::endl;
+        std::cout << "  Image size: " << params.image_width << "x" << params.image_height << std::endl;
+        std::cout << "  Xi: " << params.xi << std::endl;
+        std::cout << "  Distortion: k1=" << params.distortion[0] << ", k2=" << params.distortion[1] 
+                  << ", p1=" << params.distortion[2] << ", p2=" << params.distortion[3] << std::endl;
+        std::cout << "  Camera matrix:" << std::endl << camera.cameraMatrix << std::endl;
+        std::cout << "  Distortion coefficients (k1, k2, k3, k4): " << camera.distCoeffs.t() << std::endl;
+    }
+    
+    std::shared_ptr<const UndistortionState> createUndistortionMaps(
+        const std::shared_ptr<const kitti360::CalibrationSnapshot>& snapshot, uint64_t generation) {
+        auto& registry = kitti360::CalibrationRegistry::instance();
+        auto state = std::make_shared<UndistortionState>();
+        state->generation = generation;
+        state->cameras.resize(cameras.size());
+        
+        // For ultra-flat projection: 4x width, 2x height and 5x focal length expansion
+        kitti360::UnwrapSettings settings;
+        
+        // Gray frames are remapped directly, BGR and I420 frames as BGR
+        size_t sourcePixelBytes = frameFormat == frame_pipeline::FrameFormat::Gray ? 1 : 3;
+        
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            const CameraStream& camera = cameras[i];
+            CameraProjection& projection = state->cameras[i];
+            if (camera.processing == CameraProcessing::Unwrap) {
+                // Maps tuned and exported from single_undistort take precedence. Otherwise maps are
+                // built once per camera, cached on disk and shared with any other user of the registry
+                projection.maps = registry.tunedMaps(snapshot, camera.name);
+                if (projection.maps) {
+                    std::cout << "Using tuned maps for " << camera.name << std::endl;
+                } else {
+                    projection.maps = registry.undistortionMaps(snapshot, camera.name, settings);
+                }
+            } else if (camera.processing == CameraProcessing::Rectify) {
+                // K/D undistortion and R_rect/P_rect rectification, cached on disk like the unwrap maps
+                projection.maps = registry.rectificationMaps(snapshot, camera.name);
+            } else {
+                continue;
+            }
+            
+            projection.remap = std::make_shared<frame_pipeline::TiledRemap>(
+                projection.maps->map1, projection.maps->map2, projection.maps->inputSize, sourcePixelBytes);
+            cv::Size displaySize = displayImageSize(projection.maps->outputSize);
+            std::cout << camera.name << " maps: " << projection.maps->inputSize << " -> " << projection.maps->outputSize
+                      << ", " << projection.remap->tiles().size() << " remap tiles, display size "
+                      << displaySize.width << "x" << displaySize.height << std::endl;
+            std::cout << "  New camera matrix:" << std::endl << projection.maps->newCameraMatrix << std::endl;
+        }
+        
+        std::cout << "  Fisheye camera matrix scaling factor: " << settings.focalScale << std::endl;
+        std::cout << "✓ Undistortion and rectification maps created successfully!" << std::endl;
+        return state;
+    }
+    
+    // Scale down to a screen-friendly size, keeping even dimensions so display frames stay
+    // convertible to YUV 4:2:0
+    cv::Size displayImageSize(cv::Size imageSize) const {
+        double scale = std::min(1.0, DISPLAY_MAX_WIDTH / imageSize.width); // Don't scale up
+        return cv::Size(static_cast<int>(imageSize.width * scale) & ~1, static_cast<int>(imageSize.height * scale) & ~1);
+    }
+    
+    void startCalibrationWatcher() {
+        if (!calibrationLoaded) return;
+        
+        if (calibrationWatcher.start(CALIBRATION_DIRECTORY, [this] { reloadCalibration(); })) {
+            std::cout << "Watching " << CALIBRATION_DIRECTORY << " for calibration changes" << std::endl;
+        }
+    }
+    
+    // Runs on the watcher thread: the viewer keeps displaying with the old maps meanwhile
+    void reloadCalibration() {
         try {
-            cv::fisheye::initUndistortRectifyMap(
-                rightCameraMatrix, rightDistCoeffs, cv::Mat(),
-                newRightCameraMatrix, outputImageSize, CV_16SC2,
-                rightMapX, rightMapY
-            );
-            std::cout << "✓ Right camera undistortion maps created successfully!" << std::endl;
-        } catch (const cv::Exception& e) {
-            std::cerr << "Right camera undistortion failed: " << e.what() << std::endl;
-            std::cerr << "Falling back to standard undistortion for right camera..." << std::endl;
-            cv::initUndistortRectifyMap(
-                rightCameraMatrix, rightDistCoeffs, cv::Mat(),
-                newRightCameraMatrix, outputImageSize, CV_16SC2,
-                rightMapX, rightMapY
-            );
+            auto snapshot = kitti360::CalibrationRegistry::instance().load(CALIBRATION_DIRECTORY);
+            if (snapshot == std::atomic_load(&calibration)) {
+                return; // Files were touched but their contents are unchanged
+            }
+            
+            std::cout << "=== CALIBRATION CHANGED, REBUILDING UNDISTORTION MAPS ===" << std::endl;
+            printCalibratedCameras(*snapshot);
+            
+            auto previous = std::atomic_load(&undistortion);
+            auto state = createUndistortionMaps(snapshot, previous->generation + 1);
+            std::atomic_store(&calibration, snapshot);
+            std::atomic_store(&undistortion, state);
+            std::cout << "✓ Swapped in new undistortion maps" << std::endl;
+            
+            schedulePrefetch();
+        } catch (const std::exception& e) {
+            std::cerr << "✗ Calibration reload failed, keeping previous maps: " << e.what() << std::endl;
+        }
+    }
+    
+    bool inPrefetchWindow(size_t index) const {
+        if (skipStationary) {
+            std::vector<size_t> window = prefetchWindowOrder();
+            return std::find(window.begin(), window.end(), index) != window.end();
+        }
+        int distance = static_cast<int>(index) - currentIndex.load();
+        return std::abs(distance) <= PREFETCH_RADIUS;
+    }
+    
+    // Indices of the prefetch window around the current frame set, nearest first. While
+    // skipping stationary frame sets, only the ones navigation will show are in it.
+    std::vector<size_t> prefetchWindowOrder() const {
+        std::vector<size_t> order;
+        int center = currentIndex;
+        int count = static_cast<int>(frameSets.size());
+        if (center >= 0 && center < count) {
+            order.push_back(center);
+        }
+        if (skipStationary) {
+            auto ahead = std::upper_bound(movingFrameSets.begin(), movingFrameSets.end(), static_cast<size_t>(center));
+            auto behind = std::lower_bound(movingFrameSets.begin(), movingFrameSets.end(), static_cast<size_t>(center));
+            for (int distance = 1; distance <= PREFETCH_RADIUS; ++distance) {
+                if (ahead != movingFrameSets.end()) order.push_back(*ahead++);
+                if (behind != movingFrameSets.begin()) order.push_back(*--behind);
+            }
+            return order;
+        }
+        for (int distance = 1; distance <= PREFETCH_RADIUS; ++distance) {
+            if (center + distance < count) order.push_back(center + distance);
+            if (center - distance >= 0) order.push_back(center - distance);
+        }
+        return order;
+    }
+    
+    // Queue frame sets in the prefetch window with a frame missing from the undistorted tier
+    // or were produced with outdated maps, nearest first
+    void schedulePrefetch() {
+        auto state = std::atomic_load(&undistortion);
+        uint64_t generation = state ? state->generation : 0;
+        
+        std::lock_guard<std::mutex> lock(prefetchMutex);
+        prefetchQueue.clear();
+        readaheadIssued.clear();
+        for (size_t index : prefetchWindowOrder()) {
+            if (prefetchInFlight.count(index) == 0 && !isFrameSetCurrent(index, generation)) {
+                prefetchQueue.push_back(index);
+            }
+        }
+        prefetchCondition.notify_all();
+    }
+    
+    bool isFrameSetCurrent(size_t index, uint64_t generation) const {
+        for (int view = 0; view < viewCount(); ++view) {
+            if (!isViewCurrent(index, view, generation)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    bool isViewCurrent(size_t index, int view, uint64_t generation) const {
+        uint64_t cachedGeneration;
+        return frameCache.undistorted.contains({index, view}, &cachedGeneration) && cachedGeneration == generation;
+    }
+    
+    void prefetchLoop() {
+        while (running) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(prefetchMutex);
+                prefetchCondition.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                    return !prefetchQueue.empty() || !running;
+                });
+                if (prefetchQueue.empty()) continue;
+                index = prefetchQueue.front();
+                prefetchQueue.pop_front();
+                prefetchInFlight.insert(index);
+            }
+            
+            // Frame sets that left the window since they were queued wait until revisited
+            if (inPrefetchWindow(index)) {
+                issueReadahead();
+                prepareFrameSet(index);
+            }
+            
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            prefetchInFlight.erase(index);
+        }
+    }
+    
+    // Start kernel readahead of the files of the next queued frame sets that are not in RAM,
+    // so their disk reads overlap this worker's decode instead of stalling the next worker
+    void issueReadahead() {
+        std::vector<size_t> upcoming;
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            for (size_t i = 0; i < prefetchQueue.size() && upcoming.size() < READAHEAD_SETS; ++i) {
+                if (readaheadIssued.insert(prefetchQueue[i]).second) {
+                    upcoming.push_back(prefetchQueue[i]);
+                }
+            }
+        }
+        
+        for (size_t index : upcoming) {
+            for (int camera = 0; camera < static_cast<int>(cameras.size()); ++camera) {
+                frame_pipeline::FrameKey key{index, camera};
+                if (!frameCache.encoded.contains(key)) {
+                    frame_pipeline::adviseWillNeed(frameFilename(key));
+                }
+            }
+        }
+    }
+    
+    // Bring every frame of a frame set up to date in the undistorted tier. Decoding only
+    // happens on a raw tier miss (from RAM when the encoded tier holds the file);
+    // reprojection reuses cached raw frames. The disparity view is matched from the
+    // full-resolution rectified frames of the stereo pair while they are at hand.
+    void prepareFrameSet(size_t index) {
+        auto state = std::atomic_load(&undistortion);
+        uint64_t generation = state ? state->generation : 0;
+        bool disparityNeeded = disparityEnabled && !isViewCurrent(index, disparityView(), generation);
+        cv::Mat rectified[2];
+        
+        for (int camera = 0; camera < static_cast<int>(cameras.size()); ++camera) {
+            frame_pipeline::FrameKey key{index, camera};
+            int stereoSide = !disparityNeeded ? -1 : camera == disparityCameras[0] ? 0 : camera == disparityCameras[1] ? 1 : -1;
+            if (stereoSide < 0 && isViewCurrent(index, camera, generation)) {
+                continue;
+            }
+            
+            cv::Mat raw;
+            if (!frameCache.raw.get(key, raw)) {
+                raw = decodeFrame(key);
+                if (raw.empty()) continue;
+                frameCache.raw.put(key, raw);
+            }
+            
+            cv::Mat* rectifiedOutput = stereoSide >= 0 ? &rectified[stereoSide] : nullptr;
+            cv::Mat display = raw;
+            if (calibrationLoaded && state) {
+                display = undistortImage(raw, camera, *state, rectifiedOutput);
+            } else if (rectifiedOutput) {
+                // Uncalibrated frames are taken as already rectified (data_rect)
+                *rectifiedOutput = frameFormat == frame_pipeline::FrameFormat::I420
+                    ? frame_pipeline::convertToBGR(raw, frameFormat) : raw;
+            }
+            if (frameFormat == frame_pipeline::FrameFormat::BGR) {
+                display = toTextureLayout(display);
+            }
+            frameCache.undistorted.put(key, display, generation);
+            
+            if (static_cast<int>(index) == currentIndex) {
+                displayDirty = true;
+            }
         }
         
-        std::cout << "✓ Dual fisheye undistortion maps created successfully!" << std::endl;
+        if (disparityNeeded && !rectified[0].empty() && !rectified[1].empty()) {
+            prepareDisparity(index, rectified[0], rectified[1], generation);
+        }
+    }
+    
+    // Match the rectified pair at reduced resolution and cache the coloured (or, in gray
+    // mode, normalized) disparity at the display size of the camera views
+    void prepareDisparity(size_t index, const cv::Mat& left, const cv::Mat& right, uint64_t generation) {
+        cv::Mat disparity;
+        try {
+            disparity = frame_pipeline::computeDisparity(left, right, disparitySettings);
+        } catch (const std::exception& e) {
+            std::cerr << "Disparity of frame set " << index << " failed: " << e.what() << std::endl;
+            return;
+        }
         
-        // Calculate display size (scale down for screen-friendly viewing)
-        double targetMaxWidth = 800.0;  // Target width for each camera view (half of total window)
-        double scale = targetMaxWidth / outputImageSize.width;
-        if (scale > 1.0) scale = 1.0;  // Don't scale up
+        int disparities = frame_pipeline::scaledDisparities(disparitySettings);
+        bool gray = frameFormat == frame_pipeline::FrameFormat::Gray;
+        cv::Mat image = gray ? frame_pipeline::disparityToGray(disparity, disparities)
+                             : frame_pipeline::colorizeDisparity(disparity, disparities);
+        
+        // Nearest neighbour keeps unknown pixels black instead of blending them into their neighbours
+        cv::Mat display;
+        cv::resize(image, display, displayImageSize(left.size()), 0, 0, cv::INTER_NEAREST);
+        if (frameFormat == frame_pipeline::FrameFormat::BGR) {
+            display = toTextureLayout(display);
+        } else if (frameFormat == frame_pipeline::FrameFormat::I420) {
+            display = frame_pipeline::convertFromBGR(display, frameFormat);
+        }
+        frameCache.undistorted.put({index, disparityView()}, display, generation);
         
-        displayImageSize.width = static_cast<int>(outputImageSize.width * scale);
-        displayImageSize.height = static_cast<int>(outputImageSize.height * scale);
+        if (static_cast<int>(index) == currentIndex) {
+            displayDirty = true;
+        }
+    }
+    
+    const std::string& frameFilename(const frame_pipeline::FrameKey& key) const {
+        return frameSets[key.frame].filenames[key.camera];
+    }
+    
+    // Compressed file contents from the encoded tier, read from disk on a miss
+    cv::Mat encodedFrame(const frame_pipeline::FrameKey& key) {
+        cv::Mat encoded;
+        if (!frameCache.encoded.get(key, encoded)) {
+            encoded = mappedInput ? frame_pipeline::mapEncodedFile(frameFilename(key))
+                                  : frame_pipeline::readEncodedFile(frameFilename(key));
+            frameCache.encoded.putIfRoom(key, encoded);
+        }
+        return encoded;
+    }
+    
+    // Decode a frame into the viewer's frame format; gray frames are decoded straight to luminance.
+    // PNGs use the pipeline's decoder, pipelined for the frame on screen so it appears sooner.
+    // JPEGs are decoded by libjpeg straight to BGR at full size, since the unwrap maps
+    // address full-resolution source pixels.
+    cv::Mat decodeFrame(const frame_pipeline::FrameKey& key) {
+        cv::Mat encoded = encodedFrame(key);
+        frame_pipeline::PngDecodeMode mode = static_cast<int>(key.frame) == currentIndex
+            ? frame_pipeline::PngDecodeMode::Pipelined : frame_pipeline::PngDecodeMode::Serial;
+        if (frameFormat != frame_pipeline::FrameFormat::Gray) {
+            cv::Mat image;
+            if (!encoded.empty() && frame_pipeline::isPng(encoded.data, encoded.total())) {
+                image = frame_pipeline::decodePng(encoded, 3, mode);
+            } else if (!encoded.empty() && frame_pipeline::isJpeg(encoded.data, encoded.total())) {
+                image = frame_pipeline::decodeJpegImage(encoded, 3);
+            }
+            if (image.empty()) {
+                image = decodeImage(encoded, frameFilename(key));
+            }
+            return frame_pipeline::convertFromBGR(image, frameFormat);
+        }
         
-        std::cout << "Display size (scaled): " << displayImageSize.width << "x" << displayImageSize.height 
-                  << " (scale=" << scale << ")" << std::endl;
+        cv::Mat gray = frame_pipeline::decodeGrayFrame(encoded, mode);
+        if (gray.empty()) {
+            std::cerr << "Unable to load image " << frameFilename(key) << std::endl;
+        }
+        return gray;
     }
     
-    SDL_Surface* undistortImage(SDL_Surface* originalSurface, bool isLeftCamera) {
-        if (!calibrationLoaded || !originalSurface) {
-            return nullptr;
+    cv::Mat decodeImage(const cv::Mat& encoded, const std::string& filename) {
+        if (encoded.empty()) {
+            std::cerr << "Unable to read image " << filename << std::endl;
+            return cv::Mat();
         }
         
-        // Convert SDL surface to OpenCV Mat
-        cv::Mat originalMat = sdlSurfaceToMat(originalSurface);
-        if (originalMat.empty()) {
-            return nullptr;
+        SDL_RWops* stream = SDL_RWFromConstMem(encoded.data, static_cast<int>(encoded.total()));
+        SDL_Surface* surface = IMG_Load_RW(stream, 1);
+        if (!surface) {
+            std::cerr << "Unable to load image " << filename << "! SDL_image Error: " << IMG_GetError() << std::endl;
+            return cv::Mat();
         }
         
-        // Create output image with the larger size for unwrapped fisheye
-        cv::Mat undistortedMatFull(outputImageSize, originalMat.type(), cv::Scalar(0, 0, 0));
+        cv::Mat image = sdlSurfaceToMat(surface);
+        SDL_FreeSurface(surface);
+        return image;
+    }
+    
+    // Read the encoded files of the whole sequence in order until the budget is used up,
+    // so scrubbing anywhere decodes from RAM. Files are read in batches with all reads of
+    // a batch in flight at once (io_uring where available); each batch starts with the
+    // prefetch window's missing files so the workers find them in RAM.
+    void readSequenceLoop() {
+        frame_pipeline::BatchFileReader reader(cameras.size() * (SEQUENCE_BATCH_SETS + 2 * PREFETCH_RADIUS + 1));
+        std::cout << "Sequence reader backend: " << (mappedInput ? "mmap" : reader.backendName()) << std::endl;
+        
+        size_t setCount = frameSets.size();
+        for (size_t first = 0; first < setCount && running; first += SEQUENCE_BATCH_SETS) {
+            size_t last = std::min(first + SEQUENCE_BATCH_SETS, setCount);
+            
+            std::vector<size_t> batch = prefetchWindowOrder();
+            std::set<size_t> window(batch.begin(), batch.end());
+            for (size_t index = first; index < last; ++index) {
+                if (window.count(index) == 0 && !isSkipped(index)) batch.push_back(index);
+            }
+            
+            std::vector<frame_pipeline::FrameKey> keys;
+            std::vector<std::string> filenames;
+            for (size_t index : batch) {
+                for (int camera = 0; camera < static_cast<int>(cameras.size()); ++camera) {
+                    frame_pipeline::FrameKey key{index, camera};
+                    if (frameCache.encoded.contains(key)) continue;
+                    keys.push_back(key);
+                    filenames.push_back(frameFilename(key));
+                }
+            }
+            
+            bool full = false;
+            auto store = [&](size_t i, const cv::Mat& encoded) {
+                if (!encoded.empty() && !frameCache.encoded.putIfRoom(keys[i], encoded)) {
+                    full = true;
+                }
+            };
+            if (mappedInput) {
+                // Mapping populates each file synchronously, so start the whole batch first
+                for (const std::string& filename : filenames) {
+                    frame_pipeline::adviseWillNeed(filename);
+                }
+                for (size_t i = 0; i < filenames.size(); ++i) {
+                    store(i, frame_pipeline::mapEncodedFile(filenames[i]));
+                }
+            } else {
+                reader.readFiles(filenames, store);
+            }
+            if (full) {
+                std::cout << "Encoded cache budget reached after " << first << "/" << setCount
+                          << " frame sets, the rest is read on demand" << std::endl;
+                return;
+            }
+            
+            if (last / 500 > first / 500) {
+                std::cout << "Encoded cache: " << last << "/" << setCount << " frame sets in RAM" << std::endl;
+            }
+        }
         
-        // Apply undistortion to larger output format
-        if (isLeftCamera) {
-            cv::remap(originalMat, undistortedMatFull, leftMapX, leftMapY, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
-        } else {
-            cv::remap(originalMat, undistortedMatFull, rightMapX, rightMapY, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+        if (running) {
+            std::cout << "Encoded cache complete! All " << setCount << " frame sets in RAM ("
+                      << (frameCache.encoded.stats().bytes >> 20) << " MB)" << std::endl;
+        }
+    }
+    
+    // Undistort or rectify a cached raw frame into a display frame, both in the viewer's frame format.
+    // Packed BGR and gray frames are remapped directly, gray with a single-channel remap. Frames
+    // that don't have the maps' input size (such as KITTI-360's already rectified data_rect
+    // perspective frames) and frames of uncalibrated cameras are only scaled. Odd-sized I420 and
+    // gray frames were padded to even, and the maps apply to their unpadded part. If rectified is
+    // given, it receives the full-resolution result (BGR or gray) for disparity matching.
+    cv::Mat undistortImage(const cv::Mat& rawFrame, int camera, const UndistortionState& state,
+                           cv::Mat* rectified = nullptr) {
+        const CameraProjection& projection = state.cameras[camera];
+        bool planar = frameFormat == frame_pipeline::FrameFormat::I420;
+        cv::Mat originalMat = planar ? frame_pipeline::convertToBGR(rawFrame, frameFormat) : rawFrame;
+        
+        // Apply undistortion to larger output format for unwrapped fisheye, tile by tile so
+        // each tile's source pixels stay in cache. The full-size target never leaves this
+        // function, so each worker thread reuses its own.
+        thread_local cv::Mat undistortedMatFull;
+        cv::Mat fullMat = originalMat;
+        if (projection.remap &&
+            originalMat.size() == frame_pipeline::convertedImageSize(projection.maps->inputSize, frameFormat)) {
+            cv::Mat source = originalMat(cv::Rect(cv::Point(), projection.maps->inputSize));
+            projection.remap->apply(source, undistortedMatFull, cv::INTER_LINEAR, cv::BORDER_CONSTANT,
+                                    cv::Scalar(0, 0, 0));
+            fullMat = undistortedMatFull;
+        }
+        if (rectified) {
+            *rectified = fullMat.clone();
         }
         
         // Scale down to display size while preserving aspect ratio
         cv::Mat undistortedMat;
-        cv::resize(undistortedMatFull, undistortedMat, displayImageSize, 0, 0, cv::INTER_AREA);
-        
-        // Convert back to SDL surface
-        return matToSdlSurface(undistortedMat);
+        cv::resize(fullMat, undistortedMat, displayImageSize(fullMat.size()), 0, 0, cv::INTER_AREA);
+        return planar ? frame_pipeline::convertFromBGR(undistortedMat, frameFormat) : undistortedMat;
     }
     
     cv::Mat sdlSurfaceToMat(SDL_Surface* surface) {
         if (!surface) return cv::Mat();
         
-        // Convert SDL surface format if needed
-        SDL_Surface* rgbSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0);
-        if (!rgbSurface) {
+        // Convert straight into a pooled BGR frame; BGR24's byte order matches OpenCV's BGR
+        cv::Mat result(surface->h, surface->w, CV_8UC3);
+        if (SDL_ConvertPixels(surface->w, surface->h, surface->format->format, surface->pixels, surface->pitch,
+                              SDL_PIXELFORMAT_BGR24, result.data, static_cast<int>(result.step)) == 0) {
+            return result;
+        }
+        
+        // Paletted surfaces need a converted copy first
+        SDL_Surface* bgrSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_BGR24, 0);
+        if (!bgrSurface) {
             std::cerr << "Failed to convert surface format: " << SDL_GetError() << std::endl;
             return cv::Mat();
         }
         
-        // Create OpenCV Mat from surface data
-        cv::Mat mat(rgbSurface->h, rgbSurface->w, CV_8UC3, rgbSurface->pixels, rgbSurface->pitch);
-        
-        // OpenCV uses BGR, SDL uses RGB, so convert
-        cv::Mat bgrMat;
-        cv::cvtColor(mat, bgrMat, cv::COLOR_RGB2BGR);
-        
         // Make a copy since we'll free the surface
-        cv::Mat result = bgrMat.clone();
+        result = cv::Mat(bgrSurface->h, bgrSurface->w, CV_8UC3, bgrSurface->pixels, bgrSurface->pitch).clone();
         
-        SDL_FreeSurface(rgbSurface);
+        SDL_FreeSurface(bgrSurface);
         return result;
     }
     
-    SDL_Surface* matToSdlSurface(const cv::Mat& mat) {
-        if (mat.empty()) return nullptr;
+    // Join the cameras' frames into frame sets by timestamps.txt (or by file name when a camera
+    // has none) through the sequence index, which is cached so long drives open without
+    // listing and parsing every directory again
+    bool loadFrameSets() {
+        frame_pipeline::SequenceIndex index;
+        std::vector<std::string> directories;
+        for (const CameraStream& camera : cameras) {
+            directories.push_back(camera.directory);
+        }
+        try {
+            auto start = std::chrono::steady_clock::now();
+            index = frame_pipeline::loadSequenceIndex(directories, frame_pipeline::DEFAULT_SYNC_TOLERANCE_NS,
+                                                      SEQUENCE_CACHE_DIRECTORY);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << (index.fromCache ? "Read sequence index from cache" : "Built sequence index") << " in "
+                      << std::fixed << std::setprecision(1) << milliseconds << " ms" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error indexing the camera directories: " << e.what() << std::endl;
+            return false;
+        }
         
-        // Convert BGR to RGB
-        cv::Mat rgbMat;
-        cv::cvtColor(mat, rgbMat, cv::COLOR_BGR2RGB);
+        frameSets.clear();
+        frameSets.reserve(index.frameSets.size());
+        for (frame_pipeline::SequenceFrameSet& indexed : index.frameSets) {
+            FrameSet frameSet;
+            frameSet.filenames = std::move(indexed.filenames);
+            frameSet.baseName = std::move(indexed.baseName);
+            frameSet.timestamp = indexed.timestamp;
+            frameSets.push_back(std::move(frameSet));
+        }
         
-        // Create SDL surface
-        SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(
-            rgbMat.data, rgbMat.cols, rgbMat.rows, 24, rgbMat.step,
-            0x000000FF, 0x0000FF00, 0x00FF0000, 0
-        );
+        if (frameSets.empty()) {
+            std::cerr << "No matching frame sets found between directories" << std::endl;
+            return false;
+        }
         
-        if (!surface) {
-            std::cerr << "Failed to create SDL surface: " << SDL_GetError() << std::endl;
-            return nullptr;
+        std::cout << "Found " << frameSets.size() << " frame sets across " << cameras.size() << " cameras, matched by "
+                  << (index.timestampSynchronized ? "timestamp" : "file name");
+        for (size_t camera = 0; camera < cameras.size(); ++camera) {
+            std::cout << (camera ? ", " : " (") << cameras[camera].name << ": " << index.cameraFrames[camera];
         }
+        std::cout << " frames)" << std::endl;
         
-        // Make a copy since the original data will go out of scope
-        SDL_Surface* copy = SDL_ConvertSurface(surface, surface->format, 0);
-        SDL_FreeSurface(surface);
+        // Fill the frame cache around the first frame set and read the sequence into RAM in the background
+        startPrefetchWorkers();
+        sequenceReader = std::thread(&MultiCameraViewer::readSequenceLoop, this);
+        startThumbnails();
         
-        return copy;
+        return true;
     }
     
-    bool loadStereoPairs(const std::string& leftDir, const std::string& rightDir) {
-        std::set<std::string> leftBaseNames;
-        std::set<std::string> rightBaseNames;
+    // Open the sequence's thumbnail cache, create the atlas pages and start generating the
+    // missing thumbnails around the current frame set. Thumbnails take the first frame's aspect ratio.
+    void startThumbnails() {
+        cv::Mat encoded = encodedFrame({0, 0});
+        frame_pipeline::PngInfo png;
+        frame_pipeline::JpegInfo jpeg;
+        int frameWidth = 0, frameHeight = 0;
+        if (!encoded.empty() && frame_pipeline::readPngInfo(encoded.data, encoded.total(), png)) {
+            frameWidth = png.width;
+            frameHeight = png.height;
+        } else if (!encoded.empty() && frame_pipeline::readJpegInfo(encoded.data, encoded.total(), jpeg)) {
+            frameWidth = jpeg.width;
+            frameHeight = jpeg.height;
+        }
+        int width, height;
+        frame_pipeline::thumbnailSize(frameWidth, frameHeight, frame_pipeline::DEFAULT_THUMBNAIL_HEIGHT, width, height);
         
-        // Scan left directory
+        std::vector<std::string> frameFiles;
+        frameFiles.reserve(frameSets.size());
+        for (const FrameSet& frameSet : frameSets) {
+            frameFiles.push_back(frameSet.filenames[0]);
+        }
         try {
-            for (const auto& entry : fs::directory_iterator(leftDir)) {
-                if (entry.is_regular_file()) {
-                    std::string extension = entry.path().extension().string();
-                    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-                    
-                    if (extension == ".jpg" || extension == ".jpeg" || extension == ".png") {
-                        std::string baseName = entry.path().stem().string();
-                        leftBaseNames.insert(baseName);
-                    }
-                }
-            }
+            thumbnailStore = std::make_unique<frame_pipeline::ThumbnailStore>(frameFiles, width, height,
+                                                                              SEQUENCE_CACHE_DIRECTORY);
         } catch (const std::exception& e) {
-            std::cerr << "Error reading left directory: " << e.what() << std::endl;
-            return false;
+            std::cerr << "Filmstrip disabled: " << e.what() << std::endl;
+            return;
+        }
+        if (!filmstrip.create(renderer, *thumbnailStore)) {
+            thumbnailStore.reset();
+            return;
         }
         
-        // Scan right directory
-        try {
-            for (const auto& entry : fs::directory_iterator(rightDir)) {
-                if (entry.is_regular_file()) {
-                    std::string extension = entry.path().extension().string();
-                    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-                    
-                    if (extension == ".jpg" || extension == ".jpeg" || extension == ".png") {
-                        std::string baseName = entry.path().stem().string();
-                        rightBaseNames.insert(baseName);
-                    }
-                }
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error reading right directory: " << e.what() << std::endl;
+        const frame_pipeline::ThumbnailAtlasLayout& atlas = filmstrip.layout();
+        std::cout << "Thumbnails: " << width << "x" << height << ", " << thumbnailStore->cachedCount() << "/"
+                  << thumbnailStore->size() << (thumbnailStore->persistent() ? " cached" : " (cache unavailable)")
+                  << ", " << atlas.pages << " atlas page(s) of " << atlas.pageWidth << "x" << atlas.pageHeight
+                  << std::endl;
+        
+        // Frame sets the prefetch workers have queued or in hand come first
+        thumbnailGenerator.setCursor(static_cast<size_t>(currentIndex.load()));
+        thumbnailGenerator.start(*thumbnailStore,
+                                 [this](size_t index, uint8_t* thumbnail) { return renderThumbnail(index, thumbnail); },
+                                 [this] {
+                                     std::lock_guard<std::mutex> lock(prefetchMutex);
+                                     return !prefetchQueue.empty() || !prefetchInFlight.empty();
+                                 });
+    }
+    
+    // Thumbnail of a frame set from its first camera's raw frame (generator thread). The file
+    // comes from the encoded tier when the sequence reader has it, else it is mapped, and
+    // nothing is cached: JPEGs are decoded at down to 1/8 scale, PNGs in full, then box-filtered.
+    bool renderThumbnail(size_t index, uint8_t* thumbnail) {
+        frame_pipeline::FrameKey key{index, 0};
+        cv::Mat encoded;
+        if (!frameCache.encoded.get(key, encoded)) {
+            encoded = frame_pipeline::mapEncodedFile(frameFilename(key));
+        }
+        if (encoded.empty()) {
             return false;
         }
         
-        // Find matching pairs
-        std::vector<std::string> matchingPairs;
-        for (const auto& leftName : leftBaseNames) {
-            if (rightBaseNames.find(leftName) != rightBaseNames.end()) {
-                matchingPairs.push_back(leftName);
-            }
+        int width = thumbnailStore->width();
+        int height = thumbnailStore->height();
+        if (frame_pipeline::isJpeg(encoded.data, encoded.total()) &&
+            frame_pipeline::decodeJpegThumbnail(encoded.data, encoded.total(), thumbnail, width, height)) {
+            return true;
         }
-        
-        if (matchingPairs.empty()) {
-            std::cerr << "No matching stereo pairs found between directories" << std::endl;
+        cv::Mat image = frame_pipeline::isPng(encoded.data, encoded.total()) ? frame_pipeline::decodePng(encoded, 3)
+                                                                             : decodeImage(encoded, frameFilename(key));
+        if (image.empty()) {
+            return false;
+        }
+        frame_pipeline::downscaleToThumbnail(image.data, image.cols, image.rows, image.step, image.channels(),
+                                             thumbnail, width, height);
+        return true;
+    }
+    
+    // Load the drive's trajectory and locate every frame set on it. Frame sets are matched
+    // to poses by the frame number in their first camera's file name.
+    bool loadPoses() {
+        std::string filename = poseFile.empty() ? kitti360::findPoseFile(cameras[0].directory) : poseFile;
+        if (filename.empty()) {
+            std::cout << "No data_poses/<drive>/poses.txt found; distance navigation and minimap disabled" << std::endl;
             return false;
         }
         
-        // Sort pairs in ascending order
-        std::sort(matchingPairs.begin(), matchingPairs.end());
-        
-        // Check if we have too many pairs and ask user
-        if (matchingPairs.size() > 1000) {
-            std::cout << "\nFound " << matchingPairs.size() << " stereo pairs. This is a large dataset." << std::endl;
-            std::cout << "Loading all pairs may use significant memory and time." << std::endl;
-            std::cout << "Do you want to:" << std::endl;
-            std::cout << "  1. Load all " << matchingPairs.size() << " pairs" << std::endl;
-            std::cout << "  2. Load only the first 1000 pairs" << std::endl;
-            std::cout << "Enter your choice (1 or 2): ";
-            
-            std::string choice;
-            std::getline(std::cin, choice);
-            
-            if (choice == "2") {
-                matchingPairs.resize(1000);
-                std::cout << "Limiting to first 1000 pairs." << std::endl;
-            } else {
-                std::cout << "Loading all " << matchingPairs.size() << " pairs." << std::endl;
-            }
+        try {
+            auto start = std::chrono::steady_clock::now();
+            poseTrack = std::make_unique<kitti360::PoseTrack>(kitti360::PoseTrack::load(filename));
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "✓ Loaded " << poseTrack->size() << " poses ("
+                      << (poseTrack->source() == kitti360::PoseSource::Vehicle ? "vehicle" : "camera 0") << ", "
+                      << std::fixed << std::setprecision(1) << poseTrack->distance(poseTrack->size() - 1) / 1000.0
+                      << " km) from " << filename << " in " << milliseconds << " ms" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "✗ Failed to load poses: " << e.what() << std::endl;
+            poseTrack.reset();
+            return false;
+        }
+        if (poseTrack->empty()) {
+            poseTrack.reset();
+            return false;
         }
         
-        // Initialize stereo pair data structures
-        stereoPairs.resize(matchingPairs.size());
-        for (size_t i = 0; i < stereoPairs.size(); ++i) {
-            stereoPairs[i] = std::make_unique<StereoImageData>();
-            stereoPairs[i]->baseName = matchingPairs[i];
-            
-            // Construct full file paths (assume .png extension for now)
-            stereoPairs[i]->leftFilename = leftDir + "/" + matchingPairs[i] + ".png";
-            stereoPairs[i]->rightFilename = rightDir + "/" + matchingPairs[i] + ".png";
-            
-            // Check if files actually exist and update paths if needed
-            for (const auto& ext : {".png", ".jpg", ".jpeg"}) {
-                std::string leftPath = leftDir + "/" + matchingPairs[i] + ext;
-                std::string rightPath = rightDir + "/" + matchingPairs[i] + ext;
-                if (fs::exists(leftPath) && fs::exists(rightPath)) {
-                    stereoPairs[i]->leftFilename = leftPath;
-                    stereoPairs[i]->rightFilename = rightPath;
-                    break;
-                }
+        frameSetPoses.clear();
+        frameSetFrames.clear();
+        auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+        for (const FrameSet& frameSet : frameSets) {
+            const std::string& name = frameSet.baseName;
+            if (name.empty() || name.size() > 10 || !std::all_of(name.begin(), name.end(), isDigit)) {
+                std::cerr << "✗ Frame " << name << " has no frame number; distance navigation disabled" << std::endl;
+                poseTrack.reset();
+                return false;
             }
+            frameSetFrames.push_back(static_cast<uint32_t>(std::stoull(name)));
+            frameSetPoses.push_back(poseTrack->indexAtOrBefore(frameSetFrames.back()));
         }
         
-        std::cout << "Found " << stereoPairs.size() << " matching stereo pairs" << std::endl;
-        
-        // Load initial stereo pairs for instant access, then start background loading
-        loadInitialStereoPairs();
-        startBackgroundLoading();
+        // Half a minimap pixel of deviation is invisible
+        cv::Rect2d bounds = poseTrack->bounds();
+        trajectoryOutline = poseTrack->decimate(std::max(bounds.width, bounds.height) / MINIMAP_SIZE / 2.0);
+        std::cout << "  Minimap outline: " << trajectoryOutline.size() << " of " << poseTrack->size() << " poses" << std::endl;
         
+        buildMotionIndex();
         return true;
     }
     
-    SDL_Texture* loadImageTexture(const std::string& filename) {
-        SDL_Surface* surface = IMG_Load(filename.c_str());
-        if (!surface) {
-            std::cerr << "Unable to load image " << filename << "! SDL_image Error: " << IMG_GetError() << std::endl;
-            return nullptr;
+    // Transform from a camera's frame into the pose track's frame, false if the calibration lacks
+    // the camera. Vehicle poses carry calib_cam_to_pose.txt; camera 0 poses are in rectified image_00
+    // coordinates, so cameras are placed relative to image_00 and rotated by its R_rect.
+    bool cameraToTrack(const kitti360::CalibrationSnapshot& snapshot, const std::string& name,
+                       cv::Matx44d& transform) const {
+        auto toPose = snapshot.cameraToPose.find(name);
+        if (toPose == snapshot.cameraToPose.end()) return false;
+        transform = toPose->second;
+        if (poseTrack->source() == kitti360::PoseSource::Camera0) {
+            auto camera0 = snapshot.cameraToPose.find("image_00");
+            auto perspective0 = snapshot.perspectiveCameras.find("image_00");
+            if (camera0 == snapshot.cameraToPose.end() || perspective0 == snapshot.perspectiveCameras.end()) return false;
+            cv::Matx44d poseToCamera0 = cv::Matx44d(camera0->second).inv();
+            transform = rotationTransform(perspective0->second.rectification) * poseToCamera0 * transform;
         }
-        
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_FreeSurface(surface);
-        
-        if (!texture) {
-            std::cerr << "Unable to create texture from " << filename << "! SDL Error: " << SDL_GetError() << std::endl;
+        return true;
+    }
+    
+    // Measure how far the cameras moved between frame sets and pick the frame sets shown while
+    // skipping stationary ones
+    void buildMotionIndex() {
+        std::vector<cv::Matx44d> cameraTransforms;
+        auto snapshot = std::atomic_load(&calibration);
+        for (const CameraStream& camera : cameras) {
+            cv::Matx44d transform;
+            if (snapshot && cameraToTrack(*snapshot, camera.name, transform)) {
+                cameraTransforms.push_back(transform);
+            }
+        }
+        if (cameraTransforms.empty()) {
+            cameraTransforms.push_back(cv::Matx44d::eye()); // No calibration: the track's own frame
         }
         
-        return texture;
+        frameSetMotion = kitti360::cameraMotion(*poseTrack, frameSetFrames, cameraTransforms);
+        movingFrameSets = kitti360::selectMovingFrames(frameSetMotion, minMotion);
+        std::cout << "  Stationary skipping: " << movingFrameSets.size() << " of " << frameSets.size()
+                  << " frame sets are " << std::setprecision(2) << minMotion << " m apart" << std::endl;
+        if (skipStationaryAtStart) {
+            skipStationary = true;
+            schedulePrefetch();
+        }
     }
     
-    void loadInitialStereoPairs() {
-        size_t pairCount = stereoPairs.size();
-        size_t initialCount = std::min((size_t)INITIAL_LOAD_COUNT, pairCount);
+    // Load the drive's 3D bounding boxes; the overlay places the cameras through the poses
+    bool loadBoxes() {
+        if (!poseTrack) {
+            if (!boxFile.empty()) {
+                std::cerr << "✗ The 3D box overlay needs the drive's poses" << std::endl;
+            }
+            return false;
+        }
+        std::string filename = boxFile.empty() ? kitti360::findBoxAnnotationFile(cameras[0].directory) : boxFile;
+        if (filename.empty()) {
+            std::cout << "No data_3d_bboxes/train/<drive>.xml found; 3D box overlay disabled" << std::endl;
+            return false;
+        }
         
-        std::cout << "Loading first " << initialCount << " stereo pairs for instant access..." << std::endl;
+        try {
+            auto start = std::chrono::steady_clock::now();
+            boxAnnotations = std::make_unique<kitti360::BoxAnnotations>(kitti360::BoxAnnotations::load(filename));
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "✓ Loaded " << boxAnnotations->size() << " 3D boxes from " << filename << " in "
+                      << std::fixed << std::setprecision(1) << milliseconds << " ms" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "✗ Failed to load 3D boxes: " << e.what() << std::endl;
+            boxAnnotations.reset();
+            return false;
+        }
+        return true;
+    }
+    
+    // Project the boxes annotated in the current frame set into every calibrated camera (main thread only)
+    void updateBoxOverlay() {
+        if (!boxAnnotations || !boxesVisible) return;
+        auto state = std::atomic_load(&undistortion);
+        int current = currentIndex;
+        uint64_t generation = state ? state->generation : 0;
+        if (current == boxOverlayFrameSet && generation == boxOverlayGeneration) return;
+        boxOverlayFrameSet = current;
+        boxOverlayGeneration = generation;
+        
+        auto start = std::chrono::steady_clock::now();
+        boxEdges.assign(cameras.size(), {});
+        long pose = frameSetPoses[current];
+        auto snapshot = std::atomic_load(&calibration);
+        if (pose < 0 || !state || !snapshot) return;
+        
+        // One query around the vehicle serves all cameras; corners are relative to the annotations' origin
+        const cv::Matx44d& vehicleToWorld = poseTrack->pose(static_cast<size_t>(pose));
+        boxAnnotations->visibleBoxes(frameSetFrames[current], vehicleToWorld(0, 3), vehicleToWorld(1, 3),
+                                     BOX_VISIBILITY_RADIUS, visibleBoxes);
+        cv::Matx44d fromOrigin = cv::Matx44d::eye();
+        for (int axis = 0; axis < 3; ++axis) {
+            fromOrigin(axis, 3) = boxAnnotations->origin()[axis];
+        }
         
-        for (size_t i = 0; i < initialCount; ++i) {
-            std::cout << "Loading pair " << (i + 1) << "/" << initialCount << ": " 
-                      << stereoPairs[i]->baseName << std::endl;
-            
-            // Load left surface
-            SDL_Surface* leftSurface = IMG_Load(stereoPairs[i]->leftFilename.c_str());
-            // Load right surface
-            SDL_Surface* rightSurface = IMG_Load(stereoPairs[i]->rightFilename.c_str());
+        std::vector<cv::Point2f> segments;
+        for (size_t camera = 0; camera < cameras.size(); ++camera) {
+            const CameraProjection& projection = state->cameras[camera];
+            cv::Matx44d transform;
+            if (!projection.maps || !cameraToTrack(*snapshot, cameras[camera].name, transform)) continue;
             
-            // Apply undistortion if calibration is loaded
-            SDL_Surface* undistortedLeftSurface = nullptr;
-            SDL_Surface* undistortedRightSurface = nullptr;
-            
-            if (calibrationLoaded) {
-                if (leftSurface) {
-                    undistortedLeftSurface = undistortImage(leftSurface, true); // true for left camera
-                    SDL_FreeSurface(leftSurface); // Free original distorted surface
-                }
-                if (rightSurface) {
-                    undistortedRightSurface = undistortImage(rightSurface, false); // false for right camera
-                    SDL_FreeSurface(rightSurface); // Free original distorted surface
-                }
-            } else {
-                // If no calibration, use original surfaces
-                undistortedLeftSurface = leftSurface;
-                undistortedRightSurface = rightSurface;
+            // Unwrapped and rectified frames are both pinhole images with the maps' new camera
+            // matrix, so edges project straight; rectified frames are also rotated by R_rect
+            cv::Matx44d worldToCamera = (vehicleToWorld * transform).inv() * fromOrigin;
+            if (cameras[camera].processing == CameraProcessing::Rectify) {
+                worldToCamera = rotationTransform(snapshot->perspective(cameras[camera].name).rectification) * worldToCamera;
             }
+            cv::Matx33d cameraMatrix = projection.maps->newCameraMatrix;
             
-            {
-                std::lock_guard<std::mutex> lock(imagesMutex);
-                
-                if (undistortedLeftSurface) {
-                    stereoPairs[i]->leftSurface = undistortedLeftSurface;
-                    stereoPairs[i]->leftSurfaceLoaded = true;
-                    
-                    // Create texture immediately for initial pairs
-                    stereoPairs[i]->leftTexture = SDL_CreateTextureFromSurface(renderer, undistortedLeftSurface);
-                    if (stereoPairs[i]->leftTexture) {
-                        stereoPairs[i]->leftTextureCreated = true;
-                    }
-                }
-                
-                if (undistortedRightSurface) {
-                    stereoPairs[i]->rightSurface = undistortedRightSurface;
-                    stereoPairs[i]->rightSurfaceLoaded = true;
-                    
-                    // Create texture immediately for initial pairs
-                    stereoPairs[i]->rightTexture = SDL_CreateTextureFromSurface(renderer, undistortedRightSurface);
-                    if (stereoPairs[i]->rightTexture) {
-                        stereoPairs[i]->rightTextureCreated = true;
-                    }
+            segments.clear();
+            for (uint32_t index : visibleBoxes) {
+                const kitti360::Box3D& box = boxAnnotations->box(index);
+                size_t first = segments.size();
+                kitti360::projectBoxEdges(box, worldToCamera, cameraMatrix, segments, BOX_NEAR_PLANE);
+                for (size_t i = first; i < segments.size(); i += 2) {
+                    boxEdges[camera].push_back({segments[i], segments[i + 1], box.dynamic});
                 }
             }
         }
         
-        // Set the next pair index for background loading
-        nextImageToLoad = initialCount;
-        
-        std::cout << "Initial " << initialCount << " stereo pairs loaded! Starting background loading..." << std::endl;
+        boxOverlayMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ++boxOverlayUpdates;
     }
     
-    void loadStereoPairInBackground(size_t index) {
-        if (index >= stereoPairs.size()) return;
-        
-        // Load surfaces (this is thread-safe)
-        SDL_Surface* leftSurface = IMG_Load(stereoPairs[index]->leftFilename.c_str());
-        SDL_Surface* rightSurface = IMG_Load(stereoPairs[index]->rightFilename.c_str());
-        
-        // Apply undistortion if calibration is loaded
-        SDL_Surface* undistortedLeftSurface = nullptr;
-        SDL_Surface* undistortedRightSurface = nullptr;
-        
-        if (calibrationLoaded) {
-            if (leftSurface) {
-                undistortedLeftSurface = undistortImage(leftSurface, true); // true for left camera
-                SDL_FreeSurface(leftSurface); // Free original distorted surface
-            }
-            if (rightSurface) {
-                undistortedRightSurface = undistortImage(rightSurface, false); // false for right camera
-                SDL_FreeSurface(rightSurface); // Free original distorted surface
-            }
-        } else {
-            // If no calibration, use original surfaces
-            undistortedLeftSurface = leftSurface;
-            undistortedRightSurface = rightSurface;
+    // Frame set the sequence reader leaves out because navigation steps over it
+    bool isSkipped(size_t index) const {
+        return skipStationary && static_cast<int>(index) != currentIndex &&
+               !std::binary_search(movingFrameSets.begin(), movingFrameSets.end(), index);
+    }
+    
+    void toggleStationarySkipping() {
+        if (!poseTrack) {
+            std::cout << "Stationary skipping needs the drive's poses" << std::endl;
+            return;
         }
-        
-        {
-            std::lock_guard<std::mutex> lock(imagesMutex);
-            
-            if (undistortedLeftSurface) {
-                stereoPairs[index]->leftSurface = undistortedLeftSurface;
-                stereoPairs[index]->leftSurfaceLoaded = true;
-            }
-            
-            if (undistortedRightSurface) {
-                stereoPairs[index]->rightSurface = undistortedRightSurface;
-                stereoPairs[index]->rightSurfaceLoaded = true;
-            }
+        skipStationary = !skipStationary;
+        std::cout << "Stationary skipping " << (skipStationary ? "on" : "off") << " (" << movingFrameSets.size()
+                  << " of " << frameSets.size() << " frame sets shown)" << std::endl;
+        schedulePrefetch();
+    }
+    
+    // Next frame set to show after (direction 1) or before (-1) the given one, or the given one
+    // at the ends of the sequence
+    int neighbourFrameSet(int index, int direction) const {
+        if (!skipStationary) {
+            int neighbour = index + direction;
+            return neighbour >= 0 && neighbour < static_cast<int>(frameSets.size()) ? neighbour : index;
+        }
+        if (direction > 0) {
+            auto after = std::upper_bound(movingFrameSets.begin(), movingFrameSets.end(), static_cast<size_t>(index));
+            return after == movingFrameSets.end() ? index : static_cast<int>(*after);
         }
+        auto before = std::lower_bound(movingFrameSets.begin(), movingFrameSets.end(), static_cast<size_t>(index));
+        return before == movingFrameSets.begin() ? index : static_cast<int>(*(before - 1));
     }
     
-    void ensureStereoTexturesCreated(size_t index) {
-        if (index >= stereoPairs.size()) return;
-        
-        std::lock_guard<std::mutex> lock(imagesMutex);
-        
-        // Create left texture if surface is loaded but texture not created
-        if (stereoPairs[index]->leftSurfaceLoaded && !stereoPairs[index]->leftTextureCreated && stereoPairs[index]->leftSurface) {
-            stereoPairs[index]->leftTexture = SDL_CreateTextureFromSurface(renderer, stereoPairs[index]->leftSurface);
-            if (stereoPairs[index]->leftTexture) {
-                stereoPairs[index]->leftTextureCreated = true;
-            }
+    // Frame set taken at a pose: the first one at or after the pose's frame
+    size_t frameSetAtPose(size_t pose) const {
+        auto match = std::lower_bound(frameSetFrames.begin(), frameSetFrames.end(), poseTrack->frame(pose));
+        return std::min(static_cast<size_t>(match - frameSetFrames.begin()), frameSets.size() - 1);
+    }
+    
+    // Step along the trajectory by a distance instead of a frame count, so stretches where the
+    // vehicle stands still are skipped. Frame sets in between are never decoded.
+    void stepDistance(double meters) {
+        if (!poseTrack) return;
+        
+        int current = currentIndex;
+        long pose = std::max(frameSetPoses[current], 0L);
+        size_t target = frameSetAtPose(poseTrack->advance(static_cast<size_t>(pose), meters));
+        if (meters > 0.0 && static_cast<int>(target) <= current) {
+            target = static_cast<size_t>(neighbourFrameSet(current, 1));
+        } else if (meters < 0.0 && static_cast<int>(target) >= current) {
+            target = static_cast<size_t>(neighbourFrameSet(current, -1));
         }
-        
-        // Create right texture if surface is loaded but texture not created
-        if (stereoPairs[index]->rightSurfaceLoaded && !stereoPairs[index]->rightTextureCreated && stereoPairs[index]->rightSurface) {
-            stereoPairs[index]->rightTexture = SDL_CreateTextureFromSurface(renderer, stereoPairs[index]->rightSurface);
-            if (stereoPairs[index]->rightTexture) {
-                stereoPairs[index]->rightTextureCreated = true;
-            }
+        jumpToFrameSet(target);
+    }
+    
+    // Jump to the frame set taken nearest to a place on the ground plane
+    void jumpToPlace(double x, double y) {
+        if (!poseTrack) return;
+        jumpToFrameSet(frameSetAtPose(poseTrack->nearest(x, y)));
+    }
+    
+    void jumpToFrameSet(size_t index) {
+        if (static_cast<int>(index) == currentIndex) return;
+        currentIndex = static_cast<int>(index);
+        onCurrentIndexChanged();
+    }
+    
+    void startPrefetchWorkers() {
+        for (int i = 0; i < NUM_LOADING_THREADS; ++i) {
+            prefetchWorkers.emplace_back(&MultiCameraViewer::prefetchLoop, this);
+        }
+        schedulePrefetch();
+    }
+    
+    // Upload the current frame set from the undistorted tier when it changed (main thread only)
+    void updateCameraTextures() {
+        if (!displayDirty.exchange(false)) return;
+        
+        for (int view = 0; view < viewCount(); ++view) {
+            cv::Mat image;
+            cameraTextureValid[view] = frameCache.undistorted.get({static_cast<size_t>(currentIndex.load()), view}, image) &&
+                                       uploadTexture(cameraTextures[view], image);
         }
     }
     
-    void backgroundLoadingFunction() {
-        size_t pairCount = stereoPairs.size();
+    // Copy a frame into a streaming texture, recreating it if the size changed. BGR-mode
+    // frames are already in the texture format; YUV and gray frames go to IYUV textures.
+    bool uploadTexture(SDL_Texture*& texture, const cv::Mat& frame) {
+        cv::Size size = frame_pipeline::frameImageSize(frame, frameFormat);
+        bool yuv = frameFormat != frame_pipeline::FrameFormat::BGR;
+        
+        int textureWidth = 0, textureHeight = 0;
+        if (texture) {
+            SDL_QueryTexture(texture, nullptr, nullptr, &textureWidth, &textureHeight);
+        }
         
-        while (running) {
-            size_t currentIndex = nextImageToLoad.fetch_add(1);
-            
-            if (currentIndex >= pairCount) {
-                break; // All pairs processed
-            }
-            
-            if (currentIndex % 50 == 0 && currentIndex >= static_cast<size_t>(INITIAL_LOAD_COUNT)) {
-                std::cout << "Background loading: " << currentIndex << "/" << pairCount << " stereo pairs loaded" << std::endl;
+        if (!texture || textureWidth != size.width || textureHeight != size.height) {
+            if (texture) SDL_DestroyTexture(texture);
+            Uint32 pixelFormat = yuv ? static_cast<Uint32>(SDL_PIXELFORMAT_IYUV) : textureFormat;
+            texture = SDL_CreateTexture(renderer, pixelFormat, SDL_TEXTUREACCESS_STREAMING, size.width, size.height);
+            if (!texture) {
+                std::cerr << "Unable to create texture! SDL Error: " << SDL_GetError() << std::endl;
+                return false;
             }
-            
-            loadStereoPairInBackground(currentIndex);
-            
-            // Small delay to not overwhelm the system
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
         }
         
-        // Check if this was the last thread to finish
-        static std::atomic<int> threadsCompleted{0};
-        int completed = threadsCompleted.fetch_add(1) + 1;
-        if (completed == NUM_LOADING_THREADS) {
-            backgroundLoadingComplete = true;
-            std::cout << "Background loading complete! All " << pairCount << " stereo pairs loaded." << std::endl;
+        if (frameFormat == frame_pipeline::FrameFormat::Gray) {
+            neutralChroma.assign(static_cast<size_t>(size.width / 2) * (size.height / 2), 128);
+            return SDL_UpdateYUVTexture(texture, nullptr, frame.data, static_cast<int>(frame.step),
+                                        neutralChroma.data(), size.width / 2, neutralChroma.data(), size.width / 2) == 0;
         }
+        if (yuv) {
+            const uchar* yPlane = frame.data;
+            const uchar* uPlane = yPlane + size.width * size.height;
+            const uchar* vPlane = uPlane + (size.width / 2) * (size.height / 2);
+            return SDL_UpdateYUVTexture(texture, nullptr, yPlane, size.width,
+                                        uPlane, size.width / 2, vPlane, size.width / 2) == 0;
+        }
+        return SDL_UpdateTexture(texture, nullptr, frame.data, static_cast<int>(frame.step)) == 0;
     }
     
-    void startBackgroundLoading() {
-        if (stereoPairs.size() > static_cast<size_t>(INITIAL_LOAD_COUNT)) {
-            // Start multiple background threads for faster loading
-            for (int i = 0; i < NUM_LOADING_THREADS; ++i) {
-                backgroundLoaders.emplace_back(&StereoFisheyeViewer::backgroundLoadingFunction, this);
-            }
-        } else {
-            backgroundLoadingComplete = true;
-        }
+    void printCacheStats() {
+        auto printTier = [](const char* name, const frame_pipeline::TierStats& stats) {
+            uint64_t lookups = stats.hits + stats.misses;
+            std::cout << "  " << name << ": " << (stats.bytes >> 20) << "/" << (stats.budgetBytes >> 20) << " MB, "
+                      << stats.entries << " frames, hit rate "
+                      << std::fixed << std::setprecision(1) << (lookups ? 100.0 * stats.hits / lookups : 0.0) << "% ("
+                      << stats.hits << "/" << lookups << "), " << stats.evictions << " evictions" << std::endl;
+        };
+        std::cout << "Frame cache:" << std::endl;
+        printTier("Encoded tier", frameCache.encoded.stats());
+        printTier("Raw tier", frameCache.raw.stats());
+        printTier("Undistorted tier", frameCache.undistorted.stats());
+        
+        frame_pipeline::BufferPoolStats pool = frame_pipeline::BufferPool::instance().stats();
+        uint64_t acquisitions = pool.hits + pool.misses;
+        std::cout << "Buffer pool: hit rate " << std::fixed << std::setprecision(1)
+                  << (acquisitions ? 100.0 * pool.hits / acquisitions : 0.0) << "% (" << pool.hits << "/" << acquisitions
+                  << "), " << (pool.pooledBytes >> 20) << " MB pooled, " << (pool.outstandingBytes >> 20)
+                  << " MB in use, " << pool.trimmed << " trimmed, " << pool.hugePageMisses
+                  << " on huge pages" << std::endl;
+    }
+    
+    // Grid of views: two cameras side by side, four in a 2x2 grid, the disparity view last
+    int gridColumns() const {
+        return static_cast<int>(std::ceil(std::sqrt(static_cast<double>(viewCount()))));
     }
     
     void render() {
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
         SDL_RenderClear(renderer);
         
-        if (currentIndex >= 0 && currentIndex < static_cast<int>(stereoPairs.size())) {
-            // Try to create textures from surfaces if available (main thread only)
-            ensureStereoTexturesCreated(currentIndex);
+        if (currentIndex >= 0 && currentIndex < static_cast<int>(frameSets.size())) {
+            // Refresh textures from the frame cache if the frame set changed (main thread only)
+            updateCameraTextures();
+            updateBoxOverlay();
             
-            std::lock_guard<std::mutex> lock(imagesMutex);
+            int columns = gridColumns();
+            int rows = (viewCount() + columns - 1) / columns;
+            int cellWidth = windowWidth / columns;
+            int cellHeight = windowHeight / rows;
             
-            // Calculate half-window width for side-by-side display
-            int halfWidth = windowWidth / 2;
-            
-            // Render left eye image
-            if (stereoPairs[currentIndex]->leftTextureCreated && stereoPairs[currentIndex]->leftTexture) {
-                renderEyeImage(stereoPairs[currentIndex]->leftTexture, 0, halfWidth);
-            } else {
-                renderLoadingMessage(0, halfWidth);
+            for (int view = 0; view < viewCount(); ++view) {
+                int x = (view % columns) * cellWidth;
+                int y = (view / columns) * cellHeight;
+                if (cameraTextureValid[view]) {
+                    SDL_Rect frameRect = renderCameraImage(cameraTextures[view], x, y, cellWidth, cellHeight);
+                    renderBoxOverlay(view, frameRect);
+                } else {
+                    renderLoadingMessage(x, y, cellWidth, cellHeight);
+                }
             }
             
-            // Render right eye image
-            if (stereoPairs[currentIndex]->rightTextureCreated && stereoPairs[currentIndex]->rightTexture) {
-                renderEyeImage(stereoPairs[currentIndex]->rightTexture, halfWidth, halfWidth);
-            } else {
-                renderLoadingMessage(halfWidth, halfWidth);
+            // Draw divider lines between the cells
+            SDL_SetRenderDrawColor(renderer, 128, 128, 128, 255);
+            for (int column = 1; column < columns; ++column) {
+                SDL_RenderDrawLine(renderer, column * cellWidth, 0, column * cellWidth, windowHeight);
+            }
+            for (int row = 1; row < rows; ++row) {
+                SDL_RenderDrawLine(renderer, 0, row * cellHeight, windowWidth, row * cellHeight);
             }
             
-            // Draw divider line between left and right
-            SDL_SetRenderDrawColor(renderer, 128, 128, 128, 255);
-            SDL_RenderDrawLine(renderer, halfWidth, 0, halfWidth, windowHeight);
+            renderMinimap();
+            renderFilmstrip();
         }
         
         SDL_RenderPresent(renderer);
     }
     
-    void renderEyeImage(SDL_Texture* texture, int xOffset, int availableWidth) {
-        if (!texture) return;
+    // Minimap in the bottom right corner above the filmstrip, trajectory scaled to fit with north up
+    struct MinimapLayout {
+        SDL_Rect rect;
+        double scale;   // Pixels per metre
+        double originX; // Screen position of the trajectory bounds' minimum x ...
+        double originY; // ... and minimum y
+    };
+    
+    MinimapLayout minimapLayout() const {
+        MinimapLayout layout;
+        int size = std::min({MINIMAP_SIZE, windowWidth / 3, windowHeight / 3});
+        int filmstripHeight = thumbnailStore && filmstripVisible ? filmstrip.rect(windowWidth, windowHeight).h : 0;
+        int bottom = windowHeight - filmstripHeight;
+        layout.rect = {windowWidth - size - MINIMAP_MARGIN, bottom - size - MINIMAP_MARGIN, size, size};
+        
+        cv::Rect2d bounds = poseTrack->bounds();
+        double inner = size - 2.0 * MINIMAP_MARGIN;
+        layout.scale = inner / std::max({bounds.width, bounds.height, 1.0});
+        layout.originX = layout.rect.x + MINIMAP_MARGIN + (inner - bounds.width * layout.scale) / 2.0;
+        layout.originY = layout.rect.y + layout.rect.h - MINIMAP_MARGIN - (inner - bounds.height * layout.scale) / 2.0;
+        return layout;
+    }
+    
+    SDL_Point minimapPoint(const MinimapLayout& layout, const cv::Vec3d& position) const {
+        cv::Rect2d bounds = poseTrack->bounds();
+        return {static_cast<int>(std::lround(layout.originX + (position[0] - bounds.x) * layout.scale)),
+                static_cast<int>(std::lround(layout.originY - (position[1] - bounds.y) * layout.scale))};
+    }
+    
+    void renderMinimap() {
+        if (!poseTrack || !minimapVisible) return;
+        
+        MinimapLayout layout = minimapLayout();
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 170);
+        SDL_RenderFillRect(renderer, &layout.rect);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        SDL_SetRenderDrawColor(renderer, 128, 128, 128, 255);
+        SDL_RenderDrawRect(renderer, &layout.rect);
+        
+        // The outline has a few hundred points however long the drive is
+        std::vector<SDL_Point> points;
+        points.reserve(trajectoryOutline.size());
+        for (size_t pose : trajectoryOutline) {
+            points.push_back(minimapPoint(layout, poseTrack->position(pose)));
+        }
+        SDL_SetRenderDrawColor(renderer, 220, 220, 220, 255);
+        SDL_RenderDrawLines(renderer, points.data(), static_cast<int>(points.size()));
+        
+        long pose = frameSetPoses[currentIndex];
+        if (pose >= 0) {
+            SDL_Point position = minimapPoint(layout, poseTrack->position(static_cast<size_t>(pose)));
+            SDL_Rect marker = {position.x - 3, position.y - 3, 7, 7};
+            SDL_SetRenderDrawColor(renderer, 255, 60, 60, 255);
+            SDL_RenderFillRect(renderer, &marker);
+        }
+    }
+    
+    // Clicks on the minimap jump to the nearest place on the trajectory
+    bool handleMinimapClick(int x, int y) {
+        if (!poseTrack || !minimapVisible) return false;
+        
+        MinimapLayout layout = minimapLayout();
+        SDL_Point click = {x, y};
+        if (!SDL_PointInRect(&click, &layout.rect)) return false;
+        
+        cv::Rect2d bounds = poseTrack->bounds();
+        jumpToPlace(bounds.x + (x - layout.originX) / layout.scale, bounds.y + (layout.originY - y) / layout.scale);
+        return true;
+    }
+    
+    // Filmstrip along the bottom of the window, over the grid; moves the generator to the current
+    // frame set and dims those stepped over while skipping stationary frame sets
+    void renderFilmstrip() {
+        if (!thumbnailStore || !filmstripVisible) return;
+        
+        size_t current = static_cast<size_t>(currentIndex.load());
+        thumbnailGenerator.setCursor(current);
+        filmstrip.render(current, windowWidth, windowHeight, [this](size_t index) { return isSkipped(index); });
+    }
+    
+    // Clicks on a filmstrip thumbnail jump to its frame set. The jump puts it first in the
+    // prefetch queue (decoded pipelined as the frame set on screen) and pauses thumbnail
+    // generation until the prefetch window is filled.
+    bool handleFilmstripClick(int x, int y) {
+        long index;
+        if (!thumbnailStore || !filmstripVisible ||
+            !filmstrip.frameAt(static_cast<size_t>(currentIndex.load()), windowWidth, windowHeight, x, y, index)) {
+            return false;
+        }
+        if (index >= 0) {
+            jumpToFrameSet(static_cast<size_t>(index));
+        }
+        return true;
+    }
+    
+    // Draw a frame fitted into a grid cell and return where it was drawn
+    SDL_Rect renderCameraImage(SDL_Texture* texture, int xOffset, int yOffset, int availableWidth, int availableHeight) {
+        if (!texture) return SDL_Rect{0, 0, 0, 0};
         
         // Get texture dimensions
         int textureWidth, textureHeight;
         SDL_QueryTexture(texture, nullptr, nullptr, &textureWidth, &textureHeight);
         
-        // Calculate scaling to fit half window while maintaining aspect ratio
+        // Calculate scaling to fit the grid cell while maintaining aspect ratio
         float scaleX = static_cast<float>(availableWidth) / textureWidth;
-        float scaleY = static_cast<float>(windowHeight) / textureHeight;
+        float scaleY = static_cast<float>(availableHeight) / textureHeight;
         float scale = std::min(scaleX, scaleY);
         
         int scaledWidth = static_cast<int>(textureWidth * scale);
@@ -707,20 +1491,51 @@ public:
         
         SDL_Rect destRect = {
             xOffset + (availableWidth - scaledWidth) / 2,
-            (windowHeight - scaledHeight) / 2,
+            yOffset + (availableHeight - scaledHeight) / 2,
             scaledWidth,
             scaledHeight
         };
         
         SDL_RenderCopy(renderer, texture, nullptr, &destRect);
+        return destRect;
     }
     
-    void renderLoadingMessage(int xOffset, int availableWidth) {
+    // Box edges over a camera's frame, scaled from the maps' output to where the frame is drawn:
+    // static objects cyan, moving ones orange
+    void renderBoxOverlay(int view, const SDL_Rect& frameRect) {
+        if (!boxAnnotations || !boxesVisible || frameRect.w == 0 || view >= static_cast<int>(boxEdges.size()) ||
+            boxEdges[view].empty()) {
+            return;
+        }
+        auto state = std::atomic_load(&undistortion);
+        if (!state || !state->cameras[view].maps) return;
+        
+        cv::Size outputSize = state->cameras[view].maps->outputSize;
+        float scaleX = static_cast<float>(frameRect.w) / outputSize.width;
+        float scaleY = static_cast<float>(frameRect.h) / outputSize.height;
+        SDL_RenderSetClipRect(renderer, &frameRect);
+        for (bool dynamic : {false, true}) {
+            if (dynamic) {
+                SDL_SetRenderDrawColor(renderer, 255, 160, 0, 255);
+            } else {
+                SDL_SetRenderDrawColor(renderer, 0, 220, 255, 255);
+            }
+            for (const BoxEdge& edge : boxEdges[view]) {
+                if (edge.dynamic != dynamic) continue;
+                SDL_RenderDrawLine(renderer,
+                                   frameRect.x + static_cast<int>(edge.from.x * scaleX), frameRect.y + static_cast<int>(edge.from.y * scaleY),
+                                   frameRect.x + static_cast<int>(edge.to.x * scaleX), frameRect.y + static_cast<int>(edge.to.y * scaleY));
+            }
+        }
+        SDL_RenderSetClipRect(renderer, nullptr);
+    }
+    
+    void renderLoadingMessage(int xOffset, int yOffset, int availableWidth, int availableHeight) {
         // Simple loading indicator - draw a white rectangle in the center of the available area
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
         SDL_Rect loadingRect = {
             xOffset + availableWidth / 2 - 100,
-            windowHeight / 2 - 25,
+            yOffset + availableHeight / 2 - 25,
             200,
             50
         };
@@ -745,10 +1560,44 @@ public:
                 case SDLK_RIGHT:
                     nextImage();
                     break;
+                case SDLK_UP:
+                    stepDistance(distanceStep);
+                    break;
+                case SDLK_DOWN:
+                    stepDistance(-distanceStep);
+                    break;
+                case SDLK_EQUALS:
+                case SDLK_PLUS:
+                case SDLK_KP_PLUS:
+                    distanceStep = std::min(distanceStep * 2.0, 1000.0);
+                    std::cout << "Distance step: " << distanceStep << " m" << std::endl;
+                    break;
+                case SDLK_MINUS:
+                case SDLK_KP_MINUS:
+                    distanceStep = std::max(distanceStep / 2.0, 1.25);
+                    std::cout << "Distance step: " << distanceStep << " m" << std::endl;
+                    break;
+                case SDLK_m:
+                    minimapVisible = !minimapVisible;
+                    break;
+                case SDLK_s:
+                    toggleStationarySkipping();
+                    break;
+                case SDLK_b:
+                    boxesVisible = !boxesVisible;
+                    boxOverlayFrameSet = -1;
+                    break;
+                case SDLK_f:
+                    filmstripVisible = !filmstripVisible;
+                    break;
                 case SDLK_ESCAPE:
                     running = false;
                     break;
             }
+        } else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
+            if (!handleFilmstripClick(e.button.x, e.button.y)) {
+                handleMinimapClick(e.button.x, e.button.y);
+            }
         } else if (e.window.event == SDL_WINDOWEVENT_RESIZED) {
             windowWidth = e.window.data1;
             windowHeight = e.window.data2;
@@ -756,15 +1605,17 @@ public:
     }
     
     void nextImage() {
-        if (currentIndex < static_cast<int>(stereoPairs.size()) - 1) {
-            currentIndex++;
-        }
+        jumpToFrameSet(neighbourFrameSet(currentIndex, 1));
     }
     
     void previousImage() {
-        if (currentIndex > 0) {
-            currentIndex--;
-        }
+        jumpToFrameSet(neighbourFrameSet(currentIndex, -1));
+    }
+    
+    // Show the new frame set as soon as it is cached and move the prefetch window with it
+    void onCurrentIndexChanged() {
+        displayDirty = true;
+        schedulePrefetch();
     }
     
     void run() {
@@ -783,15 +1634,45 @@ public:
     void cleanup() {
         running = false;
         
-        // Wait for all background loading threads to finish
-        for (auto& loader : backgroundLoaders) {
-            if (loader.joinable()) {
-                loader.join();
+        calibrationWatcher.stop();
+        thumbnailGenerator.stop();
+        
+        // Wait for the sequence reader and all prefetch threads to finish
+        if (sequenceReader.joinable()) {
+            sequenceReader.join();
+        }
+        prefetchCondition.notify_all();
+        for (auto& worker : prefetchWorkers) {
+            if (worker.joinable()) {
+                worker.join();
             }
         }
-        backgroundLoaders.clear();
         
-        stereoPairs.clear();
+        if (!prefetchWorkers.empty()) {
+            printCacheStats();
+            if (boxOverlayUpdates > 0) {
+                std::cout << "3D box overlay: " << boxOverlayUpdates << " frame sets projected, "
+                          << std::setprecision(3) << boxOverlayMilliseconds / boxOverlayUpdates << " ms each" << std::endl;
+            }
+            if (thumbnailGenerator.generatedCount() > 0) {
+                std::cout << "Thumbnails: " << thumbnailGenerator.generatedCount() << " generated, " << std::setprecision(3)
+                          << thumbnailGenerator.renderMilliseconds() / thumbnailGenerator.generatedCount() << " ms each"
+                          << std::endl;
+            }
+            prefetchWorkers.clear();
+        }
+        frameCache.encoded.clear();
+        frameCache.raw.clear();
+        frameCache.undistorted.clear();
+        
+        for (SDL_Texture*& texture : cameraTextures) {
+            if (texture) {
+                SDL_DestroyTexture(texture);
+                texture = nullptr;
+            }
+        }
+        filmstrip.destroy();
+        thumbnailStore.reset();
         
         if (renderer) {
             SDL_DestroyRenderer(renderer);
@@ -809,44 +1690,125 @@ public:
 };
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <left_directory> <right_directory>" << std::endl;
-        std::cerr << "Example: " << argv[0] << " /path/to/left/images /path/to/right/images" << std::endl;
-        return 1;
-    }
+    // Frame-sized allocations (IMG_Load surfaces, decoded, remapped and cached frames) are
+    // drawn from and returned to the buffer pool. SDL's hooks must be set before SDL allocates.
+    SDL_SetMemoryFunctions(frame_pipeline::pooledMalloc, frame_pipeline::pooledCalloc,
+                           frame_pipeline::pooledRealloc, frame_pipeline::pooledFree);
+    cv::Mat::setDefaultAllocator(frame_pipeline::BufferPool::instance().matAllocator());
     
-    std::string leftDirectory = argv[1];
-    std::string rightDirectory = argv[2];
+    frame_pipeline::FrameFormat frameFormat = frame_pipeline::FrameFormat::BGR;
+    bool mappedInput = false;
+    bool disparity = false;
+    std::string poseFile;
+    std::string boxFile;
+    bool skipStationary = false;
+    double minMotion = 0.25;
+    std::vector<std::string> directories;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--mmap") {
+            mappedInput = true;
+        } else if (std::string(argv[i]) == "--poses" && i + 1 < argc) {
+            poseFile = argv[++i];
+        } else if (std::string(argv[i]) == "--boxes" && i + 1 < argc) {
+            boxFile = argv[++i];
+        } else if (std::string(argv[i]) == "--skip-stationary") {
+            skipStationary = true;
+        } else if (std::string(argv[i]) == "--min-motion" && i + 1 < argc) {
+            minMotion = std::stod(argv[++i]);
+        } else if (std::string(argv[i]) == "--disparity") {
+            disparity = true;
+        } else if (!frame_pipeline::parseFrameFormatFlag(argv[i], frameFormat)) {
+            directories.push_back(argv[i]);
+        }
+    }
     
-    if (!fs::exists(leftDirectory) || !fs::is_directory(leftDirectory)) {
-        std::cerr << "Error: " << leftDirectory << " is not a valid directory" << std::endl;
+    if (directories.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [--yuv | --gray] [--mmap] [--disparity] [--poses <poses.txt>] [--boxes <bboxes.xml>] [--skip-stationary] [--min-motion <metres>] <camera_directory> <camera_directory> [...]" << std::endl;
+        std::cerr << "Example: " << argv[0] << " /path/to/left/images /path/to/right/images" << std::endl;
+        std::cerr << "Example: " << argv[0] << " <drive>/image_00/data_rect <drive>/image_01/data_rect "
+                  << "<drive>/image_02/data_rgb <drive>/image_03/data_rgb" << std::endl;
+        std::cerr << "  --yuv   Cache and upload frames as YUV 4:2:0 (half the memory of RGB)" << std::endl;
+        std::cerr << "  --gray  Decode, unwrap and cache 8-bit grayscale (a third of the memory of RGB)" << std::endl;
+        std::cerr << "  --mmap  Memory-map the image files and decode them in place, sharing the page cache" << std::endl;
+        std::cerr << "  --disparity  Show the disparity of the rectified image_00/image_01 pair in an extra view" << std::endl;
+        std::cerr << "  --poses  poses.txt or cam0_to_world.txt to navigate by distance (default: the drive's data_poses/)" << std::endl;
+        std::cerr << "  --boxes  3D bounding boxes to overlay (default: the drive's data_3d_bboxes/train/<drive>.xml)" << std::endl;
+        std::cerr << "  --skip-stationary  Start stepping over frame sets where the cameras barely moved (S toggles)" << std::endl;
+        std::cerr << "  --min-motion  Least camera motion between shown frame sets in metres (default 0.25)" << std::endl;
+        std::cerr << "Cameras are named after the image_0X component of each path; otherwise two directories are" << std::endl;
+        std::cerr << "image_02 and image_03, four are image_00 to image_03" << std::endl;
         return 1;
     }
     
-    if (!fs::exists(rightDirectory) || !fs::is_directory(rightDirectory)) {
-        std::cerr << "Error: " << rightDirectory << " is not a valid directory" << std::endl;
-        return 1;
+    std::vector<CameraStream> cameras;
+    for (size_t i = 0; i < directories.size(); ++i) {
+        if (!fs::exists(directories[i]) || !fs::is_directory(directories[i])) {
+            std::cerr << "Error: " << directories[i] << " is not a valid directory" << std::endl;
+            return 1;
+        }
+        
+        CameraStream camera;
+        camera.directory = directories[i];
+        camera.name = cameraNameFromPath(directories[i]);
+        if (camera.name.empty()) {
+            if (directories.size() == 2) {
+                camera.name = i == 0 ? "image_02" : "image_03";
+            } else if (directories.size() == 4) {
+                camera.name = "image_0" + std::to_string(i);
+            } else {
+                camera.name = "camera_" + std::to_string(i);
+            }
+        }
+        camera.processing = cameraProcessing(camera.name);
+        cameras.push_back(camera);
     }
     
-    StereoFisheyeViewer viewer;
+    MultiCameraViewer viewer;
+    viewer.setFrameFormat(frameFormat);
+    viewer.setMappedInput(mappedInput);
+    viewer.setCameras(cameras);
+    viewer.setDisparity(disparity);
+    viewer.setPoseFile(poseFile);
+    viewer.setBoxFile(boxFile);
+    viewer.setStationarySkipping(skipStationary, minMotion);
     
     if (!viewer.initialize()) {
         std::cerr << "Failed to initialize SDL" << std::endl;
         return 1;
     }
     
-    // Load fisheye calibration for undistortion
+    // Load fisheye and perspective calibration for undistortion and rectification
     if (!viewer.loadCalibration()) {
         std::cerr << "Warning: Failed to load calibration data. Images will be displayed without undistortion." << std::endl;
     }
     
-    if (!viewer.loadStereoPairs(leftDirectory, rightDirectory)) {
-        std::cerr << "Failed to load stereo pairs from directories" << std::endl;
+    if (!viewer.loadFrameSets()) {
+        std::cerr << "Failed to load frame sets from directories" << std::endl;
         return 1;
     }
     
-    std::cout << "Use left/right arrow keys to navigate unwrapped stereo pairs, ESC to quit" << std::endl;
-    std::cout << "Left half: image_02 (unwrapped), Right half: image_03 (unwrapped)" << std::endl;
+    bool poses = viewer.loadPoses();
+    bool boxes = viewer.loadBoxes();
+    viewer.startCalibrationWatcher();
+    
+    std::cout << "Use left/right arrow keys to navigate frame sets, ESC to quit" << std::endl;
+    std::cout << "Click a filmstrip thumbnail to jump to its frame set, F toggles the filmstrip" << std::endl;
+    if (poses) {
+        std::cout << "Up/down arrows move 10 m along the drive (+/- to change), click the minimap to jump there, "
+                  << "M toggles the minimap, S skips frame sets where the vehicle stands still" << std::endl;
+    }
+    if (boxes) {
+        std::cout << "B toggles the 3D box overlay" << std::endl;
+    }
+    std::cout << "Edit the files in kitti360_calibration/ to reload the calibration live" << std::endl;
+    std::cout << "Grid (row by row):";
+    for (const CameraStream& camera : cameras) {
+        std::cout << " " << camera.name;
+    }
+    if (viewer.showsDisparity()) {
+        std::cout << " disparity";
+    }
+    std::cout << std::endl;
     viewer.run();
     
     return 0;
@@ -0,0 +1,191 @@
+#include "batch_reader.h"
+#include "frame_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+namespace frame_pipeline {
+
+#ifdef HAVE_LIBURING
+
+struct BatchFileReader::Ring {
+    io_uring queue;
+    unsigned depth;
+};
+
+namespace {
+
+// A file being read into its buffer, resubmitted after short reads
+struct PendingRead {
+    size_t index = 0;
+    int fd = -1;       // Open while the read is in flight
+    cv::Mat contents;
+    size_t offset = 0;
+};
+
+// False if the submission queue is full, leaving the read to the caller
+bool submitRead(io_uring& queue, PendingRead& read) {
+    io_uring_sqe* sqe = io_uring_get_sqe(&queue);
+    if (!sqe) return false;
+    io_uring_prep_read(sqe, read.fd, read.contents.data + read.offset,
+                       static_cast<unsigned>(read.contents.total() - read.offset), read.offset);
+    io_uring_sqe_set_data(sqe, &read);
+    return true;
+}
+
+} // namespace
+
+BatchFileReader::BatchFileReader(unsigned queueDepth) {
+    std::unique_ptr<Ring> created(new Ring());
+    created->depth = queueDepth;
+    if (io_uring_queue_init(queueDepth, &created->queue, 0) == 0) {
+        ring = std::move(created);
+    }
+}
+
+BatchFileReader::~BatchFileReader() {
+    if (ring) {
+        io_uring_queue_exit(&ring->queue);
+    }
+}
+
+void BatchFileReader::readFiles(const std::vector<std::string>& filenames, const Callback& onRead) {
+    if (!ring) {
+        readFilesSequentially(filenames, onRead);
+        return;
+    }
+    
+    // Slots stay put while their reads are in flight, the kernel holds pointers to them
+    std::vector<PendingRead> reads(filenames.size());
+    size_t next = 0;
+    unsigned inFlight = 0;
+    bool failed = false;
+    
+    auto finish = [&](PendingRead& read, bool complete) {
+        ::close(read.fd);
+        read.fd = -1;
+        if (!complete) {
+            read.contents.release();
+        }
+        onRead(read.index, read.contents);
+        read.contents.release();
+    };
+    
+    while (!failed && (next < filenames.size() || inFlight > 0)) {
+        // Open files and queue their reads up to the ring depth
+        while (next < filenames.size() && inFlight < ring->depth) {
+            PendingRead& read = reads[next];
+            read.index = next++;
+            read.fd = ::open(filenames[read.index].c_str(), O_RDONLY);
+            
+            struct stat info;
+            if (read.fd < 0 || fstat(read.fd, &info) != 0 || info.st_size <= 0) {
+                if (read.fd >= 0) ::close(read.fd);
+                read.fd = -1;
+                onRead(read.index, cv::Mat());
+                continue;
+            }
+            
+            read.contents.create(1, static_cast<int>(info.st_size), CV_8UC1);
+            read.offset = 0;
+            if (!submitRead(ring->queue, read)) {
+                finish(read, false);
+                failed = true;
+                break;
+            }
+            ++inFlight;
+        }
+        if (!failed && io_uring_submit(&ring->queue) < 0) {
+            failed = true;
+        }
+        if (failed) break;
+        
+        if (inFlight == 0) continue;
+        
+        // Finish every completion that is ready, resubmitting the rest of short reads
+        io_uring_cqe* cqe;
+        int error = io_uring_wait_cqe(&ring->queue, &cqe);
+        if (error == -EINTR) continue;
+        if (error != 0) {
+            failed = true;
+            break;
+        }
+        do {
+            PendingRead& read = *static_cast<PendingRead*>(io_uring_cqe_get_data(cqe));
+            int result = cqe->res;
+            io_uring_cqe_seen(&ring->queue, cqe);
+            
+            if (result > 0 && read.offset + static_cast<size_t>(result) < read.contents.total()) {
+                read.offset += static_cast<size_t>(result);
+                if (submitRead(ring->queue, read)) continue;
+                failed = true;
+                result = -EAGAIN;
+            }
+            
+            --inFlight;
+            finish(read, result > 0);
+        } while (io_uring_peek_cqe(&ring->queue, &cqe) == 0);
+    }
+    
+    // Only reached early if submitting or waiting failed; later batches are read sequentially.
+    // Closing the ring does not wait for reads already running in the kernel, which may still
+    // write into their buffers, so those buffers are leaked on purpose instead of being freed or
+    // returned to the pool. Their files and every file not handed over yet are reported unreadable
+    if (failed) {
+        io_uring_queue_exit(&ring->queue);
+        ring.reset();
+        
+        for (size_t i = 0; i < next; ++i) {
+            PendingRead& read = reads[i];
+            if (read.fd < 0) continue;
+            
+            read.contents.addref(); // Never released
+            ::close(read.fd);
+            read.fd = -1;
+            onRead(read.index, cv::Mat());
+        }
+    }
+    for (; next < filenames.size(); ++next) {
+        onRead(next, cv::Mat());
+    }
+}
+
+const char* BatchFileReader::backendName() const {
+    return ring ? "io_uring" : "fadvise + read";
+}
+
+#else
+
+struct BatchFileReader::Ring {};
+
+BatchFileReader::BatchFileReader(unsigned) {}
+
+BatchFileReader::~BatchFileReader() {}
+
+void BatchFileReader::readFiles(const std::vector<std::string>& filenames, const Callback& onRead) {
+    readFilesSequentially(filenames, onRead);
+}
+
+const char* BatchFileReader::backendName() const {
+    return "fadvise + read";
+}
+
+#endif
+
+void BatchFileReader::readFilesSequentially(const std::vector<std::string>& filenames, const Callback& onRead) {
+    // Start readahead of the whole batch so later files load while earlier ones are copied
+    for (const std::string& filename : filenames) {
+        adviseWillNeed(filename);
+    }
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        onRead(i, readEncodedFile(filenames[i]));
+    }
+}
+
+} // namespace frame_pipeline
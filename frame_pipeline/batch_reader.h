@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Reads batches of whole files with as many reads in flight as the device takes
+ *
+ * Built with liburing (HAVE_LIBURING), all reads of a batch are submitted to
+ * an io_uring queue at once and completed files are handed back as they
+ * arrive, so one thread keeps an NVMe queue full. Otherwise, or if the
+ * kernel refuses io_uring, the batch is advised with POSIX_FADV_WILLNEED and
+ * read one file at a time, letting kernel readahead overlap the reads. If
+ * submitting to or waiting on the queue fails, the batch's unfinished files are
+ * reported as unreadable and the reader switches to sequential reads.
+ * Each instance is meant for one thread.
+ */
+class BatchFileReader {
+public:
+    static const unsigned DEFAULT_QUEUE_DEPTH = 32;
+
+    /**
+     * @brief Called once per file with its contents, empty if it cannot be read
+     */
+    using Callback = std::function<void(size_t index, const cv::Mat& contents)>;
+
+    explicit BatchFileReader(unsigned queueDepth = DEFAULT_QUEUE_DEPTH);
+    ~BatchFileReader();
+
+    BatchFileReader(const BatchFileReader&) = delete;
+    BatchFileReader& operator=(const BatchFileReader&) = delete;
+
+    /**
+     * @brief Read whole files into 1xN CV_8UC1 buffers
+     * @param filenames Files to read
+     * @param onRead Receives each file's index in filenames and contents, in completion order
+     */
+    void readFiles(const std::vector<std::string>& filenames, const Callback& onRead);
+
+    /**
+     * @brief "io_uring" or "fadvise + read"
+     */
+    const char* backendName() const;
+
+private:
+    struct Ring;
+
+    void readFilesSequentially(const std::vector<std::string>& filenames, const Callback& onRead);
+
+    std::unique_ptr<Ring> ring; // Null when reading sequentially
+};
+
+} // namespace frame_pipeline
@@ -0,0 +1,176 @@
+#include "frame_cache.h"
+#include "frame_convert.h"
+#include "png_decoder.h"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_SDL_IMAGE
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#endif
+
+// KITTI-360 fisheye frames are 1400x1400 RGB images
+const int FRAME_SIZE = 1400;
+
+/**
+ * @brief Synthetic frame with smooth content and sensor-like noise, so it compresses like a camera image
+ */
+cv::Mat makeFrame(const char* extension) {
+    cv::Mat frame(FRAME_SIZE, FRAME_SIZE, CV_8UC3);
+    for (int y = 0; y < frame.rows; ++y) {
+        for (int x = 0; x < frame.cols; ++x) {
+            frame.at<cv::Vec3b>(y, x) = cv::Vec3b((x / 6) & 0xFF, (y / 6) & 0xFF, ((x + y) / 11) & 0xFF);
+        }
+    }
+    cv::Mat noise(frame.size(), CV_8UC3);
+    cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(12));
+    frame += noise;
+    
+    std::vector<uchar> encoded;
+    cv::imencode(extension, frame, encoded);
+    return cv::Mat(encoded, true).reshape(1, 1);
+}
+
+/**
+ * @brief Average milliseconds per call, after one warm-up call
+ */
+double timeDecode(const std::function<bool()>& decode, int frames) {
+    if (!decode()) {
+        return -1.0;
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+        decode();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+void printResult(const char* label, double milliseconds, double baseline) {
+    std::cout << std::left << std::setw(22) << label << std::right << std::fixed;
+    if (milliseconds < 0.0) {
+        std::cout << std::setw(10) << "failed" << std::endl;
+        return;
+    }
+    std::cout << std::setprecision(2) << std::setw(10) << milliseconds << " ms/frame  "
+              << std::setw(6) << baseline / milliseconds << "x" << std::endl;
+}
+
+#ifdef HAVE_SDL_IMAGE
+double timeImgLoad(const cv::Mat& encoded, int frames) {
+    return timeDecode([&]() {
+        SDL_Surface* surface = IMG_Load_RW(SDL_RWFromConstMem(encoded.data, static_cast<int>(encoded.total())), 1);
+        if (!surface) {
+            return false;
+        }
+        SDL_FreeSurface(surface);
+        return true;
+    }, frames);
+}
+#endif
+
+void benchImgLoad(const cv::Mat& encoded, int frames, double baseline) {
+#ifdef HAVE_SDL_IMAGE
+    printResult("IMG_Load_RW", timeImgLoad(encoded, frames), baseline);
+#else
+    (void)encoded;
+    (void)frames;
+    (void)baseline;
+    std::cout << std::left << std::setw(22) << "IMG_Load_RW" << "skipped (built without SDL2_image)" << std::endl;
+#endif
+}
+
+void benchPng(const cv::Mat& encoded, const frame_pipeline::PngInfo& info, int frames) {
+    std::cout << "Decoding " << info.width << "x" << info.height << " PNG, " << info.channels << " channels, "
+              << (encoded.total() >> 10) << " KB" << (info.directPath ? "" : " (libpng path)")
+              << ", " << frames << " frames" << std::endl;
+    
+    double imdecode = timeDecode([&]() {
+        return !cv::imdecode(encoded, cv::IMREAD_COLOR).empty();
+    }, frames);
+    printResult("cv::imdecode", imdecode, imdecode);
+    benchImgLoad(encoded, frames, imdecode);
+    
+    double serial = timeDecode([&]() {
+        return !frame_pipeline::decodePng(encoded, 3, frame_pipeline::PngDecodeMode::Serial).empty();
+    }, frames);
+    printResult("decodePng serial", serial, imdecode);
+    
+    double pipelined = timeDecode([&]() {
+        return !frame_pipeline::decodePng(encoded, 3, frame_pipeline::PngDecodeMode::Pipelined).empty();
+    }, frames);
+    printResult("decodePng pipelined", pipelined, imdecode);
+    
+    double gray = timeDecode([&]() {
+        return !frame_pipeline::decodePng(encoded, 1, frame_pipeline::PngDecodeMode::Serial).empty();
+    }, frames);
+    printResult("decodePng gray", gray, imdecode);
+}
+
+void benchJpeg(const cv::Mat& encoded, const frame_pipeline::JpegInfo& info, int frames) {
+    std::cout << "Decoding " << info.width << "x" << info.height << " JPEG, "
+              << (encoded.total() >> 10) << " KB, " << frames << " frames" << std::endl;
+    
+    double imdecode = timeDecode([&]() {
+        return !cv::imdecode(encoded, cv::IMREAD_COLOR).empty();
+    }, frames);
+    printResult("cv::imdecode", imdecode, imdecode);
+    benchImgLoad(encoded, frames, imdecode);
+    
+    for (int scale : {1, 2, 4, 8}) {
+        double scaled = timeDecode([&]() {
+            return !frame_pipeline::decodeJpegImage(encoded, 3, scale).empty();
+        }, frames);
+        std::string label = "decodeJpegImage 1/" + std::to_string(scale);
+        printResult(label.c_str(), scaled, imdecode);
+    }
+    
+    double gray = timeDecode([&]() {
+        return !frame_pipeline::decodeJpegImage(encoded, 1, 1).empty();
+    }, frames);
+    printResult("decodeJpegImage gray", gray, imdecode);
+}
+
+int main(int argc, char** argv) {
+    std::string filename = argc > 1 ? argv[1] : "";
+    int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+    
+#ifdef HAVE_SDL_IMAGE
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+#endif
+    
+    // Without a file, time both formats on the same synthetic frame
+    std::vector<cv::Mat> inputs;
+    if (!filename.empty()) {
+        inputs.push_back(frame_pipeline::readEncodedFile(filename));
+        if (inputs.back().empty()) {
+            std::cerr << "✗ Cannot read " << filename << std::endl;
+            return 1;
+        }
+    } else {
+        inputs.push_back(makeFrame(".png"));
+        inputs.push_back(makeFrame(".jpg"));
+    }
+    
+    for (const cv::Mat& encoded : inputs) {
+        frame_pipeline::PngInfo pngInfo;
+        frame_pipeline::JpegInfo jpegInfo;
+        if (frame_pipeline::readPngInfo(encoded.data, encoded.total(), pngInfo)) {
+            benchPng(encoded, pngInfo, frames);
+        } else if (frame_pipeline::readJpegInfo(encoded.data, encoded.total(), jpegInfo)) {
+            benchJpeg(encoded, jpegInfo, frames);
+        } else {
+            std::cerr << "✗ Not a PNG or JPEG: " << filename << std::endl;
+            return 1;
+        }
+    }
+    
+#ifdef HAVE_SDL_IMAGE
+    IMG_Quit();
+#endif
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include "buffer_pool.h"
+#include "calibration_registry.h"
+#include "huge_pages.h"
+#include "tiled_remap.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Matches the dual viewer's loader threads
+const int NUM_LOADING_THREADS = 4;
+
+/**
+ * @brief Per-thread counter of data TLB read misses, if perf events are allowed
+ */
+class TlbMissCounter {
+public:
+    TlbMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    
+    ~TlbMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    
+    bool available() const { return fd >= 0; }
+    
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    
+    uint64_t stop() {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd < 0) return 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+            count = 0;
+        }
+#endif
+        return count;
+    }
+    
+private:
+    int fd = -1;
+};
+
+struct BenchResult {
+    double framesPerSecond = 0.0;
+    double tlbMissesPerFrame = -1.0; // Negative if perf events are unavailable
+    uint64_t hugePageMisses = 0;
+};
+
+/**
+ * @brief Unwrap maps of a KITTI-360 fisheye calibration, built by the calibration library with the viewer's settings
+ */
+bool buildMaps(const std::string& calibrationFile, cv::Mat& map1, cv::Mat& map2, cv::Size& inputSize) {
+    try {
+        kitti360::FisheyeCamera camera = kitti360::makeFisheyeCamera(kitti360::loadFisheyeParams(calibrationFile));
+        inputSize = cv::Size(camera.params.image_width, camera.params.image_height);
+        kitti360::UndistortionMaps maps = kitti360::buildUnwrapMaps(camera.cameraMatrix, camera.distCoeffs, inputSize,
+                                                                    kitti360::UnwrapSettings());
+        map1 = maps.map1;
+        map2 = maps.map2;
+    } catch (const std::exception& e) {
+        std::cerr << "✗ Cannot load " << calibrationFile << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Remap frames on the loader threads with maps and frames drawn from one pool
+ */
+BenchResult runRemap(const cv::Mat& map1, const cv::Mat& map2, cv::Size inputSize,
+                     int frames, bool hugePages, bool tiled) {
+    frame_pipeline::BufferPool pool(1ull << 30, hugePages);
+    
+    // Copy the maps into pool memory, like maps built after the viewer installs the pool
+    cv::Mat pooledMap1, pooledMap2;
+    pooledMap1.allocator = pool.matAllocator();
+    pooledMap2.allocator = pool.matAllocator();
+    map1.copyTo(pooledMap1);
+    map2.copyTo(pooledMap2);
+    frame_pipeline::TiledRemap tiledRemap(pooledMap1, pooledMap2, inputSize, 3);
+    
+    std::atomic<uint64_t> tlbMisses(0);
+    std::atomic<bool> countersAvailable(true);
+    std::vector<std::thread> threads;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < NUM_LOADING_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            cv::Mat source, undistorted;
+            source.allocator = pool.matAllocator();
+            undistorted.allocator = pool.matAllocator();
+            source.create(inputSize, CV_8UC3);
+            cv::randu(source, cv::Scalar::all(0), cv::Scalar::all(255));
+            
+            // Warm up so page faults are not counted
+            cv::remap(source, undistorted, pooledMap1, pooledMap2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+            
+            TlbMissCounter counter;
+            counter.start();
+            for (int i = t; i < frames; i += NUM_LOADING_THREADS) {
+                if (tiled) {
+                    tiledRemap.apply(source, undistorted, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+                } else {
+                    cv::remap(source, undistorted, pooledMap1, pooledMap2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+                }
+            }
+            tlbMisses += counter.stop();
+            if (!counter.available()) {
+                countersAvailable = false;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    BenchResult result;
+    result.framesPerSecond = frames / seconds;
+    if (countersAvailable) {
+        result.tlbMissesPerFrame = static_cast<double>(tlbMisses) / frames;
+    }
+    result.hugePageMisses = pool.stats().hugePageMisses;
+    return result;
+}
+
+void printResult(const char* label, const BenchResult& result) {
+    std::cout << std::left << std::setw(14) << label << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << result.framesPerSecond << " frames/s  ";
+    if (result.tlbMissesPerFrame >= 0.0) {
+        std::cout << std::setprecision(0) << std::setw(12) << result.tlbMissesPerFrame << " dTLB misses/frame";
+    } else {
+        std::cout << std::setw(12) << "n/a" << " dTLB misses/frame";
+    }
+    std::cout << "  (" << result.hugePageMisses << " huge-page buffers)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string calibrationFile = argc > 1 ? argv[1] : "../../kitti360_calibration/image_02.yaml";
+    int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+    
+    cv::Mat map1, map2;
+    cv::Size inputSize;
+    if (!buildMaps(calibrationFile, map1, map2, inputSize)) {
+        return 1;
+    }
+    
+    // One OpenCV thread per remap, the loader threads provide the parallelism
+    cv::setNumThreads(1);
+    
+    frame_pipeline::PageBacking backing;
+    void* probe = frame_pipeline::allocateHugePages(frame_pipeline::HUGE_PAGE_BYTES, &backing);
+    frame_pipeline::freeHugePages(probe, frame_pipeline::HUGE_PAGE_BYTES);
+    
+    size_t mapBytes = map1.total() * map1.elemSize() + map2.total() * map2.elemSize();
+    std::cout << "Remapping " << inputSize.width << "x" << inputSize.height << " frames to "
+              << map1.cols << "x" << map1.rows << " on " << NUM_LOADING_THREADS << " threads ("
+              << (mapBytes >> 20) << " MB of maps, " << frames << " frames)" << std::endl;
+    std::cout << "Huge pages: " << frame_pipeline::pageBackingName(backing) << std::endl;
+    
+    frame_pipeline::TiledRemap plan(map1, map2, inputSize, 3);
+    std::cout << "Tiled remap: " << plan.tiles().size() << " tiles, largest source footprint "
+              << (plan.largestFootprintBytes() >> 10) << " KB" << std::endl;
+    
+    BenchResult regular = runRemap(map1, map2, inputSize, frames, false, false);
+    BenchResult huge = runRemap(map1, map2, inputSize, frames, true, false);
+    BenchResult tiled = runRemap(map1, map2, inputSize, frames, true, true);
+    printResult("regular pages", regular);
+    printResult("huge pages", huge);
+    printResult("huge + tiled", tiled);
+    
+    for (const BenchResult* result : {&huge, &tiled}) {
+        std::cout << std::setprecision(2) << (result == &huge ? "Huge pages" : "Huge pages + tiles")
+                  << ": " << result->framesPerSecond / regular.framesPerSecond << "x";
+        if (regular.tlbMissesPerFrame > 0.0 && result->tlbMissesPerFrame >= 0.0) {
+            std::cout << ", dTLB misses " << std::setprecision(1)
+                      << 100.0 * (1.0 - result->tlbMissesPerFrame / regular.tlbMissesPerFrame) << "% fewer";
+        }
+        std::cout << std::endl;
+    }
+    
+    return 0;
+}
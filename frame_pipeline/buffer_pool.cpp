@@ -0,0 +1,257 @@
+#include "buffer_pool.h"
+#include "huge_pages.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace frame_pipeline {
+
+namespace {
+
+const size_t PAGE_BYTES = 4096;
+
+// Header in front of pooledMalloc blocks; 64 bytes keep the payload SIMD aligned
+struct BlockHeader {
+    size_t capacity; // Size class of a pooled block, 0 if the block came from malloc
+    size_t bytes;    // Requested payload size
+};
+const size_t BLOCK_HEADER_BYTES = 64;
+
+} // namespace
+
+class BufferPool::PooledMatAllocator : public cv::MatAllocator {
+public:
+    explicit PooledMatAllocator(BufferPool& pool) : pool(pool) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            total *= sizes[i];
+        }
+        
+        // User-provided data and small matrices are left to OpenCV's allocator
+        if (data0 || total < BufferPool::MIN_POOLED_BYTES) {
+            return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+        }
+        
+        if (step) {
+            size_t stride = CV_ELEM_SIZE(type);
+            for (int i = dims - 1; i >= 0; i--) {
+                step[i] = stride;
+                stride *= sizes[i];
+            }
+        }
+        
+        size_t capacity;
+        void* data = pool.acquire(total, capacity);
+        if (!data) {
+            throw std::bad_alloc();
+        }
+        
+        cv::UMatData* u = new cv::UMatData(this);
+        u->data = u->origdata = static_cast<uchar*>(data);
+        u->size = total;
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        CV_Assert(u->urefcount == 0 && u->refcount == 0);
+        pool.release(u->origdata, BufferPool::sizeClass(u->size));
+        delete u;
+    }
+
+private:
+    BufferPool& pool;
+};
+
+BufferPool& BufferPool::instance() {
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::BufferPool(size_t retainLimitBytes, bool hugePages)
+    : retainLimitBytes(retainLimitBytes), hugePages(hugePages), allocator(new PooledMatAllocator(*this)) {}
+
+BufferPool::~BufferPool() {
+    for (auto& [capacity, buffers] : freeLists) {
+        for (void* buffer : buffers) {
+            freeBuffer(buffer, capacity);
+        }
+    }
+}
+
+size_t BufferPool::sizeClass(size_t bytes) {
+    // Four classes per power of two: 1, 1.25, 1.5 and 1.75 times the power
+    size_t power = PAGE_BYTES;
+    while (power * 2 <= bytes) {
+        power *= 2;
+    }
+    size_t quarter = power / 4;
+    size_t capacity = (bytes + quarter - 1) / quarter * quarter;
+    
+    // Large classes are whole huge pages, a partial one could not be promoted
+    size_t granularity = capacity >= HUGE_PAGE_BYTES ? HUGE_PAGE_BYTES : PAGE_BYTES;
+    return (capacity + granularity - 1) / granularity * granularity;
+}
+
+void* BufferPool::allocateBuffer(size_t capacity) {
+    if (hugePages && capacity >= HUGE_PAGE_BYTES) {
+        PageBacking backing;
+        void* buffer = allocateHugePages(capacity, &backing);
+        if (buffer && backing != PageBacking::Regular) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++counters.hugePageMisses;
+        }
+        return buffer;
+    }
+    
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, PAGE_BYTES, capacity) != 0) {
+        return nullptr;
+    }
+    return buffer;
+}
+
+void BufferPool::freeBuffer(void* buffer, size_t capacity) {
+    if (hugePages && capacity >= HUGE_PAGE_BYTES) {
+        freeHugePages(buffer, capacity);
+    } else {
+        std::free(buffer);
+    }
+}
+
+void* BufferPool::acquire(size_t bytes, size_t& capacity) {
+    capacity = sizeClass(bytes);
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = freeLists.find(capacity);
+        if (found != freeLists.end() && !found->second.empty()) {
+            void* buffer = found->second.back();
+            found->second.pop_back();
+            counters.pooledBytes -= capacity;
+            counters.outstandingBytes += capacity;
+            ++counters.hits;
+            return buffer;
+        }
+        ++counters.misses;
+        counters.outstandingBytes += capacity;
+    }
+    
+    void* buffer = allocateBuffer(capacity);
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.outstandingBytes -= capacity;
+    }
+    return buffer;
+}
+
+void BufferPool::release(void* buffer, size_t capacity) {
+    if (!buffer) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.outstandingBytes -= capacity;
+        if (counters.pooledBytes + capacity <= retainLimitBytes) {
+            freeLists[capacity].push_back(buffer);
+            counters.pooledBytes += capacity;
+            return;
+        }
+        ++counters.trimmed;
+    }
+    freeBuffer(buffer, capacity);
+}
+
+void BufferPool::setRetainLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    retainLimitBytes = bytes;
+    trimToLimit();
+}
+
+void BufferPool::trimToLimit() {
+    // Free the largest buffers first, they are the least likely to be reused
+    for (auto it = freeLists.rbegin(); it != freeLists.rend() && counters.pooledBytes > retainLimitBytes; ++it) {
+        while (!it->second.empty() && counters.pooledBytes > retainLimitBytes) {
+            freeBuffer(it->second.back(), it->first);
+            it->second.pop_back();
+            counters.pooledBytes -= it->first;
+            ++counters.trimmed;
+        }
+    }
+}
+
+BufferPoolStats BufferPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+cv::MatAllocator* BufferPool::matAllocator() {
+    return allocator.get();
+}
+
+void* pooledMalloc(size_t bytes) {
+    size_t total = bytes + BLOCK_HEADER_BYTES;
+    size_t capacity = 0;
+    void* block = total >= BufferPool::MIN_POOLED_BYTES ? BufferPool::instance().acquire(total, capacity)
+                                                        : std::malloc(total);
+    if (!block) {
+        return nullptr;
+    }
+    
+    BlockHeader* header = static_cast<BlockHeader*>(block);
+    header->capacity = capacity;
+    header->bytes = bytes;
+    return static_cast<char*>(block) + BLOCK_HEADER_BYTES;
+}
+
+void* pooledCalloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+    void* block = pooledMalloc(count * size);
+    if (block) {
+        std::memset(block, 0, count * size);
+    }
+    return block;
+}
+
+void* pooledRealloc(void* block, size_t bytes) {
+    if (!block) {
+        return pooledMalloc(bytes);
+    }
+    
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(static_cast<char*>(block) - BLOCK_HEADER_BYTES);
+    if (header->capacity != 0 && bytes + BLOCK_HEADER_BYTES <= header->capacity) {
+        header->bytes = bytes;
+        return block;
+    }
+    
+    void* resized = pooledMalloc(bytes);
+    if (resized) {
+        std::memcpy(resized, block, std::min(header->bytes, bytes));
+        pooledFree(block);
+    }
+    return resized;
+}
+
+void pooledFree(void* block) {
+    if (!block) return;
+    
+    void* start = static_cast<char*>(block) - BLOCK_HEADER_BYTES;
+    const BlockHeader* header = static_cast<const BlockHeader*>(start);
+    if (header->capacity != 0) {
+        BufferPool::instance().release(start, header->capacity);
+    } else {
+        std::free(start);
+    }
+}
+
+} // namespace frame_pipeline
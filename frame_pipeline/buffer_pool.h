@@ -0,0 +1,117 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Reuse counters of a buffer pool
+ */
+struct BufferPoolStats {
+    uint64_t hits = 0;            // Acquisitions served from a free list
+    uint64_t misses = 0;          // Acquisitions that allocated new memory
+    uint64_t trimmed = 0;         // Released buffers freed because the pool was full
+    uint64_t hugePageMisses = 0;  // Misses served from huge-page mappings
+    size_t pooledBytes = 0;       // Free buffers kept for reuse
+    size_t outstandingBytes = 0;  // Buffers handed out and not released yet
+};
+
+/**
+ * @brief Size-classed pool of frame-sized buffers
+ *
+ * Requests are rounded up to one of four size classes per power of two (at
+ * most 25% slack) and served page aligned. Released buffers go to per-class
+ * free lists, up to a retain limit, and are handed out again, so steady-state
+ * frame processing makes no system allocations and touches no fresh pages.
+ * Classes of 2 MB and up are whole huge pages and, unless disabled, come
+ * from allocateHugePages(), so remap maps and frames cost few TLB entries.
+ * Thread-safe.
+ */
+class BufferPool {
+public:
+    static const size_t MIN_POOLED_BYTES = 64 << 10; // Smaller requests are left to malloc
+
+    /**
+     * @brief Process-wide pool
+     *
+     * Never destroyed, so Mats and SDL surfaces released during static
+     * destruction can still return their buffers.
+     */
+    static BufferPool& instance();
+
+    /**
+     * @param retainLimitBytes Bytes kept on free lists at most
+     * @param hugePages Back classes of HUGE_PAGE_BYTES or more with huge pages
+     */
+    explicit BufferPool(size_t retainLimitBytes = 512ull << 20, bool hugePages = true);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief Get a page-aligned buffer of at least the requested size
+     * @param bytes Requested size
+     * @param capacity Receives the size class of the buffer, to pass back to release()
+     * @return Buffer, or nullptr if the system is out of memory
+     */
+    void* acquire(size_t bytes, size_t& capacity);
+
+    /**
+     * @brief Return a buffer obtained from acquire()
+     */
+    void release(void* buffer, size_t capacity);
+
+    /**
+     * @brief Limit the bytes kept on free lists, freeing buffers over the limit
+     */
+    void setRetainLimit(size_t bytes);
+
+    BufferPoolStats stats() const;
+
+    /**
+     * @brief cv::MatAllocator drawing Mats of MIN_POOLED_BYTES or more from this pool
+     *
+     * Install with cv::Mat::setDefaultAllocator() so remap targets, color
+     * conversions and cached frames reuse pooled buffers.
+     */
+    cv::MatAllocator* matAllocator();
+
+    /**
+     * @brief Capacity of the size class a request is served from
+     */
+    static size_t sizeClass(size_t bytes);
+
+private:
+    class PooledMatAllocator;
+
+    void* allocateBuffer(size_t capacity);
+    void freeBuffer(void* buffer, size_t capacity);
+    void trimToLimit();
+
+    mutable std::mutex mutex;
+    std::map<size_t, std::vector<void*>> freeLists; // By size class
+    size_t retainLimitBytes;
+    const bool hugePages;
+    BufferPoolStats counters;
+    std::unique_ptr<cv::MatAllocator> allocator;
+};
+
+/**
+ * @brief malloc-compatible functions backed by the process-wide pool
+ *
+ * For C libraries with pluggable allocators, e.g. SDL_SetMemoryFunctions() so
+ * IMG_Load surfaces draw from the pool. Each block carries a small header
+ * recording its size class, so pooledFree() needs no size.
+ */
+void* pooledMalloc(size_t bytes);
+void* pooledCalloc(size_t count, size_t size);
+void* pooledRealloc(void* block, size_t bytes);
+void pooledFree(void* block);
+
+} // namespace frame_pipeline
@@ -0,0 +1,91 @@
+#include "disparity.h"
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+namespace frame_pipeline {
+
+namespace {
+
+using MatcherKey = std::tuple<int, int, bool, int>;
+
+// Matchers keep their working buffers between calls, so each thread reuses its own
+cv::Ptr<cv::StereoMatcher> threadMatcher(const DisparitySettings& settings, int disparities, int channels) {
+    thread_local std::map<MatcherKey, cv::Ptr<cv::StereoMatcher>> matchers;
+    MatcherKey key(disparities, settings.blockSize, settings.semiGlobal, channels);
+    auto it = matchers.find(key);
+    if (it != matchers.end()) {
+        return it->second;
+    }
+    
+    cv::Ptr<cv::StereoMatcher> matcher;
+    if (settings.semiGlobal) {
+        // Smoothness penalties as recommended for StereoSGBM
+        int area = channels * settings.blockSize * settings.blockSize;
+        matcher = cv::StereoSGBM::create(0, disparities, settings.blockSize, 8 * area, 32 * area,
+                                         1, 63, 10, 100, 2, cv::StereoSGBM::MODE_SGBM_3WAY);
+    } else {
+        cv::Ptr<cv::StereoBM> blockMatcher = cv::StereoBM::create(disparities, std::max(settings.blockSize, 5) | 1);
+        blockMatcher->setUniquenessRatio(10);
+        blockMatcher->setSpeckleWindowSize(100);
+        blockMatcher->setSpeckleRange(2);
+        matcher = blockMatcher;
+    }
+    matchers.emplace(key, matcher);
+    return matcher;
+}
+
+// Unknown pixels (negative disparity) map to 0, the rest to 1..255
+cv::Mat normalizedDisparity(const cv::Mat& disparity, int numDisparities, cv::Mat& valid) {
+    cv::Mat scaled;
+    disparity.convertTo(scaled, CV_8U, 254.0 / (16.0 * numDisparities), 1.0);
+    valid = disparity >= 0;
+    scaled.setTo(0, ~valid);
+    return scaled;
+}
+
+} // namespace
+
+int scaledDisparities(const DisparitySettings& settings) {
+    int scale = std::max(settings.scaleDenominator, 1);
+    int disparities = (settings.numDisparities + scale - 1) / scale;
+    return std::max(16, (disparities + 15) / 16 * 16);
+}
+
+cv::Mat computeDisparity(const cv::Mat& left, const cv::Mat& right, const DisparitySettings& settings) {
+    if (left.size() != right.size() || left.type() != right.type()) {
+        throw std::runtime_error("Stereo images must have the same size and type");
+    }
+    
+    // Block matching works on gray images; both matchers are fastest on one channel
+    cv::Mat leftGray = left, rightGray = right;
+    if (left.channels() == 3) {
+        cv::cvtColor(left, leftGray, cv::COLOR_BGR2GRAY);
+        cv::cvtColor(right, rightGray, cv::COLOR_BGR2GRAY);
+    }
+    if (settings.scaleDenominator > 1) {
+        cv::Size reduced(left.cols / settings.scaleDenominator, left.rows / settings.scaleDenominator);
+        cv::resize(leftGray, leftGray, reduced, 0, 0, cv::INTER_AREA);
+        cv::resize(rightGray, rightGray, reduced, 0, 0, cv::INTER_AREA);
+    }
+    
+    cv::Mat disparity;
+    threadMatcher(settings, scaledDisparities(settings), 1)->compute(leftGray, rightGray, disparity);
+    return disparity;
+}
+
+cv::Mat colorizeDisparity(const cv::Mat& disparity, int numDisparities) {
+    cv::Mat valid;
+    cv::Mat scaled = normalizedDisparity(disparity, numDisparities, valid);
+    cv::Mat colored;
+    cv::applyColorMap(scaled, colored, cv::COLORMAP_TURBO);
+    colored.setTo(cv::Scalar::all(0), ~valid);
+    return colored;
+}
+
+cv::Mat disparityToGray(const cv::Mat& disparity, int numDisparities) {
+    cv::Mat valid;
+    return normalizedDisparity(disparity, numDisparities, valid);
+}
+
+} // namespace frame_pipeline
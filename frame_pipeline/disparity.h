@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Settings of the stereo matcher
+ *
+ * The search range is given at full resolution; matching at
+ * 1 / scaleDenominator shrinks it by the same factor (rounded up to a
+ * multiple of 16), so the interactive and batch results cover the same depths.
+ */
+struct DisparitySettings {
+    int numDisparities = 128;   // Full-resolution search range, a multiple of 16
+    int blockSize = 5;          // Odd matching window edge
+    int scaleDenominator = 1;   // Match at 1/1, 1/2, 1/4 ... of the rectified size
+    bool semiGlobal = true;     // Semi-global matching (3-way) instead of plain block matching
+};
+
+/**
+ * @brief Disparity range searched at the settings' scale
+ */
+int scaledDisparities(const DisparitySettings& settings);
+
+/**
+ * @brief Disparity of a rectified stereo pair
+ *
+ * Uses OpenCV's vectorised matchers: StereoSGBM in its single-pass 3-way mode,
+ * or StereoBM. A matcher is created per calling thread and settings, so
+ * loader threads match pairs concurrently without sharing buffers.
+ * @param left Rectified left image (CV_8UC1 or CV_8UC3)
+ * @param right Rectified right image of the same size and type
+ * @param settings Matcher settings
+ * @return CV_16S disparity of the left image at 1 / scaleDenominator of its size,
+ *         in 1/16 pixels of that size; negative where no match was found
+ * @throws std::runtime_error if the images differ in size or type
+ */
+cv::Mat computeDisparity(const cv::Mat& left, const cv::Mat& right, const DisparitySettings& settings);
+
+/**
+ * @brief Colour a disparity map for display, near (large disparity) red and far blue
+ * @param disparity CV_16S disparity from computeDisparity()
+ * @param numDisparities Search range the disparity was computed with
+ * @return CV_8UC3 BGR image, black where the disparity is unknown
+ */
+cv::Mat colorizeDisparity(const cv::Mat& disparity, int numDisparities);
+
+/**
+ * @brief Scale a disparity map to 8-bit gray for display, unknown pixels black
+ */
+cv::Mat disparityToGray(const cv::Mat& disparity, int numDisparities);
+
+} // namespace frame_pipeline
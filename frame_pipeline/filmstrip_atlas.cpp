@@ -0,0 +1,170 @@
+#include "filmstrip_atlas.h"
+#include <algorithm>
+#include <iostream>
+
+namespace frame_pipeline {
+
+FilmstripAtlas::FilmstripAtlas() : renderer(nullptr), store(nullptr) {}
+
+bool FilmstripAtlas::create(SDL_Renderer* targetRenderer, const ThumbnailStore& thumbnailStore, size_t thumbnails) {
+    destroy();
+    renderer = targetRenderer;
+    store = &thumbnailStore;
+    
+    int maxPageSize = 2048;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0 && info.max_texture_height > 0) {
+        maxPageSize = std::min({maxPageSize, info.max_texture_width, info.max_texture_height});
+    }
+    atlas = ThumbnailAtlasLayout(store->width(), store->height(), thumbnails, maxPageSize);
+    
+    for (int page = 0; page < atlas.pages; ++page) {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_BGR24, SDL_TEXTUREACCESS_STATIC,
+                                                 atlas.pageWidth, atlas.pageHeight);
+        if (!texture) {
+            std::cerr << "Filmstrip disabled, cannot create atlas texture: " << SDL_GetError() << std::endl;
+            destroy();
+            return false;
+        }
+        pages.push_back(texture);
+    }
+    cellFrames.assign(atlas.capacity(), -1);
+    return true;
+}
+
+void FilmstripAtlas::destroy() {
+    for (SDL_Texture* page : pages) {
+        SDL_DestroyTexture(page);
+    }
+    pages.clear();
+    cellFrames.clear();
+}
+
+SDL_Rect FilmstripAtlas::rect(int windowWidth, int windowHeight) const {
+    int height = atlas.thumbnailHeight + 2 * MARGIN;
+    return {0, windowHeight - height, windowWidth, height};
+}
+
+FilmstripLayout FilmstripAtlas::strip(size_t cursor, const SDL_Rect& bar) const {
+    return FilmstripLayout::centred(cursor, bar.w, atlas.thumbnailWidth, GAP);
+}
+
+// Cells keep their thumbnail until another frame maps to them, so scrubbing back uploads nothing
+void FilmstripAtlas::upload(const FilmstripLayout& strip) {
+    for (int slot = 0; slot < strip.slots; ++slot) {
+        long frame = strip.firstFrame + slot;
+        if (frame < 0 || frame >= static_cast<long>(store->size())) continue;
+        
+        size_t cell = atlas.cell(static_cast<size_t>(frame));
+        if (cellFrames[cell] == frame || !store->isReady(static_cast<size_t>(frame))) continue;
+        SDL_Rect cellRect = {0, 0, atlas.thumbnailWidth, atlas.thumbnailHeight};
+        atlas.cellOrigin(cell, cellRect.x, cellRect.y);
+        if (SDL_UpdateTexture(pages[atlas.page(cell)], &cellRect, store->pixels(static_cast<size_t>(frame)),
+                              cellRect.w * 3) == 0) {
+            cellFrames[cell] = frame;
+        }
+    }
+}
+
+void FilmstripAtlas::render(size_t cursor, int windowWidth, int windowHeight, const Dimmed& dimmed) {
+    if (!created()) return;
+    
+    SDL_Rect bar = rect(windowWidth, windowHeight);
+    FilmstripLayout layout = strip(cursor, bar);
+    upload(layout);
+    
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 170);
+    SDL_RenderFillRect(renderer, &bar);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    
+    // Thumbnails grouped by atlas page; frames without one yet get a placeholder
+    std::vector<std::vector<SDL_Rect>> sources(pages.size()), targets(pages.size());
+    std::vector<SDL_Rect> placeholders, dimmedTargets;
+    SDL_Rect current = {0, 0, 0, 0};
+    for (int slot = 0; slot < layout.slots; ++slot) {
+        long frame = layout.firstFrame + slot;
+        if (frame < 0 || frame >= static_cast<long>(store->size())) continue;
+        
+        SDL_Rect target = {bar.x + layout.left + slot * layout.pitch, bar.y + MARGIN,
+                           atlas.thumbnailWidth, atlas.thumbnailHeight};
+        if (frame == static_cast<long>(cursor)) current = target;
+        if (dimmed && dimmed(static_cast<size_t>(frame))) dimmedTargets.push_back(target);
+        size_t cell = atlas.cell(static_cast<size_t>(frame));
+        if (cellFrames[cell] != frame) {
+            placeholders.push_back(target);
+            continue;
+        }
+        SDL_Rect source = {0, 0, atlas.thumbnailWidth, atlas.thumbnailHeight};
+        atlas.cellOrigin(cell, source.x, source.y);
+        sources[atlas.page(cell)].push_back(source);
+        targets[atlas.page(cell)].push_back(target);
+    }
+    
+    SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
+    SDL_RenderFillRects(renderer, placeholders.data(), static_cast<int>(placeholders.size()));
+    for (size_t page = 0; page < pages.size(); ++page) {
+        drawPage(pages[page], sources[page], targets[page]);
+    }
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 150);
+    SDL_RenderFillRects(renderer, dimmedTargets.data(), static_cast<int>(dimmedTargets.size()));
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    
+    SDL_SetRenderDrawColor(renderer, 255, 200, 0, 255);
+    for (int border = 1; border <= 2; ++border) {
+        SDL_Rect outline = {current.x - border, current.y - border, current.w + 2 * border, current.h + 2 * border};
+        SDL_RenderDrawRect(renderer, &outline);
+    }
+}
+
+// Two triangles per thumbnail in one SDL_RenderGeometry call where SDL has it (2.0.18), else
+// copies that SDL's render batching merges
+void FilmstripAtlas::drawPage(SDL_Texture* page, const std::vector<SDL_Rect>& sources,
+                              const std::vector<SDL_Rect>& targets) {
+    if (sources.empty()) return;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    float pageWidth = static_cast<float>(atlas.pageWidth);
+    float pageHeight = static_cast<float>(atlas.pageHeight);
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    vertices.reserve(sources.size() * 4);
+    indices.reserve(sources.size() * 6);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const SDL_Rect& source = sources[i];
+        const SDL_Rect& target = targets[i];
+        int first = static_cast<int>(vertices.size());
+        for (int corner = 0; corner < 4; ++corner) {
+            int right = corner & 1, bottom = corner >> 1;
+            vertices.push_back({{static_cast<float>(target.x + right * target.w),
+                                 static_cast<float>(target.y + bottom * target.h)},
+                                {255, 255, 255, 255},
+                                {(source.x + right * source.w) / pageWidth,
+                                 (source.y + bottom * source.h) / pageHeight}});
+        }
+        for (int corner : {0, 1, 2, 2, 1, 3}) {
+            indices.push_back(first + corner);
+        }
+    }
+    SDL_RenderGeometry(renderer, page, vertices.data(), static_cast<int>(vertices.size()), indices.data(),
+                       static_cast<int>(indices.size()));
+#else
+    for (size_t i = 0; i < sources.size(); ++i) {
+        SDL_RenderCopy(renderer, page, &sources[i], &targets[i]);
+    }
+#endif
+}
+
+bool FilmstripAtlas::frameAt(size_t cursor, int windowWidth, int windowHeight, int x, int y, long& frame) const {
+    frame = -1;
+    if (!created()) return false;
+    
+    SDL_Rect bar = rect(windowWidth, windowHeight);
+    SDL_Point point = {x, y};
+    if (!SDL_PointInRect(&point, &bar)) return false;
+    
+    frame = strip(cursor, bar).frameAt(x - bar.x, store->size());
+    return true;
+}
+
+} // namespace frame_pipeline
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "thumbnails.h"
+#include <SDL2/SDL.h>
+#include <functional>
+#include <vector>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Filmstrip drawn from thumbnail atlas textures, shared by the viewers
+ *
+ * Owns one static BGR24 texture per atlas page. Thumbnails that became ready
+ * are uploaded into their cells as the strip passes over them, and each page
+ * is drawn with one SDL_RenderGeometry call (one SDL_RenderCopy per
+ * thumbnail before SDL 2.0.18). The strip spans the bottom of the window with
+ * the cursor's thumbnail in the middle. Render thread only.
+ */
+class FilmstripAtlas {
+public:
+    static constexpr int GAP = 4;    // Between thumbnails
+    static constexpr int MARGIN = 6; // Above and below the thumbnails
+    static constexpr size_t DEFAULT_THUMBNAILS = 512; // The widest strip plus slack for scrubbing back
+
+    /**
+     * @brief Returns true for frames whose thumbnail is dimmed
+     */
+    using Dimmed = std::function<bool(size_t index)>;
+
+    FilmstripAtlas();
+
+    FilmstripAtlas(const FilmstripAtlas&) = delete;
+    FilmstripAtlas& operator=(const FilmstripAtlas&) = delete;
+
+    /**
+     * @brief Create the atlas pages for a store's thumbnails
+     * @param renderer Renderer the pages belong to
+     * @param store Thumbnails to show; must outlive destroy()
+     * @param thumbnails Atlas cells wanted
+     * @return False (with a message printed) if a page texture cannot be created
+     */
+    bool create(SDL_Renderer* renderer, const ThumbnailStore& store, size_t thumbnails = DEFAULT_THUMBNAILS);
+
+    /**
+     * @brief Destroy the page textures; call before destroying the renderer
+     */
+    void destroy();
+
+    bool created() const { return !pages.empty(); }
+    const ThumbnailAtlasLayout& layout() const { return atlas; }
+
+    /**
+     * @brief Where the strip is drawn in a window of the given size
+     */
+    SDL_Rect rect(int windowWidth, int windowHeight) const;
+
+    /**
+     * @brief Upload newly ready thumbnails around the cursor and draw the strip
+     * @param cursor Frame of the middle thumbnail, outlined
+     * @param dimmed Frames drawn dimmed; may be empty
+     */
+    void render(size_t cursor, int windowWidth, int windowHeight, const Dimmed& dimmed = Dimmed());
+
+    /**
+     * @brief Frame of the thumbnail at a window position
+     * @param frame Set to the frame, or -1 between thumbnails and on empty slots
+     * @return False if the position is outside the strip
+     */
+    bool frameAt(size_t cursor, int windowWidth, int windowHeight, int x, int y, long& frame) const;
+
+private:
+    FilmstripLayout strip(size_t cursor, const SDL_Rect& bar) const;
+    void upload(const FilmstripLayout& strip);
+    void drawPage(SDL_Texture* page, const std::vector<SDL_Rect>& sources, const std::vector<SDL_Rect>& targets);
+
+    SDL_Renderer* renderer;
+    const ThumbnailStore* store;
+    ThumbnailAtlasLayout atlas;
+    std::vector<SDL_Texture*> pages;
+    std::vector<long> cellFrames; // Frame each atlas cell holds, -1 if none
+};
+
+} // namespace frame_pipeline
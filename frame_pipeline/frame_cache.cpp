@@ -0,0 +1,237 @@
+#include "frame_cache.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace frame_pipeline {
+
+namespace {
+
+// Large reads let the kernel stream whole files instead of paging them in
+const size_t READ_CHUNK_BYTES = 8 << 20;
+
+// Owner of Mats wrapping file mappings: unmaps when the last Mat lets go
+class MappedFileAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        CV_Assert(u->urefcount == 0 && u->refcount == 0);
+        munmap(u->origdata, u->size);
+        delete u;
+    }
+};
+
+const cv::MatAllocator* mappedFileAllocator() {
+    static const MappedFileAllocator* allocator = new MappedFileAllocator();
+    return allocator;
+}
+
+} // namespace
+
+size_t imageBytes(const cv::Mat& image) {
+    return image.total() * image.elemSize();
+}
+
+ImageLru::ImageLru(size_t budgetBytes)
+    : budgetBytes(budgetBytes), bytes(0), hits(0), misses(0), evictions(0) {}
+
+void ImageLru::put(const FrameKey& key, const cv::Mat& image, uint64_t generation) {
+    size_t entryBytes = imageBytes(image);
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        bytes -= found->second->bytes;
+        entries.erase(found->second);
+        index.erase(found);
+    }
+    
+    if (image.empty() || entryBytes > budgetBytes) {
+        return;
+    }
+    
+    entries.push_front(Entry{key, image, generation, entryBytes});
+    index[key] = entries.begin();
+    bytes += entryBytes;
+    evictToBudget();
+}
+
+bool ImageLru::putIfRoom(const FrameKey& key, const cv::Mat& image, uint64_t generation) {
+    size_t entryBytes = imageBytes(image);
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    if (image.empty() || index.count(key) != 0 || bytes + entryBytes > budgetBytes) {
+        return false;
+    }
+    
+    entries.push_front(Entry{key, image, generation, entryBytes});
+    index[key] = entries.begin();
+    bytes += entryBytes;
+    return true;
+}
+
+bool ImageLru::get(const FrameKey& key, cv::Mat& image, uint64_t* generation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        ++misses;
+        return false;
+    }
+    
+    entries.splice(entries.begin(), entries, found->second);
+    image = found->second->image;
+    if (generation) *generation = found->second->generation;
+    ++hits;
+    return true;
+}
+
+bool ImageLru::contains(const FrameKey& key, uint64_t* generation) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        return false;
+    }
+    if (generation) *generation = found->second->generation;
+    return true;
+}
+
+void ImageLru::erase(const FrameKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        bytes -= found->second->bytes;
+        entries.erase(found->second);
+        index.erase(found);
+    }
+}
+
+void ImageLru::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    bytes = 0;
+}
+
+void ImageLru::setBudget(size_t newBudgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budgetBytes = newBudgetBytes;
+    evictToBudget();
+}
+
+TierStats ImageLru::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    TierStats stats;
+    stats.bytes = bytes;
+    stats.budgetBytes = budgetBytes;
+    stats.entries = entries.size();
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    return stats;
+}
+
+void ImageLru::evictToBudget() {
+    while (bytes > budgetBytes && !entries.empty()) {
+        const Entry& oldest = entries.back();
+        bytes -= oldest.bytes;
+        index.erase(oldest.key);
+        entries.pop_back();
+        ++evictions;
+    }
+}
+
+cv::Mat readEncodedFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return cv::Mat();
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return cv::Mat();
+    }
+    
+#ifdef POSIX_FADV_SEQUENTIAL
+    // Doubles the kernel's readahead window for this file
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    
+    cv::Mat contents(1, static_cast<int>(info.st_size), CV_8UC1);
+    size_t total = static_cast<size_t>(info.st_size);
+    size_t offset = 0;
+    while (offset < total) {
+        ssize_t count = ::read(fd, contents.data + offset, std::min(READ_CHUNK_BYTES, total - offset));
+        if (count <= 0) {
+            ::close(fd);
+            return cv::Mat();
+        }
+        offset += static_cast<size_t>(count);
+    }
+    
+    ::close(fd);
+    return contents;
+}
+
+cv::Mat mapEncodedFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return cv::Mat();
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return cv::Mat();
+    }
+    
+    size_t size = static_cast<size_t>(info.st_size);
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE; // Fault the file in now rather than page by page while decoding
+#endif
+    void* mapping = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return cv::Mat();
+    }
+    
+    // Wrap the mapping, then hand its ownership to a UMatData so copies share it
+    cv::Mat contents(1, static_cast<int>(size), CV_8UC1, mapping);
+    cv::UMatData* u = new cv::UMatData(mappedFileAllocator());
+    u->data = u->origdata = static_cast<uchar*>(mapping);
+    u->size = size;
+    u->refcount = 1;
+    contents.u = u;
+    return contents;
+}
+
+bool adviseWillNeed(const std::string& filename) {
+#ifdef POSIX_FADV_WILLNEED
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    // Readahead continues after the descriptor is closed
+    bool advised = posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0;
+    ::close(fd);
+    return advised;
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+} // namespace frame_pipeline
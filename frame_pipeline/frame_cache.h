@@ -0,0 +1,164 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Identifies one camera image of one frame in a sequence
+ */
+struct FrameKey {
+    size_t frame;
+    int camera;
+
+    bool operator==(const FrameKey& other) const {
+        return frame == other.frame && camera == other.camera;
+    }
+};
+
+struct FrameKeyHash {
+    size_t operator()(const FrameKey& key) const {
+        return std::hash<size_t>()(key.frame * 8 + static_cast<size_t>(key.camera));
+    }
+};
+
+/**
+ * @brief Occupancy and hit counters of one cache tier
+ */
+struct TierStats {
+    size_t bytes = 0;
+    size_t budgetBytes = 0;
+    size_t entries = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+/**
+ * @brief Thread-safe least-recently-used image cache bounded by a byte budget
+ *
+ * Entries are reference-counted cv::Mat, so an image evicted while a caller
+ * still holds it stays valid for that caller. Each entry carries a generation
+ * number, letting callers tell results produced with outdated parameters
+ * (e.g. undistortion maps before a calibration reload) from current ones.
+ */
+class ImageLru {
+public:
+    explicit ImageLru(size_t budgetBytes);
+
+    /**
+     * @brief Insert or replace an image, evicting least recently used entries over budget
+     *
+     * Images larger than the whole budget are not cached.
+     */
+    void put(const FrameKey& key, const cv::Mat& image, uint64_t generation = 0);
+
+    /**
+     * @brief Insert an image only if it fits without evicting anything
+     * @return true if the image was cached
+     */
+    bool putIfRoom(const FrameKey& key, const cv::Mat& image, uint64_t generation = 0);
+
+    /**
+     * @brief Look up an image and mark it most recently used
+     * @param generation Receives the generation of the entry if not null
+     * @return true on a hit
+     */
+    bool get(const FrameKey& key, cv::Mat& image, uint64_t* generation = nullptr);
+
+    /**
+     * @brief Check for an entry without touching recency or hit counters
+     */
+    bool contains(const FrameKey& key, uint64_t* generation = nullptr) const;
+
+    void erase(const FrameKey& key);
+    void clear();
+
+    /**
+     * @brief Change the budget, evicting entries if it shrank
+     */
+    void setBudget(size_t budgetBytes);
+
+    TierStats stats() const;
+
+private:
+    struct Entry {
+        FrameKey key;
+        cv::Mat image;
+        uint64_t generation;
+        size_t bytes;
+    };
+
+    void evictToBudget();
+
+    mutable std::mutex mutex;
+    size_t budgetBytes;
+    size_t bytes;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<FrameKey, std::list<Entry>::iterator, FrameKeyHash> index;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+/**
+ * @brief Frame cache with an independent byte budget per tier
+ *
+ * The encoded tier keeps still-compressed file contents (1xN CV_8UC1), meant
+ * to hold a whole sequence so scrubbing never waits for disk. The raw tier
+ * keeps decoded source frames so that reprojection (new calibration,
+ * projection or zoom) re-uses them without decoding again. The undistorted
+ * tier keeps display-ready frames that are uploaded to textures as is.
+ */
+struct TieredFrameCache {
+    ImageLru encoded;
+    ImageLru raw;
+    ImageLru undistorted;
+
+    TieredFrameCache(size_t encodedBudgetBytes, size_t rawBudgetBytes, size_t undistortedBudgetBytes)
+        : encoded(encodedBudgetBytes), raw(rawBudgetBytes), undistorted(undistortedBudgetBytes) {}
+};
+
+/**
+ * @brief Read a whole file into a 1xN CV_8UC1 buffer with large sequential reads
+ * @param filename File to read
+ * @return File contents, or an empty Mat if the file cannot be read
+ */
+cv::Mat readEncodedFile(const std::string& filename);
+
+/**
+ * @brief Map a whole file read-only as a 1xN CV_8UC1 Mat, without copying it
+ *
+ * The Mat and its copies share the mapping, which is unmapped when the last
+ * of them is released. Its pages are the kernel's page cache, so viewers
+ * mapping the same files share one copy in memory and decoders read the
+ * file bytes in place. The pages are populated up front; writing to the Mat
+ * is not allowed.
+ * @param filename File to map
+ * @return Mapped contents, or an empty Mat if the file cannot be mapped
+ */
+cv::Mat mapEncodedFile(const std::string& filename);
+
+/**
+ * @brief Ask the kernel to start reading a file into the page cache
+ *
+ * Issues posix_fadvise(POSIX_FADV_WILLNEED), which queues asynchronous
+ * readahead of the whole file and returns without waiting for it, so a later
+ * readEncodedFile() finds the data in memory.
+ * @param filename File that will be read soon
+ * @return True if the advice was issued, false if the file cannot be opened
+ *         or the platform has no fadvise
+ */
+bool adviseWillNeed(const std::string& filename);
+
+/**
+ * @brief Bytes held by an image's pixel data
+ */
+size_t imageBytes(const cv::Mat& image);
+
+} // namespace frame_pipeline
@@ -0,0 +1,92 @@
+#include "frame_convert.h"
+
+namespace frame_pipeline {
+
+namespace {
+
+// Repeat the last column and row of odd-sized images, so 4:2:0 frames keep every source pixel
+cv::Mat padToEven(const cv::Mat& image) {
+    if (image.cols % 2 == 0 && image.rows % 2 == 0) {
+        return image;
+    }
+    cv::Mat padded;
+    cv::copyMakeBorder(image, padded, 0, image.rows % 2, 0, image.cols % 2, cv::BORDER_REPLICATE);
+    return padded;
+}
+
+} // namespace
+
+cv::Mat convertFromBGR(const cv::Mat& bgr, FrameFormat format) {
+    if (format == FrameFormat::BGR || bgr.empty()) {
+        return bgr;
+    }
+    
+    cv::Mat frame;
+    if (format == FrameFormat::Gray) {
+        cv::cvtColor(bgr, frame, cv::COLOR_BGR2GRAY);
+        return frame;
+    }
+    
+    cv::cvtColor(padToEven(bgr), frame, cv::COLOR_BGR2YUV_I420);
+    return frame;
+}
+
+cv::Mat convertToBGR(const cv::Mat& frame, FrameFormat format) {
+    if (format == FrameFormat::BGR || frame.empty()) {
+        return frame;
+    }
+    
+    cv::Mat bgr;
+    cv::cvtColor(frame, bgr, format == FrameFormat::Gray ? cv::COLOR_GRAY2BGR : cv::COLOR_YUV2BGR_I420);
+    return bgr;
+}
+
+cv::Size frameImageSize(const cv::Mat& frame, FrameFormat format) {
+    if (format == FrameFormat::I420) {
+        return cv::Size(frame.cols, frame.rows * 2 / 3);
+    }
+    return frame.size();
+}
+
+cv::Size convertedImageSize(cv::Size imageSize, FrameFormat format) {
+    if (format == FrameFormat::BGR) {
+        return imageSize;
+    }
+    return cv::Size((imageSize.width + 1) & ~1, (imageSize.height + 1) & ~1);
+}
+
+cv::Mat decodeGrayFrame(const cv::Mat& encoded, PngDecodeMode mode) {
+    if (encoded.empty()) {
+        return cv::Mat();
+    }
+    
+    cv::Mat gray;
+    if (isPng(encoded.data, encoded.total())) {
+        gray = decodePng(encoded, 1, mode);
+    } else if (isJpeg(encoded.data, encoded.total())) {
+        gray = decodeJpegImage(encoded, 1);
+    }
+    if (gray.empty()) {
+        gray = cv::imdecode(encoded, cv::IMREAD_GRAYSCALE);
+    }
+    return gray.empty() ? gray : padToEven(gray);
+}
+
+cv::Mat decodeJpegImage(const cv::Mat& encoded, int channels, int scaleDenominator) {
+    JpegInfo info;
+    bool validScale = scaleDenominator == 1 || scaleDenominator == 2 || scaleDenominator == 4 || scaleDenominator == 8;
+    if (!validScale || encoded.empty() || !readJpegInfo(encoded.data, encoded.total(), info)) {
+        return cv::Mat();
+    }
+    
+    int width, height;
+    scaledJpegSize(info, scaleDenominator, width, height);
+    cv::Mat image(height, width, channels == 1 ? CV_8UC1 : CV_8UC3);
+    JpegPixelFormat format = channels == 1 ? JpegPixelFormat::Gray : JpegPixelFormat::BGR;
+    if (!decodeJpegInto(encoded.data, encoded.total(), scaleDenominator, format, image.data, image.step)) {
+        return cv::Mat();
+    }
+    return image;
+}
+
+} // namespace frame_pipeline
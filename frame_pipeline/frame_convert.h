@@ -0,0 +1,67 @@
+#pragma once
+
+#include "frame_format.h"
+#include "jpeg_decoder.h"
+#include "png_decoder.h"
+#include <opencv2/opencv.hpp>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Convert a BGR image to a frame format
+ *
+ * I420 frames are a single CV_8UC1 Mat of height * 3 / 2 rows, the layout
+ * expected by SDL_PIXELFORMAT_IYUV textures. Odd-sized images get their last
+ * row or column repeated since 4:2:0 needs even dimensions, so no source
+ * pixel is lost. Gray frames are CV_8UC1 luminance.
+ * @param bgr CV_8UC3 image
+ * @param format Target format
+ * @return Converted frame (shares data with the input for FrameFormat::BGR)
+ */
+cv::Mat convertFromBGR(const cv::Mat& bgr, FrameFormat format);
+
+/**
+ * @brief Convert a frame back to a BGR image for processing
+ * @param frame Frame in the given format
+ * @param format Format of the frame
+ * @return CV_8UC3 image (shares data with the input for FrameFormat::BGR)
+ */
+cv::Mat convertToBGR(const cv::Mat& frame, FrameFormat format);
+
+/**
+ * @brief Width and height of the image a frame holds
+ */
+cv::Size frameImageSize(const cv::Mat& frame, FrameFormat format);
+
+/**
+ * @brief Size of the image a frame of a given image size holds once converted to a format
+ *
+ * Odd sizes are padded to even for I420 and gray, so remap tables built
+ * for the original size apply to the top left imageSize part of the frame.
+ */
+cv::Size convertedImageSize(cv::Size imageSize, FrameFormat format);
+
+/**
+ * @brief Decode compressed image bytes straight to a gray frame
+ *
+ * The PNG/JPEG decoder converts to luminance while decoding, so no color
+ * image is materialized; PNGs go through decodePng() and JPEGs through
+ * decodeJpegImage(), which skips the chroma planes. Odd-sized frames are
+ * padded to even like convertFromBGR() so they can be displayed through
+ * IYUV textures.
+ * @param encoded Compressed file contents (1xN CV_8UC1)
+ * @param mode PNG decode mode, pipelined for the frame on screen
+ * @return CV_8UC1 frame, or an empty Mat if decoding failed
+ */
+cv::Mat decodeGrayFrame(const cv::Mat& encoded, PngDecodeMode mode = PngDecodeMode::Serial);
+
+/**
+ * @brief Decode a JPEG into a BGR (CV_8UC3) or gray (CV_8UC1) Mat, optionally at reduced size
+ * @param encoded JPEG file contents (1xN CV_8UC1)
+ * @param channels 3 for BGR, 1 for gray
+ * @param scaleDenominator 1, 2, 4 or 8, see chooseJpegScale()
+ * @return Decoded image, or an empty Mat if the data is not a JPEG libjpeg can decode
+ */
+cv::Mat decodeJpegImage(const cv::Mat& encoded, int channels, int scaleDenominator = 1);
+
+} // namespace frame_pipeline
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Pixel layout frames are decoded to, cached in and uploaded from
+ *
+ * Kept free of OpenCV so the SDL-only viewer can share it.
+ */
+enum class FrameFormat {
+    BGR,   // Packed 8-bit BGR, 3 bytes per pixel (CV_8UC3)
+    I420,  // Planar YUV 4:2:0, Y plane then quarter-size U and V planes, 1.5 bytes per pixel
+    Gray,  // 8-bit luminance, 1 byte per pixel (CV_8UC1)
+};
+
+inline const char* frameFormatName(FrameFormat format) {
+    switch (format) {
+        case FrameFormat::I420: return "YUV 4:2:0";
+        case FrameFormat::Gray: return "grayscale";
+        default: return "BGR";
+    }
+}
+
+/**
+ * @brief Parse a viewer command-line frame format flag
+ * @param arg Command-line argument (--yuv or --gray)
+ * @param format Receives the format if arg is a frame format flag
+ * @return true if arg was a frame format flag
+ */
+inline bool parseFrameFormatFlag(const std::string& arg, FrameFormat& format) {
+    if (arg == "--yuv") {
+        format = FrameFormat::I420;
+        return true;
+    }
+    if (arg == "--gray") {
+        format = FrameFormat::Gray;
+        return true;
+    }
+    return false;
+}
+
+} // namespace frame_pipeline
@@ -0,0 +1,101 @@
+#include "huge_pages.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace frame_pipeline {
+
+namespace {
+
+size_t roundToHugePages(size_t bytes) {
+    return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+}
+
+} // namespace
+
+void* allocateHugePages(size_t bytes, PageBacking* backing) {
+    size_t size = roundToHugePages(bytes);
+    
+#ifdef __linux__
+#ifdef MAP_HUGETLB
+    // Explicit huge pages only succeed if the administrator reserved some
+    void* reserved = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (reserved != MAP_FAILED) {
+        if (backing) *backing = PageBacking::Explicit;
+        return reserved;
+    }
+#endif
+    
+    // Over-allocate by one huge page and trim, so the buffer starts on a 2 MB boundary
+    void* mapping = mmap(nullptr, size + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+    uintptr_t aligned = (start + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    if (aligned > start) {
+        munmap(mapping, aligned - start);
+    }
+    size_t tail = start + size + HUGE_PAGE_BYTES - (aligned + size);
+    if (tail > 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+    
+    void* memory = reinterpret_cast<void*>(aligned);
+    bool advised = false;
+#ifdef MADV_HUGEPAGE
+    advised = madvise(memory, size, MADV_HUGEPAGE) == 0;
+#endif
+    if (backing) *backing = advised ? PageBacking::Transparent : PageBacking::Regular;
+    return memory;
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, HUGE_PAGE_BYTES, size) != 0) {
+        return nullptr;
+    }
+    std::memset(memory, 0, size);
+    if (backing) *backing = PageBacking::Regular;
+    return memory;
+#endif
+}
+
+void freeHugePages(void* memory, size_t bytes) {
+    if (!memory) return;
+    
+#ifdef __linux__
+    munmap(memory, roundToHugePages(bytes));
+#else
+    std::free(memory);
+#endif
+}
+
+void adviseHugePages(void* memory, size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    uintptr_t start = reinterpret_cast<uintptr_t>(memory);
+    uintptr_t first = (start + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    uintptr_t last = (start + bytes) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    if (last > first) {
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE);
+    }
+#else
+    (void)memory;
+    (void)bytes;
+#endif
+}
+
+const char* pageBackingName(PageBacking backing) {
+    switch (backing) {
+        case PageBacking::Transparent: return "transparent huge pages";
+        case PageBacking::Explicit:    return "explicit huge pages";
+        default:                       return "regular pages";
+    }
+}
+
+} // namespace frame_pipeline
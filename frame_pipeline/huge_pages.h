@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+namespace frame_pipeline {
+
+const size_t HUGE_PAGE_BYTES = 2 << 20;
+
+/**
+ * @brief How a huge-page allocation ended up backed
+ */
+enum class PageBacking {
+    Regular,      // 4 KB pages (huge pages unavailable)
+    Transparent,  // Anonymous mapping advised with MADV_HUGEPAGE
+    Explicit      // MAP_HUGETLB from the reserved vm.nr_hugepages pool
+};
+
+/**
+ * @brief Allocate a 2 MB aligned buffer backed by huge pages where the system allows
+ *
+ * Tries explicit huge pages first, then a 2 MB aligned anonymous mapping
+ * advised for transparent huge pages, which the kernel backs with regular
+ * pages if neither is available. Large remap maps and frames then need one
+ * TLB entry per 2 MB instead of 512.
+ * @param bytes Requested size, rounded up to a multiple of HUGE_PAGE_BYTES
+ * @param backing Receives the backing that was obtained, may be null
+ * @return Zero-filled buffer, or nullptr if the system is out of memory
+ */
+void* allocateHugePages(size_t bytes, PageBacking* backing = nullptr);
+
+/**
+ * @brief Free a buffer obtained from allocateHugePages()
+ * @param memory Buffer to free
+ * @param bytes Size passed to allocateHugePages()
+ */
+void freeHugePages(void* memory, size_t bytes);
+
+/**
+ * @brief Ask for transparent huge pages on an existing mapping
+ *
+ * Only the 2 MB aligned part of the range can be promoted; a no-op where
+ * MADV_HUGEPAGE is unsupported.
+ */
+void adviseHugePages(void* memory, size_t bytes);
+
+/**
+ * @brief Name of a page backing for statistics output
+ */
+const char* pageBackingName(PageBacking backing);
+
+} // namespace frame_pipeline
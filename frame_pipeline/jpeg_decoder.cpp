@@ -0,0 +1,197 @@
+#include "jpeg_decoder.h"
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <jpeglib.h>
+
+namespace frame_pipeline {
+
+namespace {
+
+// libjpeg reports errors through error_exit, which must not return
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    std::jmp_buf jump;
+};
+
+void jumpOnError(j_common_ptr cinfo) {
+    JpegErrorManager* errors = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    std::longjmp(errors->jump, 1);
+}
+
+void ignoreMessage(j_common_ptr) {
+}
+
+#ifdef JCS_EXTENSIONS
+J_COLOR_SPACE outputColorSpace(JpegPixelFormat format) {
+    switch (format) {
+        case JpegPixelFormat::Gray: return JCS_GRAYSCALE;
+        case JpegPixelFormat::BGR: return JCS_EXT_BGR;
+        case JpegPixelFormat::RGBA: return JCS_EXT_RGBX;
+        case JpegPixelFormat::BGRA: return JCS_EXT_BGRX;
+        case JpegPixelFormat::ARGB: return JCS_EXT_XRGB;
+        case JpegPixelFormat::ABGR: return JCS_EXT_XBGR;
+        default: return JCS_RGB;
+    }
+}
+#else
+J_COLOR_SPACE outputColorSpace(JpegPixelFormat format) {
+    return format == JpegPixelFormat::Gray ? JCS_GRAYSCALE : JCS_RGB;
+}
+
+// Reorder one decoded RGB row into the output format
+void reorderRow(const uint8_t* rgb, uint8_t* target, JpegPixelFormat format, int width) {
+    for (int x = 0; x < width; ++x, rgb += 3) {
+        switch (format) {
+            case JpegPixelFormat::BGR:
+                *target++ = rgb[2]; *target++ = rgb[1]; *target++ = rgb[0];
+                break;
+            case JpegPixelFormat::RGBA:
+                *target++ = rgb[0]; *target++ = rgb[1]; *target++ = rgb[2]; *target++ = 0xFF;
+                break;
+            case JpegPixelFormat::BGRA:
+                *target++ = rgb[2]; *target++ = rgb[1]; *target++ = rgb[0]; *target++ = 0xFF;
+                break;
+            case JpegPixelFormat::ARGB:
+                *target++ = 0xFF; *target++ = rgb[0]; *target++ = rgb[1]; *target++ = rgb[2];
+                break;
+            case JpegPixelFormat::ABGR:
+                *target++ = 0xFF; *target++ = rgb[2]; *target++ = rgb[1]; *target++ = rgb[0];
+                break;
+            default:
+                *target++ = rgb[0]; *target++ = rgb[1]; *target++ = rgb[2];
+                break;
+        }
+    }
+}
+#endif
+
+} // namespace
+
+int jpegPixelBytes(JpegPixelFormat format) {
+    switch (format) {
+        case JpegPixelFormat::Gray: return 1;
+        case JpegPixelFormat::RGB:
+        case JpegPixelFormat::BGR: return 3;
+        default: return 4;
+    }
+}
+
+bool isJpeg(const uint8_t* data, size_t size) {
+    return size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+bool readJpegInfo(const uint8_t* data, size_t size, JpegInfo& info) {
+    if (!isJpeg(data, size)) {
+        return false;
+    }
+    
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager errors;
+    cinfo.err = jpeg_std_error(&errors.base);
+    errors.base.error_exit = jumpOnError;
+    errors.base.output_message = ignoreMessage;
+    if (setjmp(errors.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+    info.width = static_cast<int>(cinfo.image_width);
+    info.height = static_cast<int>(cinfo.image_height);
+    info.components = cinfo.num_components;
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+int chooseJpegScale(int width, int height, int targetWidth, int targetHeight) {
+    if (width <= 0 || height <= 0 || targetWidth <= 0 || targetHeight <= 0) {
+        return 1;
+    }
+    
+    // The fitted image is min(targetWidth / width, targetHeight / height) of full size, so
+    // halve while the limiting side stays at least as large as the target
+    bool widthLimited = static_cast<long long>(targetWidth) * height <= static_cast<long long>(targetHeight) * width;
+    int denominator = 1;
+    while (denominator < 8) {
+        int next = denominator * 2;
+        bool fills = widthLimited ? width / next >= targetWidth : height / next >= targetHeight;
+        if (!fills) break;
+        denominator = next;
+    }
+    return denominator;
+}
+
+void scaledJpegSize(const JpegInfo& info, int scaleDenominator, int& width, int& height) {
+    width = (info.width + scaleDenominator - 1) / scaleDenominator;
+    height = (info.height + scaleDenominator - 1) / scaleDenominator;
+}
+
+bool decodeJpegInto(const uint8_t* data, size_t size, int scaleDenominator,
+                    JpegPixelFormat format, uint8_t* pixels, size_t step) {
+    if (!isJpeg(data, size) || (scaleDenominator != 1 && scaleDenominator != 2 &&
+                                scaleDenominator != 4 && scaleDenominator != 8)) {
+        return false;
+    }
+    
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager errors;
+    cinfo.err = jpeg_std_error(&errors.base);
+    errors.base.error_exit = jumpOnError;
+    errors.base.output_message = ignoreMessage;
+#ifndef JCS_EXTENSIONS
+    std::vector<uint8_t> rgbRow;
+#endif
+    if (setjmp(errors.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = static_cast<unsigned int>(scaleDenominator);
+    cinfo.out_color_space = outputColorSpace(format);
+    jpeg_start_decompress(&cinfo);
+    
+    // The caller sized the pixels with scaledJpegSize()
+    JpegInfo info;
+    info.width = static_cast<int>(cinfo.image_width);
+    info.height = static_cast<int>(cinfo.image_height);
+    int width, height;
+    scaledJpegSize(info, scaleDenominator, width, height);
+    if (static_cast<int>(cinfo.output_width) != width || static_cast<int>(cinfo.output_height) != height) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    
+#ifdef JCS_EXTENSIONS
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = pixels + step * cinfo.output_scanline;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+#else
+    bool reorder = format != JpegPixelFormat::Gray && format != JpegPixelFormat::RGB;
+    if (reorder) {
+        rgbRow.resize(static_cast<size_t>(width) * 3);
+    }
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint8_t* target = pixels + step * cinfo.output_scanline;
+        JSAMPROW row = reorder ? rgbRow.data() : target;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+        if (reorder) {
+            reorderRow(rgbRow.data(), target, format, width);
+        }
+    }
+#endif
+    
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+} // namespace frame_pipeline
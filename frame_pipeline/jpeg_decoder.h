@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Byte order of the pixels a JPEG is decoded to
+ *
+ * Four-byte formats get an opaque alpha (or padding) byte. Kept free of
+ * OpenCV so the SDL-only viewer can share the decoder.
+ */
+enum class JpegPixelFormat {
+    Gray, // 8-bit luminance
+    RGB,
+    BGR,  // CV_8UC3 layout
+    RGBA, // SDL_PIXELFORMAT_RGBA32 / ABGR8888 on little-endian
+    BGRA, // SDL_PIXELFORMAT_BGRA32 / ARGB8888 on little-endian
+    ARGB,
+    ABGR
+};
+
+/**
+ * @brief Dimensions of a JPEG image
+ */
+struct JpegInfo {
+    int width = 0;
+    int height = 0;
+    int components = 0; // 1 gray, 3 YCbCr, 4 CMYK
+};
+
+/**
+ * @brief Bytes per pixel of a JPEG output format
+ */
+int jpegPixelBytes(JpegPixelFormat format);
+
+/**
+ * @brief Check the JPEG start-of-image marker
+ */
+bool isJpeg(const uint8_t* data, size_t size);
+
+/**
+ * @brief Read the frame header of a JPEG
+ * @return False if the data is not a JPEG
+ */
+bool readJpegInfo(const uint8_t* data, size_t size, JpegInfo& info);
+
+/**
+ * @brief Largest DCT scaling denominator (1, 2, 4 or 8) that still fills a target size
+ *
+ * The image is assumed to be shown fitted into the target with its aspect
+ * ratio kept, so it is scaled down as long as the fitted image is not
+ * magnified.
+ * @param width Full image width
+ * @param height Full image height
+ * @param targetWidth Width of the area the image is shown in
+ * @param targetHeight Height of the area the image is shown in
+ */
+int chooseJpegScale(int width, int height, int targetWidth, int targetHeight);
+
+/**
+ * @brief Size of a JPEG decoded at 1 / scaleDenominator, rounded up like libjpeg
+ */
+void scaledJpegSize(const JpegInfo& info, int scaleDenominator, int& width, int& height);
+
+/**
+ * @brief Decode a JPEG at reduced resolution straight into caller-provided pixels
+ *
+ * libjpeg-turbo scales in the inverse DCT, so decoding at 1/2, 1/4 or 1/8
+ * skips most of the work instead of resizing afterwards, and with its
+ * extended color spaces (JCS_EXTENSIONS) writes the output byte order
+ * directly. Other libjpeg builds decode RGB and reorder each row.
+ * @param data JPEG file contents
+ * @param size Size of data
+ * @param scaleDenominator 1, 2, 4 or 8
+ * @param format Output byte order
+ * @param pixels Output of scaledJpegSize() pixels
+ * @param step Bytes between output rows
+ * @return False if the data is not a JPEG libjpeg can decode
+ */
+bool decodeJpegInto(const uint8_t* data, size_t size, int scaleDenominator,
+                    JpegPixelFormat format, uint8_t* pixels, size_t step);
+
+} // namespace frame_pipeline
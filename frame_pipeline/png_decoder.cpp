@@ -0,0 +1,395 @@
+#include "png_decoder.h"
+#include "buffer_pool.h"
+#include <png.h>
+#include <zlib.h>
+#include <algorithm>
+#include <csetjmp>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace frame_pipeline {
+
+namespace {
+
+const uint8_t PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+const size_t INFLATE_SLICE_BYTES = 64 << 10; // Input per inflate call, bounds the progress granularity
+
+// Fixed-point cv::COLOR_BGR2GRAY weights
+const int GRAY_SHIFT = 14;
+const int R_TO_GRAY = 4899, G_TO_GRAY = 9617, B_TO_GRAY = 1868;
+
+uint32_t readBigEndian(const uint8_t* bytes) {
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+}
+
+struct Chunk {
+    const uint8_t* data;
+    uint32_t length;
+};
+
+struct PngStream {
+    PngInfo info;
+    std::vector<Chunk> idat;
+};
+
+// Walk the chunks, collecting the IDAT payloads; CRCs are checked for IHDR and IDAT
+bool parsePng(const uint8_t* data, size_t size, PngStream& png) {
+    if (!readPngInfo(data, size, png.info)) {
+        return false;
+    }
+    
+    size_t offset = sizeof(PNG_SIGNATURE);
+    while (offset + 12 <= size) {
+        uint32_t length = readBigEndian(data + offset);
+        const uint8_t* type = data + offset + 4;
+        if (length > size - offset - 12) {
+            return false;
+        }
+        
+        bool idat = std::memcmp(type, "IDAT", 4) == 0;
+        if (idat || std::memcmp(type, "IHDR", 4) == 0) {
+            uint32_t crc = static_cast<uint32_t>(crc32(0, type, length + 4));
+            if (crc != readBigEndian(type + 4 + length)) {
+                return false;
+            }
+        }
+        if (idat) {
+            png.idat.push_back({type + 4, length});
+        }
+        if (std::memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        offset += 12 + static_cast<size_t>(length);
+    }
+    return !png.idat.empty();
+}
+
+// Bytes of inflated scanline data available to the unfiltering side
+class InflateProgress {
+public:
+    void publish(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        produced = bytes;
+        condition.notify_one();
+    }
+    
+    void finish(bool succeeded) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        failed = !succeeded;
+        condition.notify_one();
+    }
+    
+    // Wait until the given number of bytes was inflated; false if inflating failed first
+    bool waitFor(size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return produced >= bytes || finished; });
+        return produced >= bytes && !failed;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t produced = 0;
+    bool finished = false;
+    bool failed = false;
+};
+
+// Inflate all IDAT data into the scanline buffer, publishing progress after every slice
+bool inflateScanlines(const PngStream& png, uint8_t* scanlines, size_t total, InflateProgress* progress) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+    
+    stream.next_out = scanlines;
+    stream.avail_out = static_cast<uInt>(total);
+    int status = Z_OK;
+    for (size_t i = 0; i < png.idat.size() && status == Z_OK; ++i) {
+        const Chunk& chunk = png.idat[i];
+        for (size_t offset = 0; offset < chunk.length && status == Z_OK; offset += INFLATE_SLICE_BYTES) {
+            stream.next_in = const_cast<Bytef*>(chunk.data + offset);
+            stream.avail_in = static_cast<uInt>(std::min<size_t>(INFLATE_SLICE_BYTES, chunk.length - offset));
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status == Z_BUF_ERROR && stream.avail_out == 0) {
+                status = Z_STREAM_END; // Trailing data after the last scanline
+            }
+            if (progress) {
+                progress->publish(stream.total_out);
+            }
+        }
+    }
+    
+    bool complete = (status == Z_STREAM_END || status == Z_OK) && stream.total_out == total;
+    inflateEnd(&stream);
+    return complete;
+}
+
+uint8_t paeth(int left, int up, int upLeft) {
+    int estimate = left + up - upLeft;
+    int distanceLeft = std::abs(estimate - left);
+    int distanceUp = std::abs(estimate - up);
+    int distanceUpLeft = std::abs(estimate - upLeft);
+    if (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft) return static_cast<uint8_t>(left);
+    if (distanceUp <= distanceUpLeft) return static_cast<uint8_t>(up);
+    return static_cast<uint8_t>(upLeft);
+}
+
+// Undo the filter of one scanline in place; previous is the unfiltered row above or null
+bool unfilterRow(uint8_t filter, uint8_t* row, const uint8_t* previous, size_t rowBytes, int bpp) {
+    switch (filter) {
+        case 0: // None
+            return true;
+        case 1: // Sub
+            for (size_t i = bpp; i < rowBytes; ++i) row[i] += row[i - bpp];
+            return true;
+        case 2: // Up
+            if (previous) {
+                for (size_t i = 0; i < rowBytes; ++i) row[i] += previous[i];
+            }
+            return true;
+        case 3: // Average
+            if (!previous) {
+                for (size_t i = bpp; i < rowBytes; ++i) row[i] += row[i - bpp] >> 1;
+                return true;
+            }
+            for (size_t i = 0; i < static_cast<size_t>(bpp); ++i) row[i] += previous[i] >> 1;
+            for (size_t i = bpp; i < rowBytes; ++i) {
+                row[i] += static_cast<uint8_t>((row[i - bpp] + previous[i]) >> 1);
+            }
+            return true;
+        case 4: // Paeth, which is Sub on the first row
+            if (!previous) {
+                for (size_t i = bpp; i < rowBytes; ++i) row[i] += row[i - bpp];
+                return true;
+            }
+            for (size_t i = 0; i < static_cast<size_t>(bpp); ++i) row[i] += previous[i];
+            for (size_t i = bpp; i < rowBytes; ++i) {
+                row[i] += paeth(row[i - bpp], previous[i], previous[i - bpp]);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Convert one unfiltered row of gray, gray + alpha, RGB or RGBA to BGR or gray
+void convertRow(const uint8_t* source, int sourceChannels, uint8_t* target, int channels, int width) {
+    bool color = sourceChannels >= 3;
+    for (int x = 0; x < width; ++x, source += sourceChannels) {
+        if (channels == 3) {
+            if (color) {
+                target[0] = source[2];
+                target[1] = source[1];
+                target[2] = source[0];
+            } else {
+                target[0] = target[1] = target[2] = source[0];
+            }
+            target += 3;
+        } else {
+            *target++ = color ? static_cast<uint8_t>((source[0] * R_TO_GRAY + source[1] * G_TO_GRAY +
+                                                      source[2] * B_TO_GRAY + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT)
+                              : source[0];
+        }
+    }
+}
+
+// Source of libpng reads from a memory buffer
+struct MemoryReader {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+};
+
+void readFromMemory(png_structp png, png_bytep target, png_size_t length) {
+    MemoryReader* reader = static_cast<MemoryReader*>(png_get_io_ptr(png));
+    if (length > reader->size - reader->offset) {
+        png_error(png, "Truncated PNG");
+    }
+    std::memcpy(target, reader->data + reader->offset, length);
+    reader->offset += length;
+}
+
+// libpng read of decodeWithLibpng. libpng reports errors by longjmp to the setjmp here, after
+// which automatics changed since setjmp are indeterminate, so everything that outlives a failed
+// read (the reader, the gray path's BGR buffer and the row pointers) belongs to the caller
+bool readWithLibpng(png_structp png, png_infop pngInfo, MemoryReader& reader,
+                    std::unique_ptr<uint8_t, void (*)(void*)>& bgr, std::vector<png_bytep>& rows,
+                    uint8_t* pixels, size_t step, int channels) {
+    if (setjmp(png_jmpbuf(png))) {
+        return false;
+    }
+    png_set_read_fn(png, &reader, readFromMemory);
+    png_read_info(png, pngInfo);
+    
+    png_uint_32 width = png_get_image_width(png, pngInfo);
+    png_uint_32 height = png_get_image_height(png, pngInfo);
+    png_set_strip_16(png);
+    png_set_strip_alpha(png);
+    png_set_packing(png);
+    png_set_expand(png);
+    png_set_gray_to_rgb(png);
+    png_set_bgr(png);
+    png_set_interlace_handling(png);
+    png_read_update_info(png, pngInfo);
+    if (png_get_rowbytes(png, pngInfo) != static_cast<size_t>(width) * 3) {
+        return false;
+    }
+    
+    // Gray output is read as BGR first
+    size_t bgrStep = channels == 3 ? step : static_cast<size_t>(width) * 3;
+    uint8_t* target = pixels;
+    if (channels == 1) {
+        bgr.reset(static_cast<uint8_t*>(pooledMalloc(bgrStep * height)));
+        if (!bgr) {
+            return false;
+        }
+        target = bgr.get();
+    }
+    rows.resize(height);
+    for (png_uint_32 y = 0; y < height; ++y) {
+        rows[y] = target + y * bgrStep;
+    }
+    png_read_image(png, rows.data());
+    return true;
+}
+
+// Fallback for 16-bit, low bit depth, paletted and interlaced PNGs. The transforms match
+// cv::imdecode: 16-bit samples are truncated to 8 bits, alpha is stripped, no gamma correction
+bool decodeWithLibpng(const uint8_t* data, size_t size, uint8_t* pixels, size_t step, int channels) {
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop pngInfo = png ? png_create_info_struct(png) : nullptr;
+    if (!pngInfo) {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        return false;
+    }
+    
+    MemoryReader reader = {data, size, 0};
+    std::unique_ptr<uint8_t, void (*)(void*)> bgr(nullptr, pooledFree);
+    std::vector<png_bytep> rows;
+    bool decoded = readWithLibpng(png, pngInfo, reader, bgr, rows, pixels, step, channels);
+    png_uint_32 width = png_get_image_width(png, pngInfo);
+    png_uint_32 height = png_get_image_height(png, pngInfo);
+    png_destroy_read_struct(&png, &pngInfo, nullptr);
+    if (!decoded) {
+        return false;
+    }
+    
+    // Gray output is converted from BGR with the same weights as the direct path
+    if (channels == 1) {
+        size_t bgrStep = static_cast<size_t>(width) * 3;
+        for (png_uint_32 y = 0; y < height; ++y) {
+            const uint8_t* source = bgr.get() + y * bgrStep;
+            uint8_t* gray = pixels + y * step;
+            for (png_uint_32 x = 0; x < width; ++x, source += 3) {
+                gray[x] = static_cast<uint8_t>((source[2] * R_TO_GRAY + source[1] * G_TO_GRAY +
+                                                source[0] * B_TO_GRAY + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT);
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool isPng(const uint8_t* data, size_t size) {
+    return size >= sizeof(PNG_SIGNATURE) && std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0;
+}
+
+bool readPngInfo(const uint8_t* data, size_t size, PngInfo& info) {
+    // Signature, then IHDR: length, type, width, height, depth, color type, compression, filter, interlace
+    if (size < 33 || !isPng(data, size) || std::memcmp(data + 12, "IHDR", 4) != 0) {
+        return false;
+    }
+    
+    uint32_t width = readBigEndian(data + 16);
+    uint32_t height = readBigEndian(data + 20);
+    uint8_t bitDepth = data[24];
+    uint8_t colorType = data[25];
+    uint8_t interlace = data[28];
+    if (width == 0 || height == 0 || width > (1u << 20) || height > (1u << 20)) {
+        return false;
+    }
+    
+    info.width = static_cast<int>(width);
+    info.height = static_cast<int>(height);
+    switch (colorType) {
+        case 0: info.channels = 1; break;
+        case 2: info.channels = 3; break;
+        case 3: info.channels = 3; break; // Palette entries are RGB
+        case 4: info.channels = 2; break;
+        case 6: info.channels = 4; break;
+        default: return false;
+    }
+    info.directPath = bitDepth == 8 && interlace == 0 && colorType != 3;
+    return true;
+}
+
+bool decodePngInto(const uint8_t* data, size_t size, uint8_t* pixels, size_t step,
+                   int channels, PngDecodeMode mode) {
+    PngStream png;
+    if ((channels != 1 && channels != 3) || !parsePng(data, size, png)) {
+        return false;
+    }
+    if (!png.info.directPath) {
+        return decodeWithLibpng(data, size, pixels, step, channels);
+    }
+    
+    // Scanlines are a filter type byte followed by the row's samples
+    const PngInfo& info = png.info;
+    size_t rowBytes = static_cast<size_t>(info.width) * info.channels;
+    size_t stride = rowBytes + 1;
+    size_t total = stride * info.height;
+    std::unique_ptr<uint8_t, void (*)(void*)> scanlines(static_cast<uint8_t*>(pooledMalloc(total)), pooledFree);
+    if (!scanlines) {
+        return false;
+    }
+    
+    InflateProgress progress;
+    std::thread inflater;
+    if (mode == PngDecodeMode::Pipelined) {
+        inflater = std::thread([&] {
+            progress.finish(inflateScanlines(png, scanlines.get(), total, &progress));
+        });
+    } else if (!inflateScanlines(png, scanlines.get(), total, nullptr)) {
+        return false;
+    }
+    
+    bool decoded = true;
+    for (int y = 0; y < info.height && decoded; ++y) {
+        if (mode == PngDecodeMode::Pipelined && !progress.waitFor(stride * (y + 1))) {
+            decoded = false;
+            break;
+        }
+        
+        uint8_t* row = scanlines.get() + stride * y;
+        const uint8_t* previous = y > 0 ? row - stride + 1 : nullptr;
+        decoded = unfilterRow(row[0], row + 1, previous, rowBytes, info.channels);
+        convertRow(row + 1, info.channels, pixels + step * y, channels, info.width);
+    }
+    
+    if (inflater.joinable()) {
+        inflater.join();
+    }
+    return decoded;
+}
+
+cv::Mat decodePng(const cv::Mat& encoded, int channels, PngDecodeMode mode) {
+    PngInfo info;
+    if (encoded.empty() || !readPngInfo(encoded.data, encoded.total(), info)) {
+        return cv::Mat();
+    }
+    
+    cv::Mat image(info.height, info.width, channels == 1 ? CV_8UC1 : CV_8UC3);
+    if (!decodePngInto(encoded.data, encoded.total(), image.data, image.step, channels, mode)) {
+        return cv::Mat();
+    }
+    return image;
+}
+
+} // namespace frame_pipeline
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace frame_pipeline {
+
+/**
+ * @brief How a PNG is decoded
+ */
+enum class PngDecodeMode {
+    Serial,   // Inflate and unfilter on the calling thread
+    Pipelined // Inflate on a helper thread while the caller unfilters and converts finished rows
+};
+
+/**
+ * @brief Dimensions of a PNG image
+ */
+struct PngInfo {
+    int width = 0;
+    int height = 0;
+    int channels = 0;      // Channels stored in the file: 1 gray, 2 gray + alpha, 3 RGB, 4 RGBA
+    bool directPath = false; // 8-bit, non-interlaced and not paletted: decoded without libpng
+};
+
+/**
+ * @brief Check the PNG signature
+ */
+bool isPng(const uint8_t* data, size_t size);
+
+/**
+ * @brief Read the IHDR chunk of a PNG
+ * @return False if the data is not a PNG
+ */
+bool readPngInfo(const uint8_t* data, size_t size, PngInfo& info);
+
+/**
+ * @brief Decode a PNG into caller-provided BGR or gray pixels
+ *
+ * 8-bit non-interlaced gray, RGB and RGBA images (the KITTI-360 frames) are
+ * inflated with zlib straight into a pooled scanline buffer, unfiltered in
+ * place and converted to the output layout row by row; alpha is dropped and
+ * gray uses the cv::COLOR_BGR2GRAY weights. In pipelined mode a helper
+ * thread inflates while the calling thread unfilters the rows already
+ * inflated, which shortens the latency of a single frame. Other PNGs are
+ * decoded by libpng on the calling thread with the transforms cv::imdecode uses.
+ * @param data PNG file contents
+ * @param size Size of data
+ * @param pixels Output of readPngInfo() width x height pixels
+ * @param step Bytes between output rows
+ * @param channels 3 for BGR, 1 for gray
+ * @param mode Serial or pipelined decode
+ * @return False if the data is not a valid PNG
+ */
+bool decodePngInto(const uint8_t* data, size_t size, uint8_t* pixels, size_t step,
+                   int channels, PngDecodeMode mode = PngDecodeMode::Serial);
+
+/**
+ * @brief Decode a PNG into a BGR (CV_8UC3) or gray (CV_8UC1) Mat from the default allocator
+ * @param encoded PNG file contents (1xN CV_8UC1)
+ * @param channels 3 for BGR, 1 for gray
+ * @param mode Serial or pipelined decode
+ * @return Decoded image, or an empty Mat if the data is not a valid PNG
+ */
+cv::Mat decodePng(const cv::Mat& encoded, int channels, PngDecodeMode mode = PngDecodeMode::Serial);
+
+} // namespace frame_pipeline
@@ -0,0 +1,434 @@
+#include "sequence_index.h"
+#include "frame_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace frame_pipeline {
+
+namespace {
+
+const char SEQUENCE_INDEX_MAGIC[8] = {'K', '3', '6', '0', 'S', 'E', 'Q', '\0'};
+
+// Modification stamps the cached index is validated against
+struct DirectoryStamp {
+    int64_t directoryTime;
+    int64_t timestampsTime; // -1 if the camera has no timestamps.txt
+    int64_t timestampsSize;
+    
+    bool operator==(const DirectoryStamp& other) const {
+        return directoryTime == other.directoryTime && timestampsTime == other.timestampsTime &&
+               timestampsSize == other.timestampsSize;
+    }
+};
+
+uint64_t hashBytes(uint64_t hash, const void* bytes, size_t size) {
+    const unsigned char* data = static_cast<const unsigned char*>(bytes);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+int64_t daysFromCivil(int64_t year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Fixed-width decimal field; advances p past it
+bool parseField(const char*& p, const char* end, int digits, int64_t& value) {
+    if (end - p < digits) return false;
+    value = 0;
+    for (int i = 0; i < digits; ++i, ++p) {
+        if (*p < '0' || *p > '9') return false;
+        value = value * 10 + (*p - '0');
+    }
+    return true;
+}
+
+bool expect(const char*& p, const char* end, char c) {
+    if (p == end || *p != c) return false;
+    ++p;
+    return true;
+}
+
+// Frame number of a file stem made of digits only (KITTI's 0000000042), or -1
+int64_t frameNumber(const std::string& stem) {
+    if (stem.empty() || stem.size() > 10) return -1;
+    int64_t number = 0;
+    for (char c : stem) {
+        if (c < '0' || c > '9') return -1;
+        number = number * 10 + (c - '0');
+    }
+    return number;
+}
+
+// Frame files of a directory as stem -> file name
+std::map<std::string, std::string> listFrames(const std::string& directory) {
+    std::map<std::string, std::string> frames;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (!entry.is_regular_file()) continue;
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension == ".jpg" || extension == ".jpeg" || extension == ".png") {
+            frames.emplace(entry.path().stem().string(), entry.path().filename().string());
+        }
+    }
+    return frames;
+}
+
+DirectoryStamp directoryStamp(const std::string& directory, const std::string& timestampsPath) {
+    DirectoryStamp stamp{static_cast<int64_t>(fs::last_write_time(directory).time_since_epoch().count()), -1, -1};
+    if (!timestampsPath.empty()) {
+        stamp.timestampsTime = static_cast<int64_t>(fs::last_write_time(timestampsPath).time_since_epoch().count());
+        stamp.timestampsSize = static_cast<int64_t>(fs::file_size(timestampsPath));
+    }
+    return stamp;
+}
+
+std::string cachePath(const std::string& cacheDirectory, const std::vector<std::string>& directories,
+                      int64_t toleranceNs) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const std::string& directory : directories) {
+        std::string canonical = fs::weakly_canonical(directory).string();
+        hash = hashBytes(hash, canonical.data(), canonical.size() + 1);
+    }
+    hash = hashBytes(hash, &toleranceNs, sizeof(toleranceNs));
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.k360seq", static_cast<unsigned long long>(hash));
+    return (fs::path(cacheDirectory) / name).string();
+}
+
+// Bounds-checked reader over a cached index
+class IndexReader {
+public:
+    IndexReader(const uchar* data, size_t size) : p(data), end(data + size) {}
+    
+    template <typename T>
+    bool read(T& value) {
+        if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+    
+    bool readString(std::string& value) {
+        uint32_t length;
+        if (!read(length) || static_cast<size_t>(end - p) < length) return false;
+        value.assign(reinterpret_cast<const char*>(p), length);
+        p += length;
+        return true;
+    }
+    
+private:
+    const uchar* p;
+    const uchar* end;
+};
+
+bool readCachedIndex(const std::string& path, const std::vector<std::string>& directories, int64_t toleranceNs,
+                     const std::vector<DirectoryStamp>& stamps, SequenceIndex& index) {
+    cv::Mat contents = readEncodedFile(path);
+    if (contents.empty()) return false;
+    IndexReader reader(contents.data, contents.total());
+    
+    char magic[8];
+    uint32_t version, cameraCount;
+    int64_t tolerance;
+    if (!reader.read(magic) || std::memcmp(magic, SEQUENCE_INDEX_MAGIC, sizeof(magic)) != 0 ||
+        !reader.read(version) || version != SEQUENCE_INDEX_VERSION ||
+        !reader.read(cameraCount) || cameraCount != directories.size() ||
+        !reader.read(tolerance) || tolerance != toleranceNs) {
+        return false;
+    }
+    for (const DirectoryStamp& expected : stamps) {
+        DirectoryStamp stamp;
+        if (!reader.read(stamp) || !(stamp == expected)) return false;
+    }
+    
+    uint8_t synchronized;
+    uint64_t setCount;
+    if (!reader.read(synchronized)) return false;
+    index.cameraFrames.assign(cameraCount, 0);
+    for (size_t& frames : index.cameraFrames) {
+        uint64_t count;
+        if (!reader.read(count)) return false;
+        frames = static_cast<size_t>(count);
+    }
+    if (!reader.read(setCount) || setCount > contents.total()) return false;
+    
+    index.timestampSynchronized = synchronized != 0;
+    index.frameSets.resize(static_cast<size_t>(setCount));
+    std::string name;
+    for (SequenceFrameSet& frameSet : index.frameSets) {
+        if (!reader.read(frameSet.timestamp)) return false;
+        frameSet.filenames.resize(cameraCount);
+        for (uint32_t camera = 0; camera < cameraCount; ++camera) {
+            if (!reader.readString(name)) return false;
+            frameSet.filenames[camera] = (fs::path(directories[camera]) / name).string();
+        }
+        frameSet.baseName = fs::path(frameSet.filenames[0]).stem().string();
+    }
+    return true;
+}
+
+template <typename T>
+void writeValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Written next to its destination and renamed into place, like map packages
+void writeCachedIndex(const std::string& path, int64_t toleranceNs, const std::vector<DirectoryStamp>& stamps,
+                      const SequenceIndex& index) {
+    fs::create_directories(fs::path(path).parent_path());
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file.write(SEQUENCE_INDEX_MAGIC, sizeof(SEQUENCE_INDEX_MAGIC));
+        writeValue(file, SEQUENCE_INDEX_VERSION);
+        writeValue(file, static_cast<uint32_t>(stamps.size()));
+        writeValue(file, toleranceNs);
+        for (const DirectoryStamp& stamp : stamps) {
+            writeValue(file, stamp);
+        }
+        writeValue(file, static_cast<uint8_t>(index.timestampSynchronized));
+        for (size_t frames : index.cameraFrames) {
+            writeValue(file, static_cast<uint64_t>(frames));
+        }
+        writeValue(file, static_cast<uint64_t>(index.frameSets.size()));
+        for (const SequenceFrameSet& frameSet : index.frameSets) {
+            writeValue(file, frameSet.timestamp);
+            for (const std::string& filename : frameSet.filenames) {
+                std::string name = fs::path(filename).filename().string();
+                writeValue(file, static_cast<uint32_t>(name.size()));
+                file.write(name.data(), static_cast<std::streamsize>(name.size()));
+            }
+        }
+        if (!file) {
+            file.close();
+            fs::remove(temporary);
+            return;
+        }
+    }
+    fs::rename(temporary, path);
+}
+
+} // namespace
+
+std::vector<int64_t> parseTimestamps(const char* data, size_t size) {
+    const char* p = data;
+    const char* end = data + size;
+    std::vector<int64_t> timestamps;
+    timestamps.reserve(static_cast<size_t>(std::count(p, end, '\n')) + 1);
+    
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!lineEnd) lineEnd = end;
+        const char* fieldEnd = lineEnd;
+        while (fieldEnd > p && (fieldEnd[-1] == '\r' || fieldEnd[-1] == ' ')) --fieldEnd;
+        
+        if (fieldEnd > p) {
+            int64_t year, month, day, hour, minute, second, fraction = 0;
+            const char* q = p;
+            bool valid = parseField(q, fieldEnd, 4, year) && expect(q, fieldEnd, '-') &&
+                         parseField(q, fieldEnd, 2, month) && expect(q, fieldEnd, '-') &&
+                         parseField(q, fieldEnd, 2, day) && expect(q, fieldEnd, ' ') &&
+                         parseField(q, fieldEnd, 2, hour) && expect(q, fieldEnd, ':') &&
+                         parseField(q, fieldEnd, 2, minute) && expect(q, fieldEnd, ':') &&
+                         parseField(q, fieldEnd, 2, second) &&
+                         month >= 1 && month <= 12 && day >= 1 && day <= 31;
+            if (valid && q < fieldEnd) {
+                // Fractions of any length up to nanoseconds
+                valid = expect(q, fieldEnd, '.');
+                int digits = static_cast<int>(fieldEnd - q);
+                valid = valid && digits >= 1 && digits <= 9 && parseField(q, fieldEnd, digits, fraction);
+                for (int i = digits; valid && i < 9; ++i) fraction *= 10;
+            }
+            if (!valid) {
+                throw std::runtime_error("Malformed timestamp on line " + std::to_string(timestamps.size() + 1) +
+                                         ": " + std::string(p, fieldEnd));
+            }
+            int64_t seconds = daysFromCivil(year, static_cast<int>(month), static_cast<int>(day)) * 86400 +
+                              hour * 3600 + minute * 60 + second;
+            timestamps.push_back(seconds * 1000000000LL + fraction);
+        }
+        p = lineEnd + 1;
+    }
+    return timestamps;
+}
+
+std::vector<int64_t> loadTimestamps(const std::string& filename) {
+    cv::Mat contents = mapEncodedFile(filename);
+    if (contents.empty()) {
+        if (fs::is_regular_file(filename) && fs::file_size(filename) == 0) {
+            return {};
+        }
+        throw std::runtime_error("Cannot read " + filename);
+    }
+    try {
+        return parseTimestamps(reinterpret_cast<const char*>(contents.data), contents.total());
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
+
+std::string timestampsPathForDirectory(const std::string& frameDirectory) {
+    fs::path directory(frameDirectory);
+    if (!directory.has_filename()) directory = directory.parent_path();
+    for (const fs::path& candidate : {directory / "timestamps.txt", directory.parent_path() / "timestamps.txt"}) {
+        std::error_code error;
+        if (fs::is_regular_file(candidate, error)) {
+            return candidate.string();
+        }
+    }
+    return "";
+}
+
+std::vector<std::vector<uint32_t>> synchronizeFrames(std::vector<std::vector<TimedFrame>> cameras,
+                                                     int64_t toleranceNs) {
+    std::vector<std::vector<uint32_t>> frameSets;
+    if (cameras.empty()) return frameSets;
+    
+    // Timestamps files are in order; sorting is only paid for when they are not
+    auto earlier = [](const TimedFrame& a, const TimedFrame& b) { return a.timestamp < b.timestamp; };
+    for (std::vector<TimedFrame>& frames : cameras) {
+        if (!std::is_sorted(frames.begin(), frames.end(), earlier)) {
+            std::stable_sort(frames.begin(), frames.end(), earlier);
+        }
+    }
+    
+    // Reference times only increase, so every other camera's cursor only moves forward
+    std::vector<size_t> cursor(cameras.size(), 0);
+    std::vector<uint32_t> frameSet(cameras.size());
+    frameSets.reserve(cameras[0].size());
+    for (const TimedFrame& reference : cameras[0]) {
+        frameSet[0] = reference.frame;
+        bool complete = true;
+        for (size_t camera = 1; camera < cameras.size() && complete; ++camera) {
+            const std::vector<TimedFrame>& frames = cameras[camera];
+            if (frames.empty()) {
+                complete = false;
+                break;
+            }
+            size_t& j = cursor[camera];
+            while (j + 1 < frames.size() && frames[j + 1].timestamp <= reference.timestamp) ++j;
+            
+            // Nearest of the last frame at or before the reference and the first after it
+            size_t nearest = j;
+            if (j + 1 < frames.size() &&
+                std::llabs(frames[j + 1].timestamp - reference.timestamp) < std::llabs(frames[j].timestamp - reference.timestamp)) {
+                nearest = j + 1;
+            }
+            complete = std::llabs(frames[nearest].timestamp - reference.timestamp) <= toleranceNs;
+            frameSet[camera] = frames[nearest].frame;
+        }
+        if (complete) {
+            frameSets.push_back(frameSet);
+        }
+    }
+    return frameSets;
+}
+
+SequenceIndex loadSequenceIndex(const std::vector<std::string>& directories, int64_t toleranceNs,
+                                const std::string& cacheDirectory) {
+    SequenceIndex index;
+    if (directories.empty()) return index;
+    
+    std::vector<std::string> timestampsPaths;
+    std::vector<DirectoryStamp> stamps;
+    bool allTimestamped = true;
+    for (const std::string& directory : directories) {
+        timestampsPaths.push_back(timestampsPathForDirectory(directory));
+        stamps.push_back(directoryStamp(directory, timestampsPaths.back()));
+        allTimestamped = allTimestamped && !timestampsPaths.back().empty();
+    }
+    
+    std::string path;
+    if (!cacheDirectory.empty()) {
+        path = cachePath(cacheDirectory, directories, toleranceNs);
+        if (readCachedIndex(path, directories, toleranceNs, stamps, index)) {
+            index.fromCache = true;
+            return index;
+        }
+        index = SequenceIndex();
+    }
+    
+    std::vector<std::map<std::string, std::string>> cameraFiles;
+    for (const std::string& directory : directories) {
+        cameraFiles.push_back(listFrames(directory));
+        index.cameraFrames.push_back(cameraFiles.back().size());
+    }
+    
+    auto framePath = [&](size_t camera, const std::string& name) {
+        return (fs::path(directories[camera]) / name).string();
+    };
+    
+    if (allTimestamped) {
+        // Frame number -> file, for frames that have a timestamp
+        std::vector<std::vector<const std::string*>> numbered(directories.size());
+        std::vector<std::vector<TimedFrame>> timedFrames(directories.size());
+        std::vector<std::vector<int64_t>> timestamps(directories.size());
+        for (size_t camera = 0; camera < directories.size(); ++camera) {
+            timestamps[camera] = loadTimestamps(timestampsPaths[camera]);
+            numbered[camera].assign(timestamps[camera].size(), nullptr);
+            for (const auto& [stem, name] : cameraFiles[camera]) {
+                int64_t frame = frameNumber(stem);
+                if (frame < 0 || frame >= static_cast<int64_t>(timestamps[camera].size())) continue;
+                numbered[camera][frame] = &name;
+                timedFrames[camera].push_back({timestamps[camera][frame], static_cast<uint32_t>(frame)});
+            }
+        }
+        
+        for (const std::vector<uint32_t>& frames : synchronizeFrames(std::move(timedFrames), toleranceNs)) {
+            SequenceFrameSet frameSet;
+            for (size_t camera = 0; camera < frames.size(); ++camera) {
+                frameSet.filenames.push_back(framePath(camera, *numbered[camera][frames[camera]]));
+            }
+            frameSet.baseName = fs::path(frameSet.filenames[0]).stem().string();
+            frameSet.timestamp = timestamps[0][frames[0]];
+            index.frameSets.push_back(std::move(frameSet));
+        }
+        index.timestampSynchronized = true;
+    } else {
+        // Stems are iterated in ascending order, so frame sets are sorted by name
+        for (const auto& [stem, name] : cameraFiles[0]) {
+            SequenceFrameSet frameSet;
+            frameSet.baseName = stem;
+            frameSet.timestamp = 0;
+            frameSet.filenames.push_back(framePath(0, name));
+            for (size_t camera = 1; camera < directories.size(); ++camera) {
+                auto match = cameraFiles[camera].find(stem);
+                if (match == cameraFiles[camera].end()) break;
+                frameSet.filenames.push_back(framePath(camera, match->second));
+            }
+            if (frameSet.filenames.size() == directories.size()) {
+                index.frameSets.push_back(std::move(frameSet));
+            }
+        }
+    }
+    
+    // An index that cannot be cached is still valid
+    if (!path.empty()) {
+        try {
+            writeCachedIndex(path, toleranceNs, stamps, index);
+        } catch (const fs::filesystem_error&) {
+        }
+    }
+    return index;
+}
+
+} // namespace frame_pipeline
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Default largest timestamp difference between frames of one frame set
+ *
+ * A fifth of KITTI-360's 10 Hz frame period: camera triggers are a few
+ * milliseconds apart, so frames a full period apart are never joined.
+ */
+const int64_t DEFAULT_SYNC_TOLERANCE_NS = 20000000;
+
+/**
+ * @brief Version of the on-disk sequence index format
+ *
+ * Bump whenever the file layout changes; indexes of another version are
+ * rebuilt.
+ */
+const uint32_t SEQUENCE_INDEX_VERSION = 1;
+
+/**
+ * @brief Parse KITTI timestamps ("YYYY-MM-DD HH:MM:SS.fffffffff" per line)
+ * @param data Text of a timestamps.txt
+ * @param size Bytes of text
+ * @return Nanoseconds since the Unix epoch (UTC), one per line; line i is frame i
+ * @throws std::runtime_error if a line is malformed
+ */
+std::vector<int64_t> parseTimestamps(const char* data, size_t size);
+
+/**
+ * @brief Memory-map and parse a timestamps.txt
+ * @throws std::runtime_error if the file cannot be read or a line is malformed
+ */
+std::vector<int64_t> loadTimestamps(const std::string& filename);
+
+/**
+ * @brief timestamps.txt of a frame directory
+ *
+ * KITTI-360 keeps it next to the frames' directory (image_00/timestamps.txt
+ * for image_00/data_rect); a timestamps.txt inside the directory is used too.
+ * @return Path of the file, or an empty string if there is none
+ */
+std::string timestampsPathForDirectory(const std::string& frameDirectory);
+
+/**
+ * @brief Frame of a camera at a point in time
+ */
+struct TimedFrame {
+    int64_t timestamp; // Nanoseconds since the Unix epoch
+    uint32_t frame;    // Frame number (line of timestamps.txt)
+};
+
+/**
+ * @brief Join the frames of several cameras by nearest timestamp
+ *
+ * Camera 0 is the reference. Each camera's frames are sorted by time, then a
+ * single forward merge finds, for every reference frame, the nearest frame
+ * of every other camera; the reference frame forms a frame set if all of
+ * them lie within the tolerance. Frames dropped by one camera therefore only
+ * drop their own frame set, and cameras running at other rates are joined
+ * to their nearest frame. Runs in O(n log n) for unsorted input and O(n) for
+ * already sorted input.
+ * @param cameras Frames of each camera, in any order
+ * @param toleranceNs Largest accepted timestamp difference to the reference frame
+ * @return Per frame set in reference time order, the frame number of each camera
+ */
+std::vector<std::vector<uint32_t>> synchronizeFrames(std::vector<std::vector<TimedFrame>> cameras,
+                                                     int64_t toleranceNs);
+
+/**
+ * @brief Frames of all cameras that were taken together
+ */
+struct SequenceFrameSet {
+    std::vector<std::string> filenames; // One per camera
+    std::string baseName;               // Reference camera's file stem
+    int64_t timestamp;                  // Reference camera's, in nanoseconds; 0 when joined by name
+};
+
+/**
+ * @brief Synchronized frame sets of a multi-camera sequence
+ */
+struct SequenceIndex {
+    std::vector<SequenceFrameSet> frameSets; // In time (or name) order
+    std::vector<size_t> cameraFrames;        // Frame files found per camera
+    bool timestampSynchronized = false;      // Joined by timestamps.txt rather than by file stem
+    bool fromCache = false;                  // Read from the index cache rather than built
+};
+
+/**
+ * @brief Build or load the frame sets of a multi-camera sequence
+ *
+ * Frame files (.png, .jpg, .jpeg) are numbered by their stem, which is the
+ * line of their timestamp in the camera's timestamps.txt. If every camera
+ * has a timestamps.txt, frames are joined with synchronizeFrames(); otherwise
+ * frames with the same stem form a frame set.
+ *
+ * Listing 100k-frame directories dominates the cost, so the result is
+ * written to the cache directory and reused while the directories and
+ * timestamps.txt files keep their modification times and sizes.
+ * @param directories Frame directory of each camera
+ * @param toleranceNs Largest timestamp difference within a frame set
+ * @param cacheDirectory Directory of cached indexes, or empty to always build
+ * @return Frame sets, possibly empty
+ * @throws std::runtime_error if a directory cannot be listed or a timestamps.txt is malformed
+ */
+SequenceIndex loadSequenceIndex(const std::vector<std::string>& directories,
+                                int64_t toleranceNs = DEFAULT_SYNC_TOLERANCE_NS,
+                                const std::string& cacheDirectory = "");
+
+} // namespace frame_pipeline
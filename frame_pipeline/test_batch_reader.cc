@@ -0,0 +1,59 @@
+#include "batch_reader.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+int main() {
+    try {
+        frame_pipeline::BatchFileReader reader(4);
+        std::cout << "Batch reader backend: " << reader.backendName() << std::endl;
+        
+        // More files than the queue depth, of different sizes, with a missing one in between
+        std::vector<std::string> filenames;
+        std::vector<std::string> contents;
+        for (int i = 0; i < 9; ++i) {
+            std::string path = "test_batch_reader_" + std::to_string(i) + ".bin";
+            std::string bytes(static_cast<size_t>(1 + i * 300007), static_cast<char>('a' + i));
+            if (i != 4) {
+                std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+            } else {
+                bytes.clear();
+            }
+            filenames.push_back(path);
+            contents.push_back(bytes);
+        }
+        
+        std::cout << "Reading " << filenames.size() << " files..." << std::endl;
+        std::vector<int> calls(filenames.size(), 0);
+        bool matches = true;
+        reader.readFiles(filenames, [&](size_t i, const cv::Mat& read) {
+            ++calls[i];
+            matches = matches && read.total() == contents[i].size() &&
+                      (read.empty() || std::equal(contents[i].begin(), contents[i].end(), read.data));
+        });
+        
+        for (const std::string& path : filenames) {
+            std::remove(path.c_str());
+        }
+        
+        for (int count : calls) {
+            if (count != 1) {
+                std::cerr << "Every file must be reported exactly once" << std::endl;
+                return 1;
+            }
+        }
+        if (!matches) {
+            std::cerr << "Batch read contents differ" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Batch reads match the files" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
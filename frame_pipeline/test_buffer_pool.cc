@@ -0,0 +1,108 @@
+#include "buffer_pool.h"
+#include "huge_pages.h"
+#include <cstdint>
+#include <iostream>
+#include <cstring>
+
+int main() {
+    try {
+        // Size classes leave at most 25% slack and are page aligned
+        std::cout << "Checking size classes..." << std::endl;
+        const size_t frameBytes = 1400 * 1400 * 3;
+        size_t frameClass = frame_pipeline::BufferPool::sizeClass(frameBytes);
+        std::cout << "1400x1400 BGR frame (" << frameBytes << " bytes) -> " << frameClass << " bytes" << std::endl;
+        if (frameClass < frameBytes || frameClass > frameBytes * 5 / 4 + 4096 || frameClass % 4096 != 0) {
+            std::cerr << "Unexpected size class" << std::endl;
+            return 1;
+        }
+        
+        // Classes of 2 MB and up are whole huge pages, served 2 MB aligned
+        if (frameClass % frame_pipeline::HUGE_PAGE_BYTES != 0) {
+            std::cerr << "Large size class is not a whole number of huge pages" << std::endl;
+            return 1;
+        }
+        
+        // A released buffer is handed out again for the same class
+        frame_pipeline::BufferPool pool(64 << 20);
+        size_t capacity;
+        void* first = pool.acquire(frameBytes, capacity);
+        pool.release(first, capacity);
+        void* second = pool.acquire(frameBytes - 100, capacity);
+        frame_pipeline::BufferPoolStats stats = pool.stats();
+        if (second != first || stats.hits != 1 || stats.misses != 1 || stats.outstandingBytes != capacity) {
+            std::cerr << "Released buffer was not reused" << std::endl;
+            return 1;
+        }
+        if (reinterpret_cast<uintptr_t>(second) % frame_pipeline::HUGE_PAGE_BYTES != 0) {
+            std::cerr << "Huge-page buffer is not 2 MB aligned" << std::endl;
+            return 1;
+        }
+        std::cout << "Huge-page allocations: " << stats.hugePageMisses << std::endl;
+        pool.release(second, capacity);
+        
+        // Without huge pages the same classes come from the heap
+        frame_pipeline::BufferPool regularPool(64 << 20, false);
+        void* regular = regularPool.acquire(frameBytes, capacity);
+        if (!regular || regularPool.stats().hugePageMisses != 0) {
+            std::cerr << "Huge pages used although disabled" << std::endl;
+            return 1;
+        }
+        regularPool.release(regular, capacity);
+        
+        // Mats drawn from the pool reuse buffers once released, small Mats bypass it
+        std::cout << "Allocating frames through the pooled cv::MatAllocator..." << std::endl;
+        uchar* previous = nullptr;
+        for (int i = 0; i < 3; ++i) {
+            cv::Mat frame;
+            frame.allocator = pool.matAllocator();
+            frame.create(1400, 1400, CV_8UC3);
+            frame.setTo(cv::Scalar(i, i, i));
+            if (previous && frame.data != previous) {
+                std::cerr << "Pooled Mat did not reuse its buffer" << std::endl;
+                return 1;
+            }
+            previous = frame.data;
+        }
+        
+        cv::Mat small;
+        small.allocator = pool.matAllocator();
+        small.create(8, 8, CV_8UC1);
+        stats = pool.stats();
+        std::cout << "Hits: " << stats.hits << ", misses: " << stats.misses
+                  << ", pooled: " << stats.pooledBytes << " bytes" << std::endl;
+        if (stats.misses != 1 || stats.hits != 4) {
+            std::cerr << "Unexpected pool statistics" << std::endl;
+            return 1;
+        }
+        
+        // Buffers over the retain limit are freed instead of pooled
+        pool.setRetainLimit(0);
+        if (pool.stats().pooledBytes != 0) {
+            std::cerr << "Retain limit was not enforced" << std::endl;
+            return 1;
+        }
+        
+        // malloc-compatible entry points keep contents across realloc
+        char* block = static_cast<char*>(frame_pipeline::pooledMalloc(1 << 20));
+        std::memset(block, 42, 1 << 20);
+        block = static_cast<char*>(frame_pipeline::pooledRealloc(block, 4 << 20));
+        bool kept = block[(1 << 20) - 1] == 42;
+        frame_pipeline::pooledFree(block);
+        
+        char* zeroed = static_cast<char*>(frame_pipeline::pooledCalloc(16, 8));
+        kept = kept && zeroed[127] == 0;
+        frame_pipeline::pooledFree(zeroed);
+        if (!kept) {
+            std::cerr << "pooledRealloc or pooledCalloc lost data" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Buffer pool reuses frame buffers" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "disparity.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Median of the known disparities inside the region the matcher can search
+double medianDisparity(const cv::Mat& disparity, int margin) {
+    std::vector<short> values;
+    for (int y = margin; y < disparity.rows - margin; ++y) {
+        for (int x = margin + 64; x < disparity.cols - margin; ++x) {
+            short value = disparity.at<short>(y, x);
+            if (value >= 0) values.push_back(value);
+        }
+    }
+    if (values.empty()) return -1.0;
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main() {
+    try {
+        // Textured scene seen by the right camera 24 pixels further left
+        std::cout << "Matching a synthetic stereo pair..." << std::endl;
+        const int shift = 24;
+        cv::Mat texture(376, 704 + shift, CV_8UC1);
+        cv::randu(texture, cv::Scalar::all(0), cv::Scalar::all(255));
+        cv::GaussianBlur(texture, texture, cv::Size(3, 3), 0.0);
+        cv::Mat left = texture(cv::Rect(shift, 0, 704, 376)).clone();
+        cv::Mat right = texture(cv::Rect(0, 0, 704, 376)).clone();
+        
+        for (bool semiGlobal : {true, false}) {
+            for (int scale : {1, 2}) {
+                frame_pipeline::DisparitySettings settings;
+                settings.numDisparities = 64;
+                settings.semiGlobal = semiGlobal;
+                settings.scaleDenominator = scale;
+                cv::Mat disparity = frame_pipeline::computeDisparity(left, right, settings);
+                
+                if (disparity.type() != CV_16S || disparity.size() != cv::Size(left.cols / scale, left.rows / scale)) {
+                    std::cerr << "Disparity has the wrong size or type" << std::endl;
+                    return 1;
+                }
+                double median = medianDisparity(disparity, 8) / 16.0;
+                std::cout << (semiGlobal ? "  SGBM" : "  BM") << " at 1/" << scale << ": median disparity "
+                          << median << " (expected " << shift / scale << ")" << std::endl;
+                if (std::abs(median - static_cast<double>(shift) / scale) > 0.5) {
+                    std::cerr << "Disparity does not match the shift" << std::endl;
+                    return 1;
+                }
+            }
+        }
+        
+        // Search ranges shrink with the scale but stay multiples of 16
+        frame_pipeline::DisparitySettings settings;
+        settings.numDisparities = 128;
+        settings.scaleDenominator = 2;
+        if (frame_pipeline::scaledDisparities(settings) != 64) {
+            std::cerr << "Scaled disparity range is wrong" << std::endl;
+            return 1;
+        }
+        settings.scaleDenominator = 16;
+        if (frame_pipeline::scaledDisparities(settings) != 16) {
+            std::cerr << "Scaled disparity range is below the minimum" << std::endl;
+            return 1;
+        }
+        
+        // Unknown pixels are black, known ones coloured
+        cv::Mat disparity(10, 10, CV_16S, cv::Scalar(16 * 32));
+        disparity(cv::Rect(0, 0, 5, 10)).setTo(-16);
+        cv::Mat colored = frame_pipeline::colorizeDisparity(disparity, 64);
+        cv::Mat gray = frame_pipeline::disparityToGray(disparity, 64);
+        if (colored.type() != CV_8UC3 || colored.at<cv::Vec3b>(0, 0) != cv::Vec3b(0, 0, 0) ||
+            colored.at<cv::Vec3b>(0, 9) == cv::Vec3b(0, 0, 0) || gray.at<uchar>(0, 0) != 0 || gray.at<uchar>(0, 9) == 0) {
+            std::cerr << "Disparity colouring is wrong" << std::endl;
+            return 1;
+        }
+        
+        try {
+            frame_pipeline::computeDisparity(left, right(cv::Rect(0, 0, 700, 376)), frame_pipeline::DisparitySettings());
+            std::cerr << "Differently sized images were accepted" << std::endl;
+            return 1;
+        } catch (const std::runtime_error&) {
+        }
+        
+        std::cout << "Disparity matches the synthetic shift" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
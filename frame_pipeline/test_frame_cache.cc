@@ -0,0 +1,119 @@
+#include "frame_cache.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+
+int main() {
+    try {
+        // 1 MB frames in a 3 MB tier: the fourth insert evicts the least recently used
+        std::cout << "Filling a 3 MB tier with 1 MB frames..." << std::endl;
+        frame_pipeline::ImageLru tier(3 << 20);
+        cv::Mat frame(1024, 1024, CV_8UC1, cv::Scalar(7));
+        
+        for (size_t i = 0; i < 3; ++i) {
+            tier.put({i, 0}, frame.clone());
+        }
+        
+        cv::Mat image;
+        if (!tier.get({0, 0}, image) || image.at<uchar>(0, 0) != 7) {
+            std::cerr << "Cached frame missing or corrupted" << std::endl;
+            return 1;
+        }
+        
+        tier.put({3, 0}, frame.clone());
+        if (tier.contains({1, 0}) || !tier.contains({0, 0}) || !tier.contains({3, 0})) {
+            std::cerr << "Eviction did not follow recency" << std::endl;
+            return 1;
+        }
+        
+        frame_pipeline::TierStats stats = tier.stats();
+        std::cout << "Entries: " << stats.entries << ", bytes: " << stats.bytes
+                  << ", evictions: " << stats.evictions << std::endl;
+        if (stats.bytes > stats.budgetBytes || stats.evictions != 1 || stats.hits != 1) {
+            std::cerr << "Unexpected tier statistics" << std::endl;
+            return 1;
+        }
+        
+        // Generations tell current entries from outdated ones
+        uint64_t generation = 0;
+        tier.put({0, 1}, frame.clone(), 5);
+        if (!tier.contains({0, 1}, &generation) || generation != 5) {
+            std::cerr << "Entry generation was not kept" << std::endl;
+            return 1;
+        }
+        
+        // Shrinking the budget evicts, oversized frames are not cached
+        tier.setBudget(1 << 20);
+        if (tier.stats().entries != 1) {
+            std::cerr << "Shrinking the budget did not evict" << std::endl;
+            return 1;
+        }
+        tier.put({9, 0}, cv::Mat(2048, 1024, CV_8UC1));
+        if (tier.contains({9, 0})) {
+            std::cerr << "Frame larger than the budget was cached" << std::endl;
+            return 1;
+        }
+        
+        // Evicted frames held by a caller stay valid
+        if (image.empty() || image.at<uchar>(1023, 1023) != 7) {
+            std::cerr << "Evicted frame was invalidated" << std::endl;
+            return 1;
+        }
+        
+        // Filling without eviction stops at the budget
+        frame_pipeline::ImageLru store(2 << 20);
+        bool first = store.putIfRoom({0, 0}, frame.clone());
+        bool second = store.putIfRoom({1, 0}, frame.clone());
+        bool third = store.putIfRoom({2, 0}, frame.clone());
+        if (!first || !second || third || store.stats().evictions != 0) {
+            std::cerr << "putIfRoom evicted or overfilled the tier" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Frame cache respects budgets and recency" << std::endl << std::endl;
+        
+        // Encoded files are read back byte for byte
+        std::cout << "Reading an encoded file..." << std::endl;
+        const std::string path = "test_encoded_frame.bin";
+        std::string bytes(3 << 20, '\0');
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = static_cast<char>(i * 31);
+        }
+        std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+        
+        // Readahead advice is only issued for files that exist
+        bool advised = frame_pipeline::adviseWillNeed(path);
+        cv::Mat encoded = frame_pipeline::readEncodedFile(path);
+        cv::Mat mapped = frame_pipeline::mapEncodedFile(path);
+        std::remove(path.c_str());
+        
+        // A mapped file stays readable through its copies after the original Mat and the file are gone
+        cv::Mat mappedCopy = mapped;
+        mapped.release();
+        if (mappedCopy.total() != bytes.size() || !std::equal(bytes.begin(), bytes.end(), mappedCopy.data) ||
+            !frame_pipeline::mapEncodedFile(path).empty()) {
+            std::cerr << "Mapped file contents differ" << std::endl;
+            return 1;
+        }
+        mappedCopy.release();
+        
+        if (frame_pipeline::adviseWillNeed(path)) {
+            std::cerr << "Readahead advised for a missing file" << std::endl;
+            return 1;
+        }
+        std::cout << "Readahead advice " << (advised ? "issued" : "unsupported") << std::endl;
+        if (encoded.total() != bytes.size() || !std::equal(bytes.begin(), bytes.end(), encoded.data) ||
+            !frame_pipeline::readEncodedFile(path).empty()) {
+            std::cerr << "Encoded file contents differ" << std::endl;
+            return 1;
+        }
+        std::cout << "Read " << encoded.total() << " bytes" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
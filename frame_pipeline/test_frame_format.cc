@@ -0,0 +1,64 @@
+#include "frame_convert.h"
+#include <iostream>
+
+int main() {
+    try {
+        // A uniform color survives the round trip through 4:2:0 within rounding
+        std::cout << "Converting BGR frames to YUV 4:2:0 and back..." << std::endl;
+        cv::Mat bgr(400, 800, CV_8UC3, cv::Scalar(40, 120, 200));
+        cv::Mat yuv = frame_pipeline::convertFromBGR(bgr, frame_pipeline::FrameFormat::I420);
+        
+        std::cout << "BGR bytes: " << bgr.total() * bgr.elemSize() << ", I420 bytes: " << yuv.total() << std::endl;
+        if (yuv.type() != CV_8UC1 || yuv.total() * 2 != bgr.total() * bgr.elemSize() ||
+            frame_pipeline::frameImageSize(yuv, frame_pipeline::FrameFormat::I420) != bgr.size()) {
+            std::cerr << "Unexpected I420 layout" << std::endl;
+            return 1;
+        }
+        
+        cv::Mat back = frame_pipeline::convertToBGR(yuv, frame_pipeline::FrameFormat::I420);
+        if (back.size() != bgr.size() || cv::norm(back, bgr, cv::NORM_INF) > 3.0) {
+            std::cerr << "Round trip changed the image" << std::endl;
+            return 1;
+        }
+        
+        // Odd sizes are padded to even by repeating the last row and column, BGR passes through untouched
+        cv::Mat odd(401, 801, CV_8UC3, cv::Scalar(0, 0, 0));
+        odd.col(800).setTo(cv::Scalar(255, 255, 255));
+        cv::Mat oddYuv = frame_pipeline::convertFromBGR(odd, frame_pipeline::FrameFormat::I420);
+        cv::Size paddedSize = frame_pipeline::convertedImageSize(odd.size(), frame_pipeline::FrameFormat::I420);
+        cv::Mat oddBack = frame_pipeline::convertToBGR(oddYuv, frame_pipeline::FrameFormat::I420);
+        if (frame_pipeline::frameImageSize(oddYuv, frame_pipeline::FrameFormat::I420) != cv::Size(802, 402) ||
+            paddedSize != cv::Size(802, 402) || oddBack.at<cv::Vec3b>(400, 801)[0] < 250 ||
+            oddBack.at<cv::Vec3b>(401, 800)[0] < 250 || oddBack.at<cv::Vec3b>(401, 799)[0] > 5) {
+            std::cerr << "Odd-sized frame was not padded to even" << std::endl;
+            return 1;
+        }
+        if (frame_pipeline::convertedImageSize(odd.size(), frame_pipeline::FrameFormat::BGR) != odd.size()) {
+            std::cerr << "BGR frames changed size" << std::endl;
+            return 1;
+        }
+        if (frame_pipeline::convertFromBGR(bgr, frame_pipeline::FrameFormat::BGR).data != bgr.data) {
+            std::cerr << "BGR conversion copied the frame" << std::endl;
+            return 1;
+        }
+        
+        // Gray frames are one byte per pixel, decoded straight from PNG bytes
+        cv::Mat gray = frame_pipeline::convertFromBGR(bgr, frame_pipeline::FrameFormat::Gray);
+        std::vector<uchar> png;
+        cv::imencode(".png", odd, png);
+        cv::Mat decoded = frame_pipeline::decodeGrayFrame(cv::Mat(png).reshape(1, 1));
+        if (gray.type() != CV_8UC1 || gray.size() != bgr.size() ||
+            decoded.type() != CV_8UC1 || decoded.size() != cv::Size(802, 402)) {
+            std::cerr << "Unexpected gray frame layout" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Frame formats round-trip" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "frame_convert.h"
+#include <iostream>
+#include <vector>
+
+int main() {
+    try {
+        // Scales fill the fitted display size without magnifying it
+        std::cout << "Choosing JPEG scales..." << std::endl;
+        struct ScaleCase {
+            int width, height, targetWidth, targetHeight, expected;
+        } scaleCases[] = {
+            {1400, 1400, 1280, 720, 1},  // 720 tall fitted image needs more than 700 rows
+            {1400, 1400, 800, 600, 2},
+            {1400, 1400, 300, 200, 4},
+            {1400, 1400, 100, 100, 8},
+            {1400, 1400, 10, 10, 8},     // 1/8 is the smallest DCT scale
+            {2816, 1408, 700, 700, 4},   // Width-limited: 2816 / 4 = 704 columns
+            {1400, 1400, 1920, 1080, 1},
+        };
+        for (const ScaleCase& c : scaleCases) {
+            int scale = frame_pipeline::chooseJpegScale(c.width, c.height, c.targetWidth, c.targetHeight);
+            if (scale != c.expected) {
+                std::cerr << c.width << "x" << c.height << " in " << c.targetWidth << "x" << c.targetHeight
+                          << ": scale 1/" << scale << ", expected 1/" << c.expected << std::endl;
+                return 1;
+            }
+        }
+        
+        // A smooth image with noise, odd-sized so scaled sizes round up
+        cv::Mat image(701, 1403, CV_8UC3);
+        for (int y = 0; y < image.rows; ++y) {
+            for (int x = 0; x < image.cols; ++x) {
+                image.at<cv::Vec3b>(y, x) = cv::Vec3b(x & 0xFF, y & 0xFF, ((x + y) / 3) & 0xFF);
+            }
+        }
+        cv::Mat noise(image.size(), CV_8UC3);
+        cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(16));
+        image += noise;
+        std::vector<uchar> jpeg;
+        cv::imencode(".jpg", image, jpeg, {cv::IMWRITE_JPEG_QUALITY, 95});
+        cv::Mat encoded(1, static_cast<int>(jpeg.size()), CV_8UC1, jpeg.data());
+        
+        frame_pipeline::JpegInfo info;
+        if (!frame_pipeline::readJpegInfo(jpeg.data(), jpeg.size(), info) ||
+            info.width != image.cols || info.height != image.rows || info.components != 3) {
+            std::cerr << "JPEG header misread" << std::endl;
+            return 1;
+        }
+        
+        // Scaled decodes match OpenCV's reduced decodes, which use the same DCT scaling;
+        // allow a little for differences between libjpeg builds
+        std::cout << "Decoding at reduced scales..." << std::endl;
+        const int reducedColor[] = {cv::IMREAD_COLOR, cv::IMREAD_REDUCED_COLOR_2,
+                                    cv::IMREAD_REDUCED_COLOR_4, cv::IMREAD_REDUCED_COLOR_8};
+        const int reducedGray[] = {cv::IMREAD_GRAYSCALE, cv::IMREAD_REDUCED_GRAYSCALE_2,
+                                   cv::IMREAD_REDUCED_GRAYSCALE_4, cv::IMREAD_REDUCED_GRAYSCALE_8};
+        for (int i = 0; i < 4; ++i) {
+            int scale = 1 << i;
+            int width, height;
+            frame_pipeline::scaledJpegSize(info, scale, width, height);
+            
+            cv::Mat bgr = frame_pipeline::decodeJpegImage(encoded, 3, scale);
+            cv::Mat expected = cv::imdecode(encoded, reducedColor[i]);
+            if (bgr.size() != cv::Size(width, height) || bgr.size() != expected.size() ||
+                cv::norm(bgr, expected, cv::NORM_INF) > 2.0) {
+                std::cerr << "BGR decode at 1/" << scale << " differs from cv::imdecode" << std::endl;
+                return 1;
+            }
+            
+            cv::Mat gray = frame_pipeline::decodeJpegImage(encoded, 1, scale);
+            cv::Mat expectedGray = cv::imdecode(encoded, reducedGray[i]);
+            if (gray.size() != expectedGray.size() || cv::norm(gray, expectedGray, cv::NORM_INF) > 2.0) {
+                std::cerr << "Gray decode at 1/" << scale << " differs from cv::imdecode" << std::endl;
+                return 1;
+            }
+            
+            // Four-byte layouts carry the same pixels in their own byte order
+            cv::Mat bgra(height, width, CV_8UC4);
+            cv::Mat argb(height, width, CV_8UC4);
+            if (!frame_pipeline::decodeJpegInto(jpeg.data(), jpeg.size(), scale, frame_pipeline::JpegPixelFormat::BGRA,
+                                                bgra.data, bgra.step) ||
+                !frame_pipeline::decodeJpegInto(jpeg.data(), jpeg.size(), scale, frame_pipeline::JpegPixelFormat::ARGB,
+                                                argb.data, argb.step)) {
+                std::cerr << "Four-byte decode at 1/" << scale << " failed" << std::endl;
+                return 1;
+            }
+            cv::Mat bgraExpected, argbActual;
+            cv::cvtColor(bgr, bgraExpected, cv::COLOR_BGR2BGRA);
+            const int argbToBgra[] = {3, 0, 2, 1, 1, 2, 0, 3};
+            argbActual.create(argb.size(), CV_8UC4);
+            cv::mixChannels(&argb, 1, &argbActual, 1, argbToBgra, 4);
+            if (cv::norm(bgra, bgraExpected, cv::NORM_INF) != 0.0 || cv::norm(argbActual, bgraExpected, cv::NORM_INF) != 0.0) {
+                std::cerr << "Four-byte decode at 1/" << scale << " differs from BGR" << std::endl;
+                return 1;
+            }
+            std::cout << "  1/" << scale << ": " << width << "x" << height << " ✓" << std::endl;
+        }
+        
+        // Gray frames from JPEG bytes are cropped to even sizes like PNG ones
+        cv::Mat grayFrame = frame_pipeline::decodeGrayFrame(encoded);
+        if (grayFrame.type() != CV_8UC1 || grayFrame.size() != cv::Size(1402, 700)) {
+            std::cerr << "Unexpected gray frame layout" << std::endl;
+            return 1;
+        }
+        
+        // Invalid scales and non-JPEG data are rejected
+        cv::Mat notJpeg(1, 64, CV_8UC1, cv::Scalar(0));
+        if (!frame_pipeline::decodeJpegImage(encoded, 3, 3).empty() ||
+            !frame_pipeline::decodeJpegImage(notJpeg, 3).empty()) {
+            std::cerr << "Invalid input was decoded" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "JPEG decoder matches cv::imdecode" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
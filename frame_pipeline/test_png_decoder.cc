@@ -0,0 +1,119 @@
+#include "png_decoder.h"
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Compare both decode modes against cv::imdecode for one encoded image
+bool matchesImdecode(const std::vector<uchar>& encoded, const char* label) {
+    cv::Mat encodedMat(1, static_cast<int>(encoded.size()), CV_8UC1, const_cast<uchar*>(encoded.data()));
+    cv::Mat expectedColor = cv::imdecode(encodedMat, cv::IMREAD_COLOR);
+    cv::Mat expectedGray;
+    cv::cvtColor(expectedColor, expectedGray, cv::COLOR_BGR2GRAY);
+    
+    for (frame_pipeline::PngDecodeMode mode : {frame_pipeline::PngDecodeMode::Serial,
+                                               frame_pipeline::PngDecodeMode::Pipelined}) {
+        const char* modeName = mode == frame_pipeline::PngDecodeMode::Serial ? "serial" : "pipelined";
+        cv::Mat color = frame_pipeline::decodePng(encodedMat, 3, mode);
+        if (color.size() != expectedColor.size() || color.type() != CV_8UC3 ||
+            cv::norm(color, expectedColor, cv::NORM_INF) != 0.0) {
+            std::cerr << label << ": " << modeName << " BGR decode differs from cv::imdecode" << std::endl;
+            return false;
+        }
+        
+        // The gray conversion rounds like cv::cvtColor, allow one level for its vectorized paths
+        cv::Mat gray = frame_pipeline::decodePng(encodedMat, 1, mode);
+        if (gray.size() != expectedGray.size() || gray.type() != CV_8UC1 ||
+            cv::norm(gray, expectedGray, cv::NORM_INF) > 1.0) {
+            std::cerr << label << ": " << modeName << " gray decode differs from cv::cvtColor" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "  " << label << " ✓" << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main() {
+    try {
+        // A smooth gradient with noise exercises every filter type
+        cv::Mat gradient(375, 1408, CV_8UC3);
+        for (int y = 0; y < gradient.rows; ++y) {
+            for (int x = 0; x < gradient.cols; ++x) {
+                gradient.at<cv::Vec3b>(y, x) = cv::Vec3b(x & 0xFF, y & 0xFF, (x + y) & 0xFF);
+            }
+        }
+        cv::Mat noise(gradient.size(), CV_8UC3);
+        cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(16));
+        gradient += noise;
+        
+        std::cout << "Decoding PNGs..." << std::endl;
+        std::vector<uchar> encoded;
+        
+        cv::imencode(".png", gradient, encoded);
+        if (!matchesImdecode(encoded, "BGR 8-bit")) return 1;
+        
+        cv::Mat bgra;
+        cv::cvtColor(gradient, bgra, cv::COLOR_BGR2BGRA);
+        cv::imencode(".png", bgra, encoded);
+        if (!matchesImdecode(encoded, "BGRA 8-bit")) return 1;
+        
+        cv::Mat gray;
+        cv::cvtColor(gradient, gray, cv::COLOR_BGR2GRAY);
+        cv::imencode(".png", gray, encoded);
+        if (!matchesImdecode(encoded, "gray 8-bit")) return 1;
+        
+        // Odd sizes, and a compression level that stores whole rows unfiltered
+        cv::imencode(".png", gradient(cv::Rect(0, 0, 7, 3)), encoded);
+        if (!matchesImdecode(encoded, "7x3")) return 1;
+        cv::imencode(".png", gradient, encoded, {cv::IMWRITE_PNG_COMPRESSION, 0});
+        if (!matchesImdecode(encoded, "uncompressed")) return 1;
+        
+        // 16-bit images take the libpng path
+        cv::Mat deep;
+        gradient.convertTo(deep, CV_16UC3, 257.0);
+        cv::imencode(".png", deep, encoded);
+        cv::Mat encodedMat(1, static_cast<int>(encoded.size()), CV_8UC1, encoded.data());
+        frame_pipeline::PngInfo info;
+        if (!frame_pipeline::readPngInfo(encoded.data(), encoded.size(), info) || info.directPath ||
+            info.width != gradient.cols || info.height != gradient.rows) {
+            std::cerr << "16-bit PNG header misread" << std::endl;
+            return 1;
+        }
+        cv::Mat decoded = frame_pipeline::decodePng(encodedMat, 3, frame_pipeline::PngDecodeMode::Pipelined);
+        if (decoded.empty() || cv::norm(decoded, gradient, cv::NORM_INF) > 1.0) {
+            std::cerr << "16-bit PNG decode differs" << std::endl;
+            return 1;
+        }
+        std::cout << "  BGR 16-bit (libpng) ✓" << std::endl;
+        
+        // Corrupt and truncated data is rejected in both modes
+        std::cout << "Rejecting damaged PNGs..." << std::endl;
+        cv::imencode(".png", gradient, encoded);
+        std::vector<uchar> corrupt = encoded;
+        corrupt[corrupt.size() / 2] ^= 0x55;
+        std::vector<uchar> truncated(encoded.begin(), encoded.begin() + encoded.size() / 2);
+        for (const std::vector<uchar>* damaged : {&corrupt, &truncated}) {
+            cv::Mat damagedMat(1, static_cast<int>(damaged->size()), CV_8UC1, const_cast<uchar*>(damaged->data()));
+            if (!frame_pipeline::decodePng(damagedMat, 3, frame_pipeline::PngDecodeMode::Serial).empty() ||
+                !frame_pipeline::decodePng(damagedMat, 3, frame_pipeline::PngDecodeMode::Pipelined).empty()) {
+                std::cerr << "Damaged PNG was decoded" << std::endl;
+                return 1;
+            }
+        }
+        cv::Mat notPng(1, 64, CV_8UC1, cv::Scalar(0));
+        if (!frame_pipeline::decodePng(notPng, 3).empty()) {
+            std::cerr << "Non-PNG data was decoded" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "PNG decoder matches cv::imdecode" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "sequence_index.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const int64_t FRAME_PERIOD_NS = 100000000; // 10 Hz
+
+std::string formatTimestamp(int64_t nanoseconds) {
+    // 2013-05-28 00:00:00 plus the offset, written like KITTI-360's timestamps.txt
+    int64_t seconds = nanoseconds / 1000000000;
+    char line[64];
+    std::snprintf(line, sizeof(line), "2013-05-28 %02lld:%02lld:%02lld.%09lld\n",
+                  static_cast<long long>(seconds / 3600), static_cast<long long>(seconds / 60 % 60),
+                  static_cast<long long>(seconds % 60), static_cast<long long>(nanoseconds % 1000000000));
+    return line;
+}
+
+// <root>/<camera>/timestamps.txt and <root>/<camera>/data_rect/<frame>.png for the given frames
+std::string writeCamera(const fs::path& root, const std::string& camera, int frames, int64_t offsetNs,
+                        int64_t periodNs, int droppedFrame) {
+    fs::path directory = root / camera / "data_rect";
+    fs::create_directories(directory);
+    std::ofstream timestamps(root / camera / "timestamps.txt");
+    for (int frame = 0; frame < frames; ++frame) {
+        timestamps << formatTimestamp(offsetNs + frame * periodNs);
+        if (frame == droppedFrame) continue;
+        char name[32];
+        std::snprintf(name, sizeof(name), "%010d.png", frame);
+        std::ofstream(directory / name) << "png";
+    }
+    return directory.string();
+}
+
+} // namespace
+
+int main() {
+    try {
+        // Parsing: epoch arithmetic, fraction lengths, CRLF and trailing blank lines
+        std::cout << "Parsing timestamps..." << std::endl;
+        std::string text = "2013-05-28 08:46:02.802000000\r\n1970-01-01 00:00:01.5\n2000-03-01 00:00:00\n\n";
+        std::vector<int64_t> parsed = frame_pipeline::parseTimestamps(text.data(), text.size());
+        if (parsed.size() != 3 || parsed[0] != 1369730762802000000LL || parsed[1] != 1500000000LL ||
+            parsed[2] != 951868800000000000LL) {
+            std::cerr << "Timestamps parsed wrongly" << std::endl;
+            return 1;
+        }
+        
+        try {
+            std::string malformed = "2013-05-28 08:46:02.802\n2013-05-28 8:46:02.902\n";
+            frame_pipeline::parseTimestamps(malformed.data(), malformed.size());
+            std::cerr << "Malformed timestamp was accepted" << std::endl;
+            return 1;
+        } catch (const std::runtime_error&) {
+        }
+        
+        // 100k lines parse in milliseconds
+        std::string large;
+        for (int frame = 0; frame < 100000; ++frame) {
+            large += formatTimestamp(frame * FRAME_PERIOD_NS);
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<int64_t> largeTimestamps = frame_pipeline::parseTimestamps(large.data(), large.size());
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  100000 timestamps in " << milliseconds << " ms" << std::endl;
+        if (largeTimestamps.size() != 100000 || largeTimestamps[99999] - largeTimestamps[0] != 99999 * FRAME_PERIOD_NS) {
+            std::cerr << "Large timestamps file parsed wrongly" << std::endl;
+            return 1;
+        }
+        
+        // Merge: a dropped frame loses only its own set, a 5 Hz camera joins every other reference frame
+        std::cout << "Synchronizing cameras..." << std::endl;
+        std::vector<std::vector<frame_pipeline::TimedFrame>> cameras(3);
+        for (uint32_t frame = 0; frame < 100; ++frame) {
+            cameras[0].push_back({frame * FRAME_PERIOD_NS, frame});
+            if (frame != 50) cameras[1].push_back({frame * FRAME_PERIOD_NS + 3000000, frame});
+            if (frame % 2 == 0) cameras[2].push_back({frame * FRAME_PERIOD_NS - 2000000, frame / 2});
+        }
+        std::reverse(cameras[1].begin(), cameras[1].end());
+        std::vector<std::vector<uint32_t>> sets = frame_pipeline::synchronizeFrames(cameras, 20000000);
+        if (sets.size() != 49 || sets[0] != std::vector<uint32_t>{0, 0, 0} || sets[48] != std::vector<uint32_t>{98, 98, 49}) {
+            std::cerr << "Synchronized " << sets.size() << " frame sets, expected 49" << std::endl;
+            return 1;
+        }
+        for (const std::vector<uint32_t>& set : sets) {
+            if (set[0] == 50 || set[1] != set[0] || set[2] != set[0] / 2) {
+                std::cerr << "Frames joined to the wrong partners" << std::endl;
+                return 1;
+            }
+        }
+        
+        // Sequence index from directories, built once, then read from the cache
+        std::cout << "Building a sequence index..." << std::endl;
+        fs::path root = fs::temp_directory_path() / "test_sequence_index";
+        fs::remove_all(root);
+        std::vector<std::string> directories = {
+            writeCamera(root, "image_00", 30, 0, FRAME_PERIOD_NS, 7),
+            writeCamera(root, "image_01", 30, 1000000, FRAME_PERIOD_NS, 12),
+        };
+        std::string cacheDirectory = (root / "cache").string();
+        
+        frame_pipeline::SequenceIndex built = frame_pipeline::loadSequenceIndex(directories, 20000000, cacheDirectory);
+        frame_pipeline::SequenceIndex cached = frame_pipeline::loadSequenceIndex(directories, 20000000, cacheDirectory);
+        bool valid = built.timestampSynchronized && !built.fromCache && cached.fromCache &&
+                     built.frameSets.size() == 28 && cached.frameSets.size() == 28 &&
+                     built.cameraFrames == std::vector<size_t>{29, 29};
+        for (size_t i = 0; valid && i < built.frameSets.size(); ++i) {
+            valid = built.frameSets[i].filenames == cached.frameSets[i].filenames &&
+                    built.frameSets[i].timestamp == cached.frameSets[i].timestamp &&
+                    built.frameSets[i].baseName == cached.frameSets[i].baseName;
+        }
+        
+        // Without timestamps frames are joined by name
+        fs::remove(root / "image_01" / "timestamps.txt");
+        frame_pipeline::SequenceIndex byName = frame_pipeline::loadSequenceIndex(directories, 20000000, cacheDirectory);
+        valid = valid && !byName.timestampSynchronized && !byName.fromCache && byName.frameSets.size() == 28;
+        fs::remove_all(root);
+        
+        if (!valid) {
+            std::cerr << "Sequence index is wrong" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Sequence index synchronizes by timestamp" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "thumbnails.h"
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<std::string> frameList(const fs::path& directory, int count) {
+    std::vector<std::string> files;
+    for (int i = 0; i < count; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%010d.png", i);
+        files.push_back((directory / name).string());
+    }
+    return files;
+}
+
+// Thumbnail filled with one value, so each frame's is recognizable
+std::vector<uint8_t> solidThumbnail(const frame_pipeline::ThumbnailStore& store, uint8_t value) {
+    return std::vector<uint8_t>(store.thumbnailBytes(), value);
+}
+
+} // namespace
+
+int main() {
+    try {
+        // Fixed height, frame aspect ratio, even width
+        std::cout << "Sizing thumbnails..." << std::endl;
+        int width, height;
+        frame_pipeline::thumbnailSize(1408, 376, 72, width, height);
+        bool sized = width == 270 && height == 72;
+        frame_pipeline::thumbnailSize(1400, 1400, 72, width, height);
+        sized = sized && width == 72 && height == 72;
+        frame_pipeline::thumbnailSize(10000, 10, 72, width, height);
+        sized = sized && width == 288;
+        if (!sized) {
+            std::cerr << "Thumbnail size is wrong" << std::endl;
+            return 1;
+        }
+        
+        // Box filter: each thumbnail pixel is the mean of the block it covers
+        std::cout << "Downscaling..." << std::endl;
+        cv::Mat image(64, 96, CV_8UC3);
+        for (int y = 0; y < image.rows; ++y) {
+            for (int x = 0; x < image.cols; ++x) {
+                image.at<cv::Vec3b>(y, x) = (x + y) % 2 ? cv::Vec3b(200, 100, 0) : cv::Vec3b(100, 50, 40);
+            }
+        }
+        std::vector<uint8_t> thumbnail(24 * 16 * 3);
+        frame_pipeline::downscaleToThumbnail(image.data, image.cols, image.rows, image.step, 3, thumbnail.data(), 24, 16);
+        for (size_t i = 0; i < thumbnail.size(); i += 3) {
+            if (thumbnail[i] != 150 || thumbnail[i + 1] != 75 || thumbnail[i + 2] != 20) {
+                std::cerr << "Box filter is wrong at byte " << i << std::endl;
+                return 1;
+            }
+        }
+        cv::Mat gray(3, 5, CV_8UC1, cv::Scalar(77));
+        frame_pipeline::downscaleToThumbnail(gray.data, gray.cols, gray.rows, gray.step, 1, thumbnail.data(), 24, 16);
+        if (thumbnail[0] != 77 || thumbnail[1] != 77 || thumbnail[24 * 16 * 3 - 1] != 77) {
+            std::cerr << "Enlarged gray thumbnail is wrong" << std::endl;
+            return 1;
+        }
+        
+        // Reduced JPEG decode lands close to downscaling the full image
+        std::cout << "Decoding JPEG thumbnails..." << std::endl;
+        cv::Mat frame(376, 1408, CV_8UC3);
+        for (int y = 0; y < frame.rows; ++y) {
+            for (int x = 0; x < frame.cols; ++x) {
+                frame.at<cv::Vec3b>(y, x) = cv::Vec3b(x * 255 / frame.cols, y * 255 / frame.rows, 128);
+            }
+        }
+        std::vector<uchar> jpeg;
+        cv::imencode(".jpg", frame, jpeg, {cv::IMWRITE_JPEG_QUALITY, 95});
+        frame_pipeline::thumbnailSize(frame.cols, frame.rows, 72, width, height);
+        cv::Mat decoded(height, width, CV_8UC3), reference(height, width, CV_8UC3);
+        auto start = std::chrono::steady_clock::now();
+        bool decodedJpeg = frame_pipeline::decodeJpegThumbnail(jpeg.data(), jpeg.size(), decoded.data, width, height);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        frame_pipeline::downscaleToThumbnail(frame.data, frame.cols, frame.rows, frame.step, 3, reference.data, width, height);
+        double difference = cv::norm(decoded, reference, cv::NORM_INF);
+        std::cout << "  " << width << "x" << height << " from " << frame.cols << "x" << frame.rows << " in "
+                  << milliseconds << " ms, largest difference " << difference << std::endl;
+        if (!decodedJpeg || difference > 12.0 ||
+            frame_pipeline::decodeJpegThumbnail(jpeg.data(), 16, decoded.data, width, height)) {
+            std::cerr << "JPEG thumbnail is wrong" << std::endl;
+            return 1;
+        }
+        
+        // Thumbnails written to the cache file are there on the next open
+        std::cout << "Caching thumbnails on disk..." << std::endl;
+        fs::path root = fs::temp_directory_path() / "test_thumbnails";
+        fs::remove_all(root);
+        fs::create_directories(root / "frames");
+        std::string cacheDirectory = (root / "cache").string();
+        std::vector<std::string> frames = frameList(root / "frames", 1000);
+        {
+            frame_pipeline::ThumbnailStore store(frames, 96, 54, cacheDirectory);
+            if (!store.persistent() || store.readyCount() != 0) {
+                std::cerr << "New cache is not empty" << std::endl;
+                return 1;
+            }
+            for (size_t index : {0, 7, 999}) {
+                store.store(index, solidThumbnail(store, static_cast<uint8_t>(index)).data());
+            }
+        }
+        {
+            frame_pipeline::ThumbnailStore store(frames, 96, 54, cacheDirectory);
+            bool cached = store.cachedCount() == 3 && store.isReady(7) && !store.isReady(8) && store.isReady(999);
+            for (size_t i = 0; cached && i < store.thumbnailBytes(); ++i) {
+                cached = store.pixels(7)[i] == 7 && store.pixels(999)[i] == static_cast<uint8_t>(999);
+            }
+            if (!cached) {
+                std::cerr << "Cached thumbnails were not read back" << std::endl;
+                return 1;
+            }
+            
+            // Only stored thumbnails take space in the file
+            struct stat info;
+            stat(frame_pipeline::ThumbnailStore::cachePath(frames, 96, 54, cacheDirectory).c_str(), &info);
+            std::cout << "  " << (info.st_size >> 10) << " KB file, " << (info.st_blocks * 512 >> 10)
+                      << " KB on disk" << std::endl;
+        }
+        
+        // Another frame list or size has its own cache
+        frames.pop_back();
+        frame_pipeline::ThumbnailStore shorter(frames, 96, 54, cacheDirectory);
+        frame_pipeline::ThumbnailStore smaller(frameList(root / "frames", 1000), 64, 36, cacheDirectory);
+        frame_pipeline::ThumbnailStore memory(frames, 96, 54, "");
+        if (shorter.cachedCount() != 0 || smaller.cachedCount() != 0 || memory.persistent()) {
+            std::cerr << "Cache keys are wrong" << std::endl;
+            return 1;
+        }
+        
+        // The generator works outward from the cursor and skips what is cached and what fails
+        std::cout << "Generating in the background..." << std::endl;
+        std::mutex orderMutex;
+        std::vector<size_t> order;
+        frame_pipeline::ThumbnailGenerator generator;
+        generator.setCursor(500);
+        generator.start(memory, [&](size_t index, uint8_t* pixels) {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(index);
+            std::fill(pixels, pixels + memory.thumbnailBytes(), static_cast<uint8_t>(index));
+            return index % 100 != 13;
+        });
+        for (int wait = 0; wait < 500 && memory.readyCount() < memory.size() - 10; ++wait) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        generator.stop();
+        
+        bool nearestFirst = order.size() == memory.size() && order[0] == 500 && order[1] == 501 && order[2] == 499;
+        for (size_t i = 1; nearestFirst && i < order.size(); ++i) {
+            nearestFirst = std::abs(static_cast<long>(order[i]) - 500) >= std::abs(static_cast<long>(order[i - 1]) - 500);
+        }
+        std::set<size_t> unique(order.begin(), order.end());
+        if (!nearestFirst || unique.size() != order.size() || memory.readyCount() != memory.size() - 10 ||
+            memory.isReady(513) || memory.pixels(600)[0] != static_cast<uint8_t>(600)) {
+            std::cerr << "Generation order is wrong (" << order.size() << " rendered, " << memory.readyCount()
+                      << " ready)" << std::endl;
+            return 1;
+        }
+        std::cout << "  " << generator.generatedCount() << " thumbnails in " << generator.renderMilliseconds()
+                  << " ms of rendering" << std::endl;
+        fs::remove_all(root);
+        
+        // Atlas pages hold the requested run of frames without collisions
+        std::cout << "Laying out atlas pages..." << std::endl;
+        frame_pipeline::ThumbnailAtlasLayout atlas(270, 72, 512);
+        std::set<size_t> cells;
+        for (size_t index = 10000; index < 10000 + 512; ++index) {
+            size_t cell = atlas.cell(index);
+            int x, y;
+            atlas.cellOrigin(cell, x, y);
+            cells.insert(cell);
+            if (atlas.page(cell) >= atlas.pages || x + atlas.thumbnailWidth > atlas.pageWidth ||
+                y + atlas.thumbnailHeight > atlas.pageHeight) {
+                std::cerr << "Cell " << cell << " lies outside the pages" << std::endl;
+                return 1;
+            }
+        }
+        if (atlas.capacity() < 512 || cells.size() != 512 || atlas.pageWidth > 2048 || atlas.pageHeight > 2048) {
+            std::cerr << "Atlas layout is wrong" << std::endl;
+            return 1;
+        }
+        std::cout << "  " << atlas.pages << " pages of " << atlas.pageWidth << "x" << atlas.pageHeight << std::endl;
+        
+        // The cursor's thumbnail is in the middle of the strip
+        frame_pipeline::FilmstripLayout strip = frame_pipeline::FilmstripLayout::centred(3, 1000, 96, 4);
+        int middle = strip.left + strip.slots / 2 * strip.pitch + 48;
+        if (strip.slots != 9 || strip.frameAt(middle, 100) != 3 || strip.frameAt(middle + strip.pitch, 100) != 4 ||
+            strip.frameAt(strip.left + 1, 100) != -1 || strip.frameAt(middle, 3) != -1) {
+            std::cerr << "Filmstrip layout is wrong" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Thumbnails are generated, cached and laid out" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "tiled_remap.h"
+#include <iostream>
+
+int main() {
+    try {
+        // Unwrap maps shaped like the viewer's: 5x focal length, 4x2 larger output
+        std::cout << "Building fisheye unwrap maps..." << std::endl;
+        cv::Size sourceSize(700, 700);
+        cv::Mat cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
+        cameraMatrix.at<double>(0, 0) = 668.0;
+        cameraMatrix.at<double>(1, 1) = 668.0;
+        cameraMatrix.at<double>(0, 2) = 350.0;
+        cameraMatrix.at<double>(1, 2) = 350.0;
+        cv::Mat distCoeffs = cv::Mat::zeros(4, 1, CV_64F);
+        distCoeffs.at<double>(0) = 0.0168;
+        distCoeffs.at<double>(1) = 1.65;
+        
+        cv::Size outputSize(sourceSize.width * 4, sourceSize.height * 2);
+        cv::Mat newCameraMatrix = cameraMatrix.clone();
+        newCameraMatrix.at<double>(0, 0) *= 5.0;
+        newCameraMatrix.at<double>(1, 1) *= 5.0;
+        newCameraMatrix.at<double>(0, 2) = outputSize.width / 2.0;
+        newCameraMatrix.at<double>(1, 2) = outputSize.height / 2.0;
+        
+        cv::Mat map1, map2;
+        cv::fisheye::initUndistortRectifyMap(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix,
+                                             outputSize, CV_16SC2, map1, map2);
+        
+        // Tiles cover the output exactly once and respect the cache budget
+        const size_t cacheBytes = 64 << 10;
+        frame_pipeline::TiledRemap tiled(map1, map2, sourceSize, 3, cacheBytes);
+        std::cout << "Planned " << tiled.tiles().size() << " tiles, largest source footprint "
+                  << tiled.largestFootprintBytes() << " bytes" << std::endl;
+        
+        cv::Mat coverage = cv::Mat::zeros(outputSize, CV_8UC1);
+        for (const frame_pipeline::RemapTile& tile : tiled.tiles()) {
+            coverage(tile.output) += 1;
+            bool singleBlock = tile.output.width <= frame_pipeline::TiledRemap::BLOCK_SIZE &&
+                               tile.output.height <= frame_pipeline::TiledRemap::BLOCK_SIZE;
+            if (!singleBlock && static_cast<size_t>(tile.source.area()) * 3 > cacheBytes) {
+                std::cerr << "Tile source footprint exceeds the cache budget" << std::endl;
+                return 1;
+            }
+        }
+        double minCoverage, maxCoverage;
+        cv::minMaxLoc(coverage, &minCoverage, &maxCoverage);
+        if (minCoverage != 1.0 || maxCoverage != 1.0) {
+            std::cerr << "Tiles do not cover the output exactly once" << std::endl;
+            return 1;
+        }
+        
+        // Tiled output matches a plain remap pixel for pixel
+        std::cout << "Comparing against cv::remap..." << std::endl;
+        cv::Mat source(sourceSize, CV_8UC3);
+        cv::randu(source, cv::Scalar::all(0), cv::Scalar::all(255));
+        
+        cv::Mat expected, actual;
+        cv::remap(source, expected, map1, map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+        tiled.apply(source, actual, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+        if (actual.size() != expected.size() || cv::norm(actual, expected, cv::NORM_INF) != 0.0) {
+            std::cerr << "Tiled remap differs from cv::remap" << std::endl;
+            return 1;
+        }
+        
+        // Float maps cannot be planned
+        cv::Mat floatMap1, floatMap2;
+        cv::fisheye::initUndistortRectifyMap(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix,
+                                             outputSize, CV_32FC1, floatMap1, floatMap2);
+        try {
+            frame_pipeline::TiledRemap rejected(floatMap1, floatMap2, sourceSize, 3);
+            std::cerr << "Float maps were accepted" << std::endl;
+            return 1;
+        } catch (const std::runtime_error&) {
+        }
+        
+        std::cout << "Tiled remap matches cv::remap" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
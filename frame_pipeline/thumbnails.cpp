@@ -0,0 +1,387 @@
+#include "thumbnails.h"
+#include "jpeg_decoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace frame_pipeline {
+
+namespace {
+
+const char THUMBNAIL_CACHE_MAGIC[8] = {'K', '3', '6', '0', 'T', 'H', 'M', '\0'};
+const size_t CACHE_PAGE_BYTES = 4096;
+
+// First page of a cache file; ready bytes start on the next page, thumbnails on the page after them
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t frameCount;
+    uint64_t listHash;
+    int64_t directoryTime; // First frame's directory, to notice frames replaced under the same names
+};
+
+uint64_t hashBytes(uint64_t hash, const void* bytes, size_t size) {
+    const unsigned char* data = static_cast<const unsigned char*>(bytes);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t roundUpToPage(size_t bytes) {
+    return (bytes + CACHE_PAGE_BYTES - 1) / CACHE_PAGE_BYTES * CACHE_PAGE_BYTES;
+}
+
+std::string parentDirectory(const std::string& filename) {
+    std::error_code error;
+    fs::path canonical = fs::weakly_canonical(fs::path(filename).parent_path(), error);
+    return error ? fs::path(filename).parent_path().string() : canonical.string();
+}
+
+// Hash of the first frame's directory, every frame's file name and the thumbnail size
+uint64_t frameListHash(const std::vector<std::string>& frameFiles, int width, int height) {
+    uint64_t hash = 14695981039346656037ULL;
+    if (!frameFiles.empty()) {
+        std::string directory = parentDirectory(frameFiles[0]);
+        hash = hashBytes(hash, directory.data(), directory.size() + 1);
+    }
+    for (const std::string& filename : frameFiles) {
+        size_t slash = filename.find_last_of('/');
+        size_t start = slash == std::string::npos ? 0 : slash + 1;
+        hash = hashBytes(hash, filename.data() + start, filename.size() - start + 1);
+    }
+    hash = hashBytes(hash, &width, sizeof(width));
+    return hashBytes(hash, &height, sizeof(height));
+}
+
+int64_t directoryTime(const std::vector<std::string>& frameFiles) {
+    if (frameFiles.empty()) return 0;
+    std::error_code error;
+    auto time = fs::last_write_time(parentDirectory(frameFiles[0]), error);
+    return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+} // namespace
+
+void thumbnailSize(int frameWidth, int frameHeight, int thumbnailHeight, int& width, int& height) {
+    height = std::max(2, thumbnailHeight);
+    double aspect = frameWidth > 0 && frameHeight > 0 ? static_cast<double>(frameWidth) / frameHeight : 4.0 / 3.0;
+    aspect = std::min(std::max(aspect, 0.25), 4.0);
+    width = std::max(2, static_cast<int>(std::lround(height * aspect / 2.0)) * 2);
+}
+
+void downscaleToThumbnail(const uint8_t* pixels, int width, int height, size_t step, int channels,
+                          uint8_t* thumbnail, int thumbnailWidth, int thumbnailHeight) {
+    // Source columns of each thumbnail column; at least one, so small sources are enlarged
+    std::vector<int> columnStart(thumbnailWidth), columnEnd(thumbnailWidth);
+    for (int x = 0; x < thumbnailWidth; ++x) {
+        columnStart[x] = std::min(static_cast<int>(static_cast<int64_t>(x) * width / thumbnailWidth), width - 1);
+        columnEnd[x] = std::max(columnStart[x] + 1, static_cast<int>(static_cast<int64_t>(x + 1) * width / thumbnailWidth));
+    }
+    
+    std::vector<uint32_t> sums(static_cast<size_t>(thumbnailWidth) * 3);
+    for (int y = 0; y < thumbnailHeight; ++y) {
+        int rowStart = std::min(static_cast<int>(static_cast<int64_t>(y) * height / thumbnailHeight), height - 1);
+        int rowEnd = std::max(rowStart + 1, static_cast<int>(static_cast<int64_t>(y + 1) * height / thumbnailHeight));
+        std::fill(sums.begin(), sums.end(), 0);
+        
+        for (int row = rowStart; row < rowEnd; ++row) {
+            const uint8_t* source = pixels + static_cast<size_t>(row) * step;
+            for (int x = 0; x < thumbnailWidth; ++x) {
+                uint32_t* sum = &sums[static_cast<size_t>(x) * 3];
+                if (channels == 3) {
+                    for (int column = columnStart[x]; column < columnEnd[x]; ++column) {
+                        sum[0] += source[column * 3];
+                        sum[1] += source[column * 3 + 1];
+                        sum[2] += source[column * 3 + 2];
+                    }
+                } else {
+                    for (int column = columnStart[x]; column < columnEnd[x]; ++column) {
+                        sum[0] += source[column];
+                    }
+                    sum[1] = sum[2] = sum[0];
+                }
+            }
+        }
+        
+        uint8_t* output = thumbnail + static_cast<size_t>(y) * thumbnailWidth * 3;
+        for (int x = 0; x < thumbnailWidth; ++x) {
+            uint32_t count = static_cast<uint32_t>((columnEnd[x] - columnStart[x]) * (rowEnd - rowStart));
+            for (int channel = 0; channel < 3; ++channel) {
+                output[x * 3 + channel] = static_cast<uint8_t>((sums[static_cast<size_t>(x) * 3 + channel] + count / 2) / count);
+            }
+        }
+    }
+}
+
+bool decodeJpegThumbnail(const uint8_t* data, size_t size, uint8_t* thumbnail, int thumbnailWidth,
+                         int thumbnailHeight) {
+    JpegInfo info;
+    if (!readJpegInfo(data, size, info)) {
+        return false;
+    }
+    int scale = chooseJpegScale(info.width, info.height, thumbnailWidth, thumbnailHeight);
+    int width, height;
+    scaledJpegSize(info, scale, width, height);
+    
+    thread_local std::vector<uint8_t> scaled;
+    scaled.resize(static_cast<size_t>(width) * height * 3);
+    if (!decodeJpegInto(data, size, scale, JpegPixelFormat::BGR, scaled.data(), static_cast<size_t>(width) * 3)) {
+        return false;
+    }
+    downscaleToThumbnail(scaled.data(), width, height, static_cast<size_t>(width) * 3, 3, thumbnail,
+                         thumbnailWidth, thumbnailHeight);
+    return true;
+}
+
+ThumbnailStore::ThumbnailStore(const std::vector<std::string>& frameFiles, int thumbnailWidth, int thumbnailHeight,
+                               const std::string& cacheDirectory)
+    : frameCount(frameFiles.size()), thumbnailWidth(thumbnailWidth), thumbnailHeight(thumbnailHeight), fd(-1),
+      mapping(nullptr), mappingBytes(0), flags(nullptr), slots(nullptr),
+      readyFlags(new std::atomic<uint8_t>[std::max<size_t>(frameCount, 1)]), ready(0), openedReady(0) {
+    size_t slotsOffset = roundUpToPage(CACHE_PAGE_BYTES + frameCount);
+    mappingBytes = slotsOffset + frameCount * thumbnailBytes();
+    
+    if (cacheDirectory.empty() ||
+        !openCacheFile(cachePath(frameFiles, thumbnailWidth, thumbnailHeight, cacheDirectory), frameFiles)) {
+        // Untouched pages of an anonymous mapping take no memory either
+        void* anonymous = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (anonymous == MAP_FAILED) {
+            throw std::runtime_error("Cannot map thumbnail memory");
+        }
+        mapping = static_cast<uint8_t*>(anonymous);
+    }
+    flags = mapping + CACHE_PAGE_BYTES;
+    slots = mapping + slotsOffset;
+    
+    for (size_t i = 0; i < frameCount; ++i) {
+        uint8_t isCached = flags[i] == 1;
+        readyFlags[i].store(isCached, std::memory_order_relaxed);
+        openedReady += isCached;
+    }
+    ready = openedReady;
+}
+
+ThumbnailStore::~ThumbnailStore() {
+    if (mapping) munmap(mapping, mappingBytes);
+    if (fd >= 0) ::close(fd);
+}
+
+std::string ThumbnailStore::cachePath(const std::vector<std::string>& frameFiles, int thumbnailWidth,
+                                      int thumbnailHeight, const std::string& cacheDirectory) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.k360thumb",
+                  static_cast<unsigned long long>(frameListHash(frameFiles, thumbnailWidth, thumbnailHeight)));
+    return (fs::path(cacheDirectory) / name).string();
+}
+
+// Reuse a cache file whose header matches, else start it over. Truncating first drops the
+// old thumbnails' blocks, and extending the file again leaves a hole in their place.
+bool ThumbnailStore::openCacheFile(const std::string& path, const std::vector<std::string>& frameFiles) {
+    std::error_code error;
+    fs::create_directories(fs::path(path).parent_path(), error);
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    
+    CacheHeader expected{};
+    std::memcpy(expected.magic, THUMBNAIL_CACHE_MAGIC, sizeof(expected.magic));
+    expected.version = THUMBNAIL_CACHE_VERSION;
+    expected.width = static_cast<uint32_t>(thumbnailWidth);
+    expected.height = static_cast<uint32_t>(thumbnailHeight);
+    expected.frameCount = frameCount;
+    expected.listHash = frameListHash(frameFiles, thumbnailWidth, thumbnailHeight);
+    expected.directoryTime = directoryTime(frameFiles);
+    
+    CacheHeader existing{};
+    struct stat info;
+    bool valid = fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == mappingBytes &&
+                 pread(fd, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) &&
+                 std::memcmp(&existing, &expected, sizeof(expected)) == 0;
+    if (!valid && (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(mappingBytes)) != 0 ||
+                   pwrite(fd, &expected, sizeof(expected), 0) != static_cast<ssize_t>(sizeof(expected)))) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    
+    void* shared = mmap(nullptr, mappingBytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (shared == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    mapping = static_cast<uint8_t*>(shared);
+    return true;
+}
+
+// Cache files are written with pwrite rather than through the mapping, so a full disk fails
+// the write instead of faulting on a hole; the mapping shares the written pages
+bool ThumbnailStore::store(size_t index, const uint8_t* thumbnail) {
+    if (index >= frameCount) return false;
+    if (fd >= 0) {
+        off_t slotOffset = static_cast<off_t>((slots - mapping) + index * thumbnailBytes());
+        const uint8_t readyByte = 1;
+        if (pwrite(fd, thumbnail, thumbnailBytes(), slotOffset) != static_cast<ssize_t>(thumbnailBytes()) ||
+            pwrite(fd, &readyByte, 1, static_cast<off_t>(CACHE_PAGE_BYTES + index)) != 1) {
+            return false;
+        }
+    } else {
+        std::memcpy(slots + index * thumbnailBytes(), thumbnail, thumbnailBytes());
+    }
+    if (readyFlags[index].exchange(1, std::memory_order_release) == 0) {
+        ready.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+ThumbnailGenerator::ThumbnailGenerator()
+    : store(nullptr), running(false), cursor(0), scanCursor(0), scanDistance(0), generated(0), milliseconds(0.0) {}
+
+ThumbnailGenerator::~ThumbnailGenerator() {
+    stop();
+}
+
+void ThumbnailGenerator::start(ThumbnailStore& thumbnailStore, Render renderThumbnail, Busy busy) {
+    stop();
+    store = &thumbnailStore;
+    render = std::move(renderThumbnail);
+    foregroundBusy = std::move(busy);
+    failed.assign(store->size(), 0);
+    scanCursor = cursor;
+    scanDistance = 0;
+    running = true;
+    generatorThread = std::thread(&ThumbnailGenerator::generateLoop, this);
+}
+
+void ThumbnailGenerator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    if (generatorThread.joinable()) {
+        generatorThread.join();
+    }
+}
+
+void ThumbnailGenerator::setCursor(size_t index) {
+    if (cursor.exchange(index) != index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake.notify_all();
+    }
+}
+
+// Nearest frame to the cursor that is neither ready nor failed. Frames closer than
+// scanDistance were found done before, so scans continue where the last one stopped.
+bool ThumbnailGenerator::nextMissing(size_t& index) {
+    size_t center = cursor;
+    size_t count = store->size();
+    if (center != scanCursor) {
+        scanCursor = center;
+        scanDistance = 0;
+    }
+    
+    while (true) {
+        bool inRange = false;
+        if (center + scanDistance < count) {
+            inRange = true;
+            index = center + scanDistance;
+            if (!store->isReady(index) && !failed[index]) return true;
+        }
+        if (scanDistance > 0 && scanDistance <= center) {
+            inRange = true;
+            index = center - scanDistance;
+            if (!store->isReady(index) && !failed[index]) return true;
+        }
+        if (!inRange) return false;
+        ++scanDistance;
+    }
+}
+
+void ThumbnailGenerator::generateLoop() {
+#ifdef __linux__
+    // Linux schedules threads individually, so this lowers the generator alone
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+    std::vector<uint8_t> thumbnail(store->thumbnailBytes());
+    
+    while (running) {
+        size_t index;
+        if ((foregroundBusy && foregroundBusy()) || !nextMissing(index)) {
+            // Poll while the viewer is busy; when everything is done, wake on cursor moves
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(50), [this] { return !running; });
+            continue;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        bool rendered = render(index, thumbnail.data());
+        milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (rendered && store->store(index, thumbnail.data())) {
+            generated.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            failed[index] = 1;
+        }
+    }
+}
+
+ThumbnailAtlasLayout::ThumbnailAtlasLayout(int thumbnailWidth, int thumbnailHeight, size_t thumbnails, int maxPageSize)
+    : thumbnailWidth(thumbnailWidth), thumbnailHeight(thumbnailHeight) {
+    thumbnails = std::max<size_t>(thumbnails, 1);
+    columns = static_cast<int>(std::min<size_t>(std::max(1, maxPageSize / thumbnailWidth), thumbnails));
+    size_t maxRows = static_cast<size_t>(std::max(1, maxPageSize / thumbnailHeight));
+    size_t wantedRows = (thumbnails + columns - 1) / columns;
+    pages = static_cast<int>((wantedRows + maxRows - 1) / maxRows);
+    rows = static_cast<int>((wantedRows + pages - 1) / pages);
+    pageWidth = columns * thumbnailWidth;
+    pageHeight = rows * thumbnailHeight;
+}
+
+void ThumbnailAtlasLayout::cellOrigin(size_t cell, int& x, int& y) const {
+    size_t local = cell % (static_cast<size_t>(columns) * rows);
+    x = static_cast<int>(local % columns) * thumbnailWidth;
+    y = static_cast<int>(local / columns) * thumbnailHeight;
+}
+
+FilmstripLayout FilmstripLayout::centred(size_t cursor, int stripWidth, int thumbnailWidth, int gap) {
+    FilmstripLayout layout;
+    layout.pitch = std::max(1, thumbnailWidth + gap);
+    layout.slots = std::max(1, stripWidth / layout.pitch);
+    if (layout.slots % 2 == 0) {
+        layout.slots = std::max(1, layout.slots - 1);
+    }
+    layout.left = (stripWidth - (layout.slots * layout.pitch - gap)) / 2;
+    layout.firstFrame = static_cast<long>(cursor) - layout.slots / 2;
+    return layout;
+}
+
+long FilmstripLayout::frameAt(int x, size_t frameCount) const {
+    if (x < left) return -1;
+    int slot = (x - left) / pitch;
+    long frame = firstFrame + slot;
+    if (slot >= slots || frame < 0 || frame >= static_cast<long>(frameCount)) return -1;
+    return frame;
+}
+
+} // namespace frame_pipeline
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Version of the on-disk thumbnail cache format
+ *
+ * Bump whenever the file layout or the thumbnail filter changes; caches of
+ * another version are recreated.
+ */
+const uint32_t THUMBNAIL_CACHE_VERSION = 1;
+
+/**
+ * @brief Default thumbnail height in pixels
+ */
+const int DEFAULT_THUMBNAIL_HEIGHT = 72;
+
+/**
+ * @brief Size of the thumbnails of frames of a given size
+ *
+ * Thumbnails have a fixed height and the frames' aspect ratio (limited to
+ * 4:1 either way), with an even width.
+ */
+void thumbnailSize(int frameWidth, int frameHeight, int thumbnailHeight, int& width, int& height);
+
+/**
+ * @brief Box-filter an image down to a BGR thumbnail
+ *
+ * Each thumbnail pixel is the mean of the source pixels it covers, so the
+ * result is free of the aliasing point sampling gives at large factors.
+ * Kept free of OpenCV so the SDL-only viewer can share it.
+ * @param pixels Source pixels, gray or BGR
+ * @param width Source width
+ * @param height Source height
+ * @param step Bytes between source rows
+ * @param channels 1 (gray) or 3 (BGR)
+ * @param thumbnail Output of thumbnailWidth x thumbnailHeight BGR pixels, rows packed
+ */
+void downscaleToThumbnail(const uint8_t* pixels, int width, int height, size_t step, int channels,
+                          uint8_t* thumbnail, int thumbnailWidth, int thumbnailHeight);
+
+/**
+ * @brief Decode a JPEG straight to a BGR thumbnail
+ *
+ * Decodes at the coarsest DCT scale (down to 1/8) that still covers the
+ * thumbnail, then box-filters the rest of the way.
+ * @return False if the data is not a JPEG libjpeg can decode
+ */
+bool decodeJpegThumbnail(const uint8_t* data, size_t size, uint8_t* thumbnail, int thumbnailWidth,
+                         int thumbnailHeight);
+
+/**
+ * @brief Thumbnails of a frame sequence, kept in a memory-mapped cache file
+ *
+ * The file is a header, a ready byte per frame and a fixed-size BGR slot per
+ * frame. It is sized for the whole sequence up front but stays sparse, so
+ * only generated thumbnails take disk space, and later launches show them
+ * without decoding anything. The file is named after the frame list and
+ * recreated when the list, the thumbnail size or the directory of the first
+ * frame changes. Without a usable cache directory the store lives in
+ * anonymous memory for the session.
+ *
+ * One thread may store() while others read; a thumbnail's pixels are
+ * complete once isReady() returns true for it.
+ */
+class ThumbnailStore {
+public:
+    /**
+     * @brief Open or create the thumbnail cache of a frame sequence
+     * @param frameFiles Frame files in sequence order
+     * @param thumbnailWidth Width of every thumbnail
+     * @param thumbnailHeight Height of every thumbnail
+     * @param cacheDirectory Directory of cache files, or empty to keep thumbnails in memory only
+     * @throws std::runtime_error if not even anonymous memory can be mapped
+     */
+    ThumbnailStore(const std::vector<std::string>& frameFiles, int thumbnailWidth, int thumbnailHeight,
+                   const std::string& cacheDirectory);
+    ~ThumbnailStore();
+
+    ThumbnailStore(const ThumbnailStore&) = delete;
+    ThumbnailStore& operator=(const ThumbnailStore&) = delete;
+
+    size_t size() const { return frameCount; }
+    int width() const { return thumbnailWidth; }
+    int height() const { return thumbnailHeight; }
+    size_t thumbnailBytes() const { return static_cast<size_t>(thumbnailWidth) * thumbnailHeight * 3; }
+
+    /**
+     * @brief Whether thumbnails are written to a cache file
+     */
+    bool persistent() const { return fd >= 0; }
+
+    /**
+     * @brief Thumbnails that were already in the cache file when it was opened
+     */
+    size_t cachedCount() const { return openedReady; }
+    size_t readyCount() const { return ready.load(std::memory_order_relaxed); }
+
+    bool isReady(size_t index) const {
+        return index < frameCount && readyFlags[index].load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * @brief BGR pixels of a thumbnail, rows packed; only meaningful once isReady()
+     */
+    const uint8_t* pixels(size_t index) const { return slots + index * thumbnailBytes(); }
+
+    /**
+     * @brief Copy in a thumbnail and mark it ready (one writing thread at a time)
+     * @return False if the cache file could not be written (the thumbnail stays missing)
+     */
+    bool store(size_t index, const uint8_t* thumbnail);
+
+    /**
+     * @brief Cache file of a frame list (also its key)
+     */
+    static std::string cachePath(const std::vector<std::string>& frameFiles, int thumbnailWidth, int thumbnailHeight,
+                                 const std::string& cacheDirectory);
+
+private:
+    bool openCacheFile(const std::string& path, const std::vector<std::string>& frameFiles);
+
+    size_t frameCount;
+    int thumbnailWidth;
+    int thumbnailHeight;
+    int fd;
+    uint8_t* mapping;
+    size_t mappingBytes;
+    uint8_t* flags; // Ready bytes in the mapping
+    uint8_t* slots; // Thumbnail pixels in the mapping
+    std::unique_ptr<std::atomic<uint8_t>[]> readyFlags;
+    std::atomic<size_t> ready;
+    size_t openedReady;
+};
+
+/**
+ * @brief Fills a thumbnail store in the background, outward from a cursor
+ *
+ * One thread at the lowest scheduling priority renders missing thumbnails
+ * nearest the cursor first, so the frames around it appear first and the
+ * rest of the sequence follows while the viewer is idle. It pauses while
+ * the viewer reports foreground work (frames the user is waiting for), and
+ * frames that fail to render are not retried.
+ */
+class ThumbnailGenerator {
+public:
+    /**
+     * @brief Renders the thumbnail of a frame into store-sized BGR pixels, or returns false
+     */
+    using Render = std::function<bool(size_t index, uint8_t* thumbnail)>;
+
+    /**
+     * @brief Returns true while the viewer has foreground decoding to do
+     */
+    using Busy = std::function<bool()>;
+
+    ThumbnailGenerator();
+    ~ThumbnailGenerator();
+
+    ThumbnailGenerator(const ThumbnailGenerator&) = delete;
+    ThumbnailGenerator& operator=(const ThumbnailGenerator&) = delete;
+
+    /**
+     * @brief Start filling a store
+     * @param store Store to fill; must outlive the generator or stop()
+     * @param render Renders one thumbnail, on the generator thread
+     * @param foregroundBusy Polled before each thumbnail; may be empty
+     */
+    void start(ThumbnailStore& store, Render render, Busy foregroundBusy = Busy());
+
+    /**
+     * @brief Stop and join the generator thread
+     */
+    void stop();
+
+    /**
+     * @brief Generate outward from this frame from now on
+     */
+    void setCursor(size_t index);
+
+    size_t generatedCount() const { return generated.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Time spent rendering, over all generated thumbnails (read after stop())
+     */
+    double renderMilliseconds() const { return milliseconds; }
+
+private:
+    void generateLoop();
+    bool nextMissing(size_t& index);
+
+    ThumbnailStore* store;
+    Render render;
+    Busy foregroundBusy;
+    std::thread generatorThread;
+    std::atomic<bool> running;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> cursor;
+    std::vector<uint8_t> failed; // Generator thread only
+    size_t scanCursor;           // Cursor the scan distance belongs to
+    size_t scanDistance;         // Every frame closer to scanCursor is ready or failed
+    std::atomic<size_t> generated;
+    double milliseconds;
+};
+
+/**
+ * @brief Where thumbnails go in a set of atlas pages
+ *
+ * Pages are grids of thumbnail-sized cells, uploaded as one texture each so
+ * a filmstrip draws with one call per page. Frames map directly to cells
+ * (frame i to cell i % capacity), so any run of up to capacity consecutive
+ * frames, such as the filmstrip around the cursor, never collides and cells
+ * need no eviction bookkeeping; the cells beyond the visible strip keep
+ * recently shown thumbnails for scrubbing back.
+ */
+struct ThumbnailAtlasLayout {
+    int thumbnailWidth = 0;
+    int thumbnailHeight = 0;
+    int columns = 0;      // Cells per page row
+    int rows = 0;         // Cell rows per page
+    int pages = 0;
+    int pageWidth = 0;    // Texture size of every page
+    int pageHeight = 0;
+
+    /**
+     * @brief Lay out pages holding at least a given number of thumbnails
+     * @param thumbnailWidth Width of every thumbnail
+     * @param thumbnailHeight Height of every thumbnail
+     * @param thumbnails Cells wanted (the strip's worst case plus scrubbing slack)
+     * @param maxPageSize Largest texture side
+     */
+    ThumbnailAtlasLayout(int thumbnailWidth, int thumbnailHeight, size_t thumbnails, int maxPageSize = 2048);
+    ThumbnailAtlasLayout() = default;
+
+    size_t capacity() const { return static_cast<size_t>(columns) * rows * pages; }
+    size_t cell(size_t index) const { return index % capacity(); }
+    int page(size_t cell) const { return static_cast<int>(cell / (static_cast<size_t>(columns) * rows)); }
+
+    /**
+     * @brief Top left corner of a cell in its page
+     */
+    void cellOrigin(size_t cell, int& x, int& y) const;
+};
+
+/**
+ * @brief Slots of a filmstrip centred on the cursor
+ *
+ * The cursor's thumbnail sits in the middle slot; slots before the first or
+ * after the last frame stay empty.
+ */
+struct FilmstripLayout {
+    long firstFrame = 0; // Frame of slot 0, negative when the strip starts before the sequence
+    int slots = 0;
+    int left = 0;        // X of slot 0
+    int pitch = 1;       // Thumbnail width plus gap
+
+    /**
+     * @brief Fit as many slots as a strip width holds, an odd number so one is centred
+     */
+    static FilmstripLayout centred(size_t cursor, int stripWidth, int thumbnailWidth, int gap);
+
+    /**
+     * @brief Frame of the slot under an x coordinate, or -1 outside the strip and on empty slots
+     * @param frameCount Frames in the sequence
+     */
+    long frameAt(int x, size_t frameCount) const;
+};
+
+} // namespace frame_pipeline
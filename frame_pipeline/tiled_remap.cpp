@@ -0,0 +1,151 @@
+#include "tiled_remap.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace frame_pipeline {
+
+namespace {
+
+// Interleave the bits of two 16-bit coordinates into a Z-order key
+uint32_t mortonKey(uint32_t x, uint32_t y) {
+    uint32_t key = 0;
+    for (int bit = 0; bit < 16; ++bit) {
+        key |= ((x >> bit) & 1u) << (2 * bit);
+        key |= ((y >> bit) & 1u) << (2 * bit + 1);
+    }
+    return key;
+}
+
+cv::Rect unite(const cv::Rect& a, const cv::Rect& b) {
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+    return a | b;
+}
+
+} // namespace
+
+TiledRemap::TiledRemap(const cv::Mat& map1, const cv::Mat& map2, cv::Size sourceSize,
+                       size_t sourcePixelBytes, size_t cacheBytes)
+    : map1(map1), map2(map2), sourceSize(sourceSize), sourcePixelBytes(sourcePixelBytes) {
+    if (map1.type() != CV_16SC2 || map2.type() != CV_16UC1 || map1.size() != map2.size()) {
+        throw std::runtime_error("Tiled remap needs CV_16SC2 and CV_16UC1 maps of the same size");
+    }
+    
+    // Source bounding box of every block; bilinear taps read one pixel right and below
+    cv::Rect sourceArea(0, 0, sourceSize.width, sourceSize.height);
+    int blocksX = (map1.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    int blocksY = (map1.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<cv::Rect> blockSources(static_cast<size_t>(blocksX) * blocksY);
+    
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            int minX = std::numeric_limits<int>::max(), minY = minX;
+            int maxX = std::numeric_limits<int>::min(), maxY = maxX;
+            int rowEnd = std::min((by + 1) * BLOCK_SIZE, map1.rows);
+            int colEnd = std::min((bx + 1) * BLOCK_SIZE, map1.cols);
+            
+            for (int y = by * BLOCK_SIZE; y < rowEnd; ++y) {
+                const cv::Vec2s* row = map1.ptr<cv::Vec2s>(y);
+                for (int x = bx * BLOCK_SIZE; x < colEnd; ++x) {
+                    int sx = row[x][0], sy = row[x][1];
+                    // Taps entirely outside the source only read the border value
+                    if (sx < -1 || sy < -1 || sx >= sourceSize.width || sy >= sourceSize.height) {
+                        continue;
+                    }
+                    minX = std::min(minX, sx);
+                    minY = std::min(minY, sy);
+                    maxX = std::max(maxX, sx);
+                    maxY = std::max(maxY, sy);
+                }
+            }
+            
+            if (minX <= maxX) {
+                blockSources[static_cast<size_t>(by) * blocksX + bx] =
+                    cv::Rect(minX, minY, maxX - minX + 2, maxY - minY + 2) & sourceArea;
+            }
+        }
+    }
+    
+    // Split every maximal tile until its source footprint fits the budget
+    const int tileBlocks = MAX_TILE_SIZE / BLOCK_SIZE;
+    for (int by = 0; by < blocksY; by += tileBlocks) {
+        for (int bx = 0; bx < blocksX; bx += tileBlocks) {
+            cv::Rect blocks(bx, by, std::min(tileBlocks, blocksX - bx), std::min(tileBlocks, blocksY - by));
+            planRegion(blockSources, blocksX, blocks, cacheBytes);
+        }
+    }
+    
+    // Z-order of the source centre keeps consecutive tiles on shared source lines
+    auto sourceKey = [](const RemapTile& tile) {
+        if (tile.source.empty()) {
+            return std::numeric_limits<uint32_t>::max();
+        }
+        return mortonKey((tile.source.x + tile.source.width / 2) / BLOCK_SIZE,
+                         (tile.source.y + tile.source.height / 2) / BLOCK_SIZE);
+    };
+    std::stable_sort(tileOrder.begin(), tileOrder.end(), [&](const RemapTile& a, const RemapTile& b) {
+        return sourceKey(a) < sourceKey(b);
+    });
+}
+
+void TiledRemap::planRegion(const std::vector<cv::Rect>& blockSources, int blocksX,
+                            cv::Rect blocks, size_t cacheBytes) {
+    cv::Rect source;
+    for (int by = blocks.y; by < blocks.y + blocks.height; ++by) {
+        for (int bx = blocks.x; bx < blocks.x + blocks.width; ++bx) {
+            source = unite(source, blockSources[static_cast<size_t>(by) * blocksX + bx]);
+        }
+    }
+    
+    size_t footprint = static_cast<size_t>(source.area()) * sourcePixelBytes;
+    if (footprint > cacheBytes && blocks.area() > 1) {
+        // Halve along the longer side
+        cv::Rect first = blocks, second = blocks;
+        if (blocks.width >= blocks.height) {
+            first.width = blocks.width / 2;
+            second.x += first.width;
+            second.width -= first.width;
+        } else {
+            first.height = blocks.height / 2;
+            second.y += first.height;
+            second.height -= first.height;
+        }
+        planRegion(blockSources, blocksX, first, cacheBytes);
+        planRegion(blockSources, blocksX, second, cacheBytes);
+        return;
+    }
+    
+    RemapTile tile;
+    tile.output = cv::Rect(blocks.x * BLOCK_SIZE, blocks.y * BLOCK_SIZE,
+                           blocks.width * BLOCK_SIZE, blocks.height * BLOCK_SIZE) &
+                  cv::Rect(0, 0, map1.cols, map1.rows);
+    tile.source = source;
+    tileOrder.push_back(tile);
+}
+
+void TiledRemap::apply(const cv::Mat& source, cv::Mat& destination, int interpolation,
+                       int borderMode, const cv::Scalar& borderValue) const {
+    CV_Assert(source.size() == sourceSize);
+    destination.create(map1.size(), source.type());
+    
+    // Each worker gets a contiguous run of tiles, so it walks neighbouring source regions
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tileOrder.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            const cv::Rect& region = tileOrder[i].output;
+            cv::Mat target = destination(region);
+            cv::remap(source, target, map1(region), map2(region), interpolation, borderMode, borderValue);
+        }
+    });
+}
+
+size_t TiledRemap::largestFootprintBytes() const {
+    size_t largest = 0;
+    for (const RemapTile& tile : tileOrder) {
+        largest = std::max(largest, static_cast<size_t>(tile.source.area()) * sourcePixelBytes);
+    }
+    return largest;
+}
+
+} // namespace frame_pipeline
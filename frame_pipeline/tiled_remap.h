@@ -0,0 +1,74 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace frame_pipeline {
+
+/**
+ * @brief Output region of a tiled remap and the source pixels it reads
+ */
+struct RemapTile {
+    cv::Rect output; // Region of the destination image
+    cv::Rect source; // Bounding box of the source pixels read, empty if all fall outside
+};
+
+/**
+ * @brief cv::remap split into output tiles whose source footprint fits in cache
+ *
+ * Remapping an ultra-wide unwrap in output row order sweeps across the whole
+ * fisheye source for every few rows, so source pixels are evicted before
+ * neighbouring rows need them again. The plan divides the output into tiles
+ * small enough that the source pixels each one reads fit in the cache
+ * budget, and orders tiles along a Z-order curve of their source location so
+ * consecutive tiles share source lines. apply() hands contiguous runs of
+ * tiles to cv::parallel_for_ workers and produces the same pixels as
+ * cv::remap with the full maps.
+ */
+class TiledRemap {
+public:
+    static const int BLOCK_SIZE = 16;                       // Tiles are multiples of this many pixels
+    static const int MAX_TILE_SIZE = 256;                   // Largest tile edge, in pixels
+    static const size_t DEFAULT_CACHE_BYTES = 256 << 10;    // Source bytes per tile, half a typical L2
+
+    /**
+     * @brief Plan the tiles of a pair of fixed-point maps
+     * @param map1 CV_16SC2 integer source coordinates, as built by initUndistortRectifyMap
+     * @param map2 CV_16UC1 interpolation table indices
+     * @param sourceSize Size of the images to remap
+     * @param sourcePixelBytes Bytes per source pixel (3 for BGR, 1 for gray)
+     * @param cacheBytes Source bytes a tile may read, unless it is a single block
+     * @throws std::runtime_error if the maps are not fixed-point maps of one size
+     */
+    TiledRemap(const cv::Mat& map1, const cv::Mat& map2, cv::Size sourceSize,
+               size_t sourcePixelBytes, size_t cacheBytes = DEFAULT_CACHE_BYTES);
+
+    /**
+     * @brief Remap an image tile by tile
+     * @param source Image of the planned source size
+     * @param destination Receives the remapped image, the size of the maps
+     */
+    void apply(const cv::Mat& source, cv::Mat& destination, int interpolation = cv::INTER_LINEAR,
+               int borderMode = cv::BORDER_CONSTANT, const cv::Scalar& borderValue = cv::Scalar()) const;
+
+    /**
+     * @brief Tiles in processing order
+     */
+    const std::vector<RemapTile>& tiles() const { return tileOrder; }
+
+    /**
+     * @brief Source bytes read by the tile with the largest footprint
+     */
+    size_t largestFootprintBytes() const;
+
+private:
+    void planRegion(const std::vector<cv::Rect>& blockSources, int blocksX,
+                    cv::Rect blocks, size_t cacheBytes);
+
+    cv::Mat map1, map2;
+    cv::Size sourceSize;
+    size_t sourcePixelBytes;
+    std::vector<RemapTile> tileOrder;
+};
+
+} // namespace frame_pipeline
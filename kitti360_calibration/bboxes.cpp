@@ -0,0 +1,362 @@
+#include "bboxes.h"
+#include "mapped_text.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace kitti360 {
+
+const uint8_t BOX_EDGES[12][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7}, // Along x
+    {0, 2}, {1, 3}, {4, 6}, {5, 7}, // Along y
+    {0, 4}, {1, 5}, {2, 6}, {3, 7}  // Along z
+};
+
+namespace {
+
+// Streets are a few cells wide; buildings span several cells
+const double GRID_CELL_METERS = 20.0;
+const int MAX_GRID_CELLS_PER_AXIS = 4096;
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Contents of the first <name ...>...</name> element in text, or empty if there is none
+std::string_view element(std::string_view text, std::string_view name) {
+    size_t open = 0;
+    while ((open = text.find(name, open)) != std::string_view::npos) {
+        size_t after = open + name.size();
+        if (open > 0 && text[open - 1] == '<' && after < text.size() && (text[after] == '>' || isSpace(text[after]))) {
+            size_t begin = text.find('>', after);
+            if (begin == std::string_view::npos) break;
+            size_t end = text.find("</" + std::string(name) + ">", begin);
+            if (end == std::string_view::npos) break;
+            return text.substr(begin + 1, end - begin - 1);
+        }
+        open = after;
+    }
+    return std::string_view();
+}
+
+template <typename T>
+bool parseValue(std::string_view text, T& value) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end && isSpace(*p)) ++p;
+    while (end > p && isSpace(end[-1])) --end;
+    auto parsed = std::from_chars(p, end, value);
+    return parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+// Values of an opencv-matrix element (<rows>, <cols>, <data>) with the expected shape
+std::vector<double> parseMatrix(std::string_view matrix, int rows, int cols) {
+    int actualRows = 0, actualCols = 0;
+    if (!parseValue(element(matrix, "rows"), actualRows) || !parseValue(element(matrix, "cols"), actualCols) ||
+        actualRows != rows || actualCols != cols) {
+        throw std::runtime_error("Expected a " + std::to_string(rows) + "x" + std::to_string(cols) + " matrix");
+    }
+    
+    std::string_view data = element(matrix, "data");
+    std::vector<double> values;
+    values.reserve(static_cast<size_t>(rows) * cols);
+    const char* p = data.data();
+    const char* end = p + data.size();
+    while (true) {
+        while (p < end && isSpace(*p)) ++p;
+        if (p == end) break;
+        double value;
+        auto parsed = std::from_chars(p, end, value);
+        if (parsed.ec != std::errc()) {
+            throw std::runtime_error("Malformed matrix value");
+        }
+        values.push_back(value);
+        p = parsed.ptr;
+    }
+    if (values.size() != static_cast<size_t>(rows) * cols) {
+        throw std::runtime_error("Expected " + std::to_string(rows * cols) + " matrix values, got " +
+                                 std::to_string(values.size()));
+    }
+    return values;
+}
+
+// Box of one annotated object, corners in world coordinates
+void parseObject(std::string_view object, Box3D& box, cv::Vec3d corners[8]) {
+    std::vector<double> transform = parseMatrix(element(object, "transform"), 4, 4);
+    std::vector<double> vertices = parseMatrix(element(object, "vertices"), 8, 3);
+    
+    // Order the corners by the side of the box centre they lie on in the box's own frame
+    double centre[3] = {0.0, 0.0, 0.0};
+    for (int vertex = 0; vertex < 8; ++vertex) {
+        for (int axis = 0; axis < 3; ++axis) {
+            centre[axis] += vertices[vertex * 3 + axis] / 8.0;
+        }
+    }
+    int seen = 0;
+    for (int vertex = 0; vertex < 8; ++vertex) {
+        const double* local = &vertices[vertex * 3];
+        int corner = (local[0] > centre[0] ? 1 : 0) | (local[1] > centre[1] ? 2 : 0) | (local[2] > centre[2] ? 4 : 0);
+        seen |= 1 << corner;
+        for (int row = 0; row < 3; ++row) {
+            corners[corner][row] = transform[row * 4] * local[0] + transform[row * 4 + 1] * local[1] +
+                                   transform[row * 4 + 2] * local[2] + transform[row * 4 + 3];
+        }
+    }
+    if (seen != 0xff) {
+        throw std::runtime_error("Vertices do not form a box");
+    }
+    
+    int semanticId = 0, timestamp = -1;
+    long long startFrame = 0, endFrame = std::numeric_limits<uint32_t>::max();
+    uint32_t instanceId = 0;
+    parseValue(element(object, "semanticId"), semanticId);
+    parseValue(element(object, "instanceId"), instanceId);
+    parseValue(element(object, "timestamp"), timestamp);
+    parseValue(element(object, "start_frame"), startFrame);
+    parseValue(element(object, "end_frame"), endFrame);
+    
+    box.semanticId = static_cast<uint16_t>(std::clamp(semanticId, 0, 65535));
+    box.instanceId = instanceId;
+    box.dynamic = timestamp >= 0;
+    if (box.dynamic) {
+        box.firstFrame = box.lastFrame = static_cast<uint32_t>(timestamp);
+    } else {
+        box.firstFrame = static_cast<uint32_t>(std::clamp(startFrame, 0LL, static_cast<long long>(UINT32_MAX)));
+        box.lastFrame = static_cast<uint32_t>(std::clamp(endFrame, 0LL, static_cast<long long>(UINT32_MAX)));
+    }
+}
+
+} // namespace
+
+BoxAnnotations BoxAnnotations::load(const std::string& filename) {
+    MappedText mapped(filename, "annotation file");
+    try {
+        return parse(mapped.text());
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
+
+BoxAnnotations BoxAnnotations::parse(std::string_view text) {
+    BoxAnnotations annotations;
+    
+    // Children of the root element (<opencv_storage>), after the <?xml ...?> declaration
+    size_t root = text.find('<');
+    while (root != std::string_view::npos && root + 1 < text.size() && (text[root + 1] == '?' || text[root + 1] == '!')) {
+        root = text.find('<', root + 1);
+    }
+    if (root == std::string_view::npos) {
+        return annotations;
+    }
+    size_t p = text.find('>', root);
+    
+    size_t objectNumber = 0;
+    bool originSet = false;
+    while (p != std::string_view::npos) {
+        size_t open = text.find('<', p);
+        if (open == std::string_view::npos || open + 1 >= text.size() || text[open + 1] == '/') break;
+        if (text.compare(open, 4, "<!--") == 0) {
+            size_t close = text.find("-->", open);
+            p = close == std::string_view::npos ? close : close + 3;
+            continue;
+        }
+        
+        size_t nameEnd = open + 1;
+        while (nameEnd < text.size() && text[nameEnd] != '>' && text[nameEnd] != '/' && !isSpace(text[nameEnd])) ++nameEnd;
+        std::string closing = "</" + std::string(text.substr(open + 1, nameEnd - open - 1)) + ">";
+        size_t close = text.find(closing, nameEnd);
+        if (close == std::string_view::npos) {
+            throw std::runtime_error("Unterminated element " + closing.substr(2, closing.size() - 3));
+        }
+        std::string_view object = text.substr(nameEnd, close - nameEnd);
+        p = close + closing.size();
+        ++objectNumber;
+        
+        // Like KITTI-360's own scripts, elements without a transform are not boxes
+        if (element(object, "transform").empty()) continue;
+        
+        Box3D box;
+        cv::Vec3d corners[8];
+        try {
+            parseObject(object, box, corners);
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("Object " + std::to_string(objectNumber) + ": " + e.what());
+        }
+        
+        // Single precision relative to the first corner stays well below a millimetre across a drive
+        if (!originSet) {
+            annotations.worldOrigin = corners[0];
+            originSet = true;
+        }
+        for (int corner = 0; corner < 8; ++corner) {
+            for (int axis = 0; axis < 3; ++axis) {
+                box.corners[corner][axis] = static_cast<float>(corners[corner][axis] - annotations.worldOrigin[axis]);
+            }
+        }
+        annotations.boxes.push_back(box);
+    }
+    
+    annotations.buildSpatialIndex();
+    return annotations;
+}
+
+void BoxAnnotations::buildSpatialIndex() {
+    if (boxes.empty()) return;
+    
+    // Ground-plane footprints of the boxes and their bounds
+    std::vector<cv::Rect2d> footprints;
+    footprints.reserve(boxes.size());
+    double minX = std::numeric_limits<double>::max(), maxX = std::numeric_limits<double>::lowest();
+    double minY = minX, maxY = maxX;
+    for (const Box3D& box : boxes) {
+        double boxMinX = box.corners[0][0], boxMaxX = boxMinX;
+        double boxMinY = box.corners[0][1], boxMaxY = boxMinY;
+        for (int corner = 1; corner < 8; ++corner) {
+            boxMinX = std::min(boxMinX, static_cast<double>(box.corners[corner][0]));
+            boxMaxX = std::max(boxMaxX, static_cast<double>(box.corners[corner][0]));
+            boxMinY = std::min(boxMinY, static_cast<double>(box.corners[corner][1]));
+            boxMaxY = std::max(boxMaxY, static_cast<double>(box.corners[corner][1]));
+        }
+        footprints.push_back(cv::Rect2d(boxMinX, boxMinY, boxMaxX - boxMinX, boxMaxY - boxMinY));
+        minX = std::min(minX, boxMinX);
+        maxX = std::max(maxX, boxMaxX);
+        minY = std::min(minY, boxMinY);
+        maxY = std::max(maxY, boxMaxY);
+    }
+    
+    gridX = minX;
+    gridY = minY;
+    cellSize = std::max({GRID_CELL_METERS, (maxX - minX) / MAX_GRID_CELLS_PER_AXIS, (maxY - minY) / MAX_GRID_CELLS_PER_AXIS});
+    gridColumns = static_cast<int>((maxX - minX) / cellSize) + 1;
+    gridRows = static_cast<int>((maxY - minY) / cellSize) + 1;
+    
+    // Cell range of each footprint, then a counting sort of (cell, box) entries
+    auto cellRange = [&](const cv::Rect2d& footprint, int& firstColumn, int& lastColumn, int& firstRow, int& lastRow) {
+        firstColumn = std::min(static_cast<int>((footprint.x - gridX) / cellSize), gridColumns - 1);
+        lastColumn = std::min(static_cast<int>((footprint.x + footprint.width - gridX) / cellSize), gridColumns - 1);
+        firstRow = std::min(static_cast<int>((footprint.y - gridY) / cellSize), gridRows - 1);
+        lastRow = std::min(static_cast<int>((footprint.y + footprint.height - gridY) / cellSize), gridRows - 1);
+    };
+    cellStart.assign(static_cast<size_t>(gridColumns) * gridRows + 1, 0);
+    for (const cv::Rect2d& footprint : footprints) {
+        int firstColumn, lastColumn, firstRow, lastRow;
+        cellRange(footprint, firstColumn, lastColumn, firstRow, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                ++cellStart[static_cast<size_t>(row) * gridColumns + column + 1];
+            }
+        }
+    }
+    for (size_t cell = 1; cell < cellStart.size(); ++cell) {
+        cellStart[cell] += cellStart[cell - 1];
+    }
+    cellBoxes.resize(cellStart.back());
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t index = 0; index < footprints.size(); ++index) {
+        int firstColumn, lastColumn, firstRow, lastRow;
+        cellRange(footprints[index], firstColumn, lastColumn, firstRow, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                cellBoxes[fill[static_cast<size_t>(row) * gridColumns + column]++] = static_cast<uint32_t>(index);
+            }
+        }
+    }
+}
+
+void BoxAnnotations::visibleBoxes(uint32_t frameNumber, double x, double y, double radius,
+                                  std::vector<uint32_t>& indices) const {
+    indices.clear();
+    if (boxes.empty()) return;
+    
+    // Query coordinates are in the world; the grid is relative to the origin
+    x -= worldOrigin[0];
+    y -= worldOrigin[1];
+    double firstX = std::floor((x - radius - gridX) / cellSize), lastX = std::floor((x + radius - gridX) / cellSize);
+    double firstY = std::floor((y - radius - gridY) / cellSize), lastY = std::floor((y + radius - gridY) / cellSize);
+    if (lastX < 0.0 || lastY < 0.0 || firstX >= gridColumns || firstY >= gridRows) return;
+    int firstColumn = static_cast<int>(std::max(firstX, 0.0));
+    int lastColumn = static_cast<int>(std::min(lastX, gridColumns - 1.0));
+    int firstRow = static_cast<int>(std::max(firstY, 0.0));
+    int lastRow = static_cast<int>(std::min(lastY, gridRows - 1.0));
+    
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            size_t cell = static_cast<size_t>(row) * gridColumns + column;
+            for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                const Box3D& box = boxes[cellBoxes[i]];
+                if (frameNumber >= box.firstFrame && frameNumber <= box.lastFrame) {
+                    indices.push_back(cellBoxes[i]);
+                }
+            }
+        }
+    }
+    
+    // Boxes spanning several cells were found once per cell
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+}
+
+void projectBoxEdges(const Box3D& box, const cv::Matx44d& worldToCamera, const cv::Matx33d& cameraMatrix,
+                     std::vector<cv::Point2f>& segments, double nearPlane) {
+    double points[8][3];
+    for (int corner = 0; corner < 8; ++corner) {
+        const float* world = box.corners[corner];
+        for (int row = 0; row < 3; ++row) {
+            points[corner][row] = worldToCamera(row, 0) * world[0] + worldToCamera(row, 1) * world[1] +
+                                  worldToCamera(row, 2) * world[2] + worldToCamera(row, 3);
+        }
+    }
+    
+    auto project = [&](const double* point) {
+        double w = cameraMatrix(2, 0) * point[0] + cameraMatrix(2, 1) * point[1] + cameraMatrix(2, 2) * point[2];
+        return cv::Point2f(
+            static_cast<float>((cameraMatrix(0, 0) * point[0] + cameraMatrix(0, 1) * point[1] + cameraMatrix(0, 2) * point[2]) / w),
+            static_cast<float>((cameraMatrix(1, 0) * point[0] + cameraMatrix(1, 1) * point[1] + cameraMatrix(1, 2) * point[2]) / w));
+    };
+    
+    for (const auto& edge : BOX_EDGES) {
+        double a[3], b[3];
+        std::copy(points[edge[0]], points[edge[0]] + 3, a);
+        std::copy(points[edge[1]], points[edge[1]] + 3, b);
+        if (a[2] < nearPlane && b[2] < nearPlane) continue;
+        
+        // Move the end behind the near plane onto it
+        if (a[2] < nearPlane || b[2] < nearPlane) {
+            double* behind = a[2] < nearPlane ? a : b;
+            const double* front = a[2] < nearPlane ? b : a;
+            double t = (nearPlane - behind[2]) / (front[2] - behind[2]);
+            for (int axis = 0; axis < 3; ++axis) {
+                behind[axis] += t * (front[axis] - behind[axis]);
+            }
+        }
+        segments.push_back(project(a));
+        segments.push_back(project(b));
+    }
+}
+
+std::string findBoxAnnotationFile(const std::string& frameDirectory) {
+    std::error_code error;
+    fs::path directory = fs::weakly_canonical(frameDirectory, error);
+    if (error) directory = frameDirectory;
+    
+    // Walk up to <root>/data_2d_raw/<drive>
+    for (fs::path drive = directory; drive.has_parent_path() && drive != drive.parent_path(); drive = drive.parent_path()) {
+        if (drive.parent_path().filename() != "data_2d_raw") continue;
+        fs::path boxes = drive.parent_path().parent_path() / "data_3d_bboxes";
+        for (const char* split : {"train", "train_full"}) {
+            fs::path candidate = boxes / split / (drive.filename().string() + ".xml");
+            if (fs::is_regular_file(candidate, error)) {
+                return candidate.string();
+            }
+        }
+        break;
+    }
+    return "";
+}
+
+} // namespace kitti360
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kitti360 {
+
+/**
+ * @brief One annotated 3D bounding box, corners in world coordinates
+ *
+ * Corner i lies on the positive side of the box's local x, y and z axes
+ * where bits 0, 1 and 2 of i are set, so edges join corners differing in
+ * one bit (see BOX_EDGES). Corners are stored relative to the annotation
+ * set's origin in single precision to keep the array compact.
+ */
+struct Box3D {
+    float corners[8][3];
+    uint32_t firstFrame; // Frames the box is annotated in: [firstFrame, lastFrame]
+    uint32_t lastFrame;
+    uint32_t instanceId;
+    uint16_t semanticId; // KITTI-360 semantic class
+    bool dynamic;        // Moving object annotated in a single frame
+};
+
+/**
+ * @brief Corner pairs of the 12 edges of a Box3D
+ */
+extern const uint8_t BOX_EDGES[12][2];
+
+/**
+ * @brief KITTI-360 3D bounding box annotations with a per-frame visibility index
+ *
+ * Boxes are looked up by frame range and by a uniform grid over the ground
+ * plane: each box is listed in every cell its footprint overlaps, stored as
+ * one array with per-cell offsets, so a frame's query only visits the cells
+ * around the camera.
+ */
+class BoxAnnotations {
+public:
+    /**
+     * @brief Memory-map and parse a data_3d_bboxes/<split>/<drive>.xml file
+     *
+     * Static objects are annotated over their start_frame..end_frame range,
+     * dynamic objects once per frame (their timestamp). Each box's world
+     * corners are its local vertices transformed by its 4x4 transform.
+     * @param filename Path to the annotation file
+     * @throws std::runtime_error if the file cannot be read or an object is malformed
+     */
+    static BoxAnnotations load(const std::string& filename);
+
+    /**
+     * @brief Parse annotation file contents held in memory
+     * @throws std::runtime_error if an object is malformed
+     */
+    static BoxAnnotations parse(std::string_view text);
+
+    size_t size() const { return boxes.size(); }
+    bool empty() const { return boxes.empty(); }
+    const Box3D& box(size_t index) const { return boxes[index]; }
+
+    /**
+     * @brief World position corner coordinates are relative to
+     */
+    const cv::Vec3d& origin() const { return worldOrigin; }
+
+    /**
+     * @brief Boxes annotated in a frame near a place on the ground plane
+     * @param frameNumber Frame to show
+     * @param x World x in metres
+     * @param y World y in metres
+     * @param radius Half the side of the square searched, in metres
+     * @param indices Receives the box indices, ascending
+     */
+    void visibleBoxes(uint32_t frameNumber, double x, double y, double radius, std::vector<uint32_t>& indices) const;
+
+private:
+    void buildSpatialIndex();
+
+    std::vector<Box3D> boxes;
+    cv::Vec3d worldOrigin;
+
+    // Grid over the ground plane: boxes overlapping cell c are cellBoxes[cellStart[c] .. cellStart[c + 1])
+    double gridX = 0.0;
+    double gridY = 0.0;
+    double cellSize = 1.0;
+    int gridColumns = 0;
+    int gridRows = 0;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellBoxes;
+};
+
+/**
+ * @brief Project the edges of a box into a pinhole camera
+ *
+ * Edges are clipped at the near plane before projection, so boxes partly
+ * behind the camera keep their visible part and boxes fully behind it add
+ * nothing. Projected edges are straight, as the views are pinhole images.
+ * @param box Box to project
+ * @param worldToCamera Transform from the annotation set's origin-relative world frame to the camera
+ * @param cameraMatrix 3x3 projection of the camera
+ * @param segments Receives two image points per visible edge
+ * @param nearPlane Least depth in metres
+ */
+void projectBoxEdges(const Box3D& box, const cv::Matx44d& worldToCamera, const cv::Matx33d& cameraMatrix,
+                     std::vector<cv::Point2f>& segments, double nearPlane = 0.1);
+
+/**
+ * @brief 3D bounding box annotations of the drive a frame directory belongs to
+ *
+ * Follows KITTI-360's layout, where the frames of a drive are in
+ * <root>/data_2d_raw/<drive>/image_0X/... and its boxes in
+ * <root>/data_3d_bboxes/train/<drive>.xml (or train_full/).
+ * @return Path of the annotation file, or an empty string if there is none
+ */
+std::string findBoxAnnotationFile(const std::string& frameDirectory);
+
+} // namespace kitti360
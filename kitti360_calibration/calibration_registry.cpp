@@ -0,0 +1,416 @@
+#include "calibration_registry.h"
+#include "map_cache.h"
+#include <filesystem>
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+namespace kitti360 {
+
+namespace {
+
+// FNV-1a, good enough to tell calibration file revisions apart
+uint64_t hashBytes(uint64_t hash, const std::string& bytes) {
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Cache file name identifying camera, calibration contents and unwrap settings
+std::string mapCacheFilename(const std::string& cameraName, uint64_t contentHash, const UnwrapSettings& settings) {
+    char name[160];
+    std::snprintf(name, sizeof(name), "%s_%016llx_f%.3f_w%.3f_h%.3f.k360map", cameraName.c_str(),
+                  static_cast<unsigned long long>(contentHash),
+                  settings.focalScale, settings.widthMultiplier, settings.heightMultiplier);
+    return name;
+}
+
+// Rectification maps depend on the calibration alone
+std::string rectificationCacheFilename(const std::string& cameraName, uint64_t contentHash) {
+    char name[160];
+    std::snprintf(name, sizeof(name), "%s_%016llx_rect.k360map", cameraName.c_str(),
+                  static_cast<unsigned long long>(contentHash));
+    return name;
+}
+
+// Remove the packages other calibration revisions left for the same camera and settings. Names differ
+// from the current package only in the 16 hex digits of the hash; processes still mapping a removed
+// package keep reading it until they unmap it
+void removeOtherRevisionPackages(const std::string& cachePath, const std::string& cameraName) {
+    fs::path current(cachePath);
+    std::string currentName = current.filename().string();
+    size_t hashStart = cameraName.size() + 1;
+    size_t hashEnd = hashStart + 16;
+    if (currentName.size() < hashEnd) return;
+    std::string prefix = currentName.substr(0, hashStart);
+    std::string suffix = currentName.substr(hashEnd);
+    
+    auto isHexDigit = [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; };
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(current.parent_path(), error)) {
+        std::string name = entry.path().filename().string();
+        if (name == currentName || name.size() != currentName.size() ||
+            name.compare(0, hashStart, prefix) != 0 || name.compare(hashEnd, std::string::npos, suffix) != 0 ||
+            !std::all_of(name.begin() + hashStart, name.begin() + hashEnd, isHexDigit)) {
+            continue;
+        }
+        if (fs::remove(entry.path(), error)) {
+            std::cout << "Removed outdated map cache entry " << name << std::endl;
+        }
+    }
+}
+
+// Drop the entries of other revisions of a directory; keys start with (directory, content hash)
+template <typename Cache>
+void eraseOtherRevisions(Cache& cache, const std::string& directory, uint64_t contentHash) {
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (std::get<0>(it->first) == directory && std::get<1>(it->first) != contentHash) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+const char* const PERSPECTIVE_CAMERAS[] = {"image_00", "image_01"};
+
+const char* const TEXT_CALIBRATION_FILES[] = {
+    "calib_cam_to_pose.txt", "calib_cam_to_velo.txt", "calib_sick_to_velo.txt", "perspective.txt"
+};
+
+} // namespace
+
+FisheyeCamera makeFisheyeCamera(const FisheyeParams& params) {
+    FisheyeCamera camera;
+    camera.params = params;
+    
+    camera.cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
+    camera.cameraMatrix.at<double>(0, 0) = params.projection[0]; // gamma1 (fx)
+    camera.cameraMatrix.at<double>(1, 1) = params.projection[1]; // gamma2 (fy)
+    camera.cameraMatrix.at<double>(0, 2) = params.projection[2]; // u0 (cx)
+    camera.cameraMatrix.at<double>(1, 2) = params.projection[3]; // v0 (cy)
+    
+    // Map MEI model parameters to OpenCV fisheye model: k1, k2, p1->k3, p2->k4
+    camera.distCoeffs = cv::Mat::zeros(4, 1, CV_64F);
+    for (int i = 0; i < 4; ++i) {
+        camera.distCoeffs.at<double>(i) = params.distortion[i];
+    }
+    
+    return camera;
+}
+
+UndistortionMaps buildUnwrapMaps(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs,
+                                 cv::Size inputSize, const UnwrapSettings& settings) {
+    UndistortionMaps maps;
+    maps.inputSize = inputSize;
+    maps.outputSize.width = static_cast<int>(inputSize.width * settings.widthMultiplier);
+    maps.outputSize.height = static_cast<int>(inputSize.height * settings.heightMultiplier);
+    
+    // Centre the principal point in the larger output and expand the focal length
+    maps.newCameraMatrix = cameraMatrix.clone();
+    maps.newCameraMatrix.at<double>(0, 2) = maps.outputSize.width / 2.0;  // cx
+    maps.newCameraMatrix.at<double>(1, 2) = maps.outputSize.height / 2.0; // cy
+    maps.newCameraMatrix.at<double>(0, 0) *= settings.focalScale;         // fx
+    maps.newCameraMatrix.at<double>(1, 1) *= settings.focalScale;         // fy
+    
+    try {
+        cv::fisheye::initUndistortRectifyMap(
+            cameraMatrix, distCoeffs, cv::Mat(),
+            maps.newCameraMatrix, maps.outputSize, CV_16SC2,
+            maps.map1, maps.map2
+        );
+    } catch (const cv::Exception& e) {
+        std::cerr << "Fisheye undistortion failed: " << e.what() << std::endl;
+        std::cerr << "Falling back to standard undistortion..." << std::endl;
+        cv::initUndistortRectifyMap(
+            cameraMatrix, distCoeffs, cv::Mat(),
+            maps.newCameraMatrix, maps.outputSize, CV_16SC2,
+            maps.map1, maps.map2
+        );
+    }
+    
+    return maps;
+}
+
+UndistortionMaps buildRectificationMaps(const PerspectiveCamera& camera) {
+    UndistortionMaps maps;
+    maps.inputSize = camera.imageSize;
+    maps.outputSize = camera.rectifiedSize;
+    maps.newCameraMatrix = camera.projection(cv::Rect(0, 0, 3, 3)).clone();
+    
+    // P_rect_01's fourth column only carries the baseline; pixels map through its 3x3 part
+    cv::initUndistortRectifyMap(
+        camera.cameraMatrix, camera.distCoeffs, camera.rectification,
+        maps.newCameraMatrix, maps.outputSize, CV_16SC2,
+        maps.map1, maps.map2
+    );
+    
+    return maps;
+}
+
+const FisheyeCamera& CalibrationSnapshot::fisheye(const std::string& cameraName) const {
+    auto it = fisheyeCameras.find(cameraName);
+    if (it == fisheyeCameras.end()) {
+        throw std::runtime_error(cameraName + " calibration not found in " + directory);
+    }
+    return it->second;
+}
+
+const PerspectiveCamera& CalibrationSnapshot::perspective(const std::string& cameraName) const {
+    auto it = perspectiveCameras.find(cameraName);
+    if (it == perspectiveCameras.end()) {
+        throw std::runtime_error(cameraName + " calibration not found in " + directory);
+    }
+    return it->second;
+}
+
+CalibrationRegistry& CalibrationRegistry::instance() {
+    static CalibrationRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<const CalibrationSnapshot> CalibrationRegistry::load(const std::string& directory) {
+    if (!fs::is_directory(directory)) {
+        throw std::runtime_error(directory + " does not exist!");
+    }
+    std::string canonicalDirectory = fs::canonical(directory).string();
+    
+    // Read every calibration file once; the bytes are both hashed and parsed
+    std::vector<std::pair<std::string, std::string>> files;
+    for (const char* name : TEXT_CALIBRATION_FILES) {
+        fs::path path = fs::path(canonicalDirectory) / name;
+        if (fs::exists(path)) {
+            files.emplace_back(name, readFileContents(path.string()));
+        }
+    }
+    for (const auto& entry : fs::directory_iterator(canonicalDirectory)) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && name.rfind("image_", 0) == 0 && entry.path().extension() == ".yaml") {
+            files.emplace_back(name, readFileContents(entry.path().string()));
+        }
+    }
+    std::sort(files.begin(), files.end());
+    
+    uint64_t hash = 14695981039346656037ULL;
+    for (const auto& [name, contents] : files) {
+        hash = hashBytes(hash, name);
+        hash = hashBytes(hash, contents);
+    }
+    
+    auto key = std::make_pair(canonicalDirectory, hash);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = snapshots.find(key);
+        if (it != snapshots.end()) {
+            return it->second;
+        }
+    }
+    
+    // Parse outside the lock so other directories can load concurrently
+    auto snapshot = std::make_shared<CalibrationSnapshot>();
+    snapshot->directory = canonicalDirectory;
+    snapshot->contentHash = hash;
+    
+    for (const auto& [name, contents] : files) {
+        if (name == "calib_cam_to_pose.txt") {
+            snapshot->cameraToPose = loadCalibrationCameraToPose(ParsedCalibration::fromString(contents));
+        } else if (name == "perspective.txt") {
+            ParsedCalibration perspective = ParsedCalibration::fromString(contents);
+            snapshot->perspectiveIntrinsics = loadPerspectiveIntrinsic(perspective);
+            for (const char* cameraName : PERSPECTIVE_CAMERAS) {
+                if (perspective.contains("K_" + std::string(cameraName).substr(6))) {
+                    snapshot->perspectiveCameras[cameraName] = loadPerspectiveCamera(perspective, cameraName);
+                }
+            }
+        } else if (name == "calib_cam_to_velo.txt") {
+            snapshot->cameraToVelodyne = parseCalibrationRigid(contents);
+        } else if (name == "calib_sick_to_velo.txt") {
+            snapshot->sickToVelodyne = parseCalibrationRigid(contents);
+        } else {
+            FisheyeParams params = parseFisheyeParams(contents);
+            std::string cameraName = params.camera_name.empty() ? fs::path(name).stem().string() : params.camera_name;
+            snapshot->fisheyeCameras[cameraName] = makeFisheyeCamera(params);
+        }
+    }
+    
+    // A directory is only ever read at its latest revision; callers still holding
+    // an older snapshot or its maps keep them alive until they let go
+    std::lock_guard<std::mutex> lock(mutex);
+    eraseOtherRevisions(snapshots, canonicalDirectory, hash);
+    eraseOtherRevisions(maps, canonicalDirectory, hash);
+    eraseOtherRevisions(rectifications, canonicalDirectory, hash);
+    return snapshots.emplace(key, std::move(snapshot)).first->second;
+}
+
+// Concurrent requests for one key wait for the first caller's build; failed builds are not cached
+template <typename Key, typename Build>
+std::shared_ptr<const UndistortionMaps> CalibrationRegistry::buildOnce(
+    std::map<Key, SharedMaps>& cache, const Key& key, Build build) {
+    std::promise<std::shared_ptr<const UndistortionMaps>> promise;
+    SharedMaps future;
+    bool builder = false;
+    std::string cacheDirectory;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cacheDirectory = mapCacheDirectory;
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            future = it->second;
+        } else {
+            future = promise.get_future().share();
+            cache.emplace(key, future);
+            builder = true;
+        }
+    }
+    
+    if (builder) {
+        try {
+            promise.set_value(build(cacheDirectory));
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cache.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+        }
+    }
+    
+    return future.get();
+}
+
+std::shared_ptr<const UndistortionMaps> CalibrationRegistry::undistortionMaps(
+    const std::shared_ptr<const CalibrationSnapshot>& snapshot,
+    const std::string& cameraName,
+    const UnwrapSettings& settings) {
+    MapsKey key(snapshot->directory, snapshot->contentHash, cameraName, settings);
+    return buildOnce(maps, key, [&](const std::string& cacheDirectory) {
+        return buildOrMapUndistortionMaps(*snapshot, cameraName, settings, cacheDirectory);
+    });
+}
+
+std::shared_ptr<const UndistortionMaps> CalibrationRegistry::rectificationMaps(
+    const std::shared_ptr<const CalibrationSnapshot>& snapshot,
+    const std::string& cameraName) {
+    RectificationKey key(snapshot->directory, snapshot->contentHash, cameraName);
+    return buildOnce(rectifications, key, [&](const std::string& cacheDirectory) {
+        return buildOrMapRectificationMaps(*snapshot, cameraName, cacheDirectory);
+    });
+}
+
+std::shared_ptr<const UndistortionMaps> CalibrationRegistry::buildOrMapUndistortionMaps(
+    const CalibrationSnapshot& snapshot, const std::string& cameraName,
+    const UnwrapSettings& settings, const std::string& cacheDirectory) {
+    const FisheyeCamera& camera = snapshot.fisheye(cameraName);
+    std::string cachePath;
+    
+    if (!cacheDirectory.empty()) {
+        cachePath = (fs::path(cacheDirectory) / mapCacheFilename(cameraName, snapshot.contentHash, settings)).string();
+        if (fs::exists(cachePath)) {
+            try {
+                // The returned maps share ownership of the package, keeping the mapping alive
+                auto package = MapPackage::open(cachePath);
+                return std::shared_ptr<const UndistortionMaps>(package, &package->maps);
+            } catch (const std::exception& e) {
+                std::cerr << "Ignoring map cache entry: " << e.what() << std::endl;
+            }
+        }
+    }
+    
+    cv::Size inputSize(camera.params.image_width, camera.params.image_height);
+    auto maps = std::make_shared<const UndistortionMaps>(
+        buildUnwrapMaps(camera.cameraMatrix, camera.distCoeffs, inputSize, settings));
+    
+    if (!cachePath.empty()) {
+        try {
+            writeMapPackage(cachePath, cameraName, camera.cameraMatrix, camera.distCoeffs,
+                            settings, *maps, snapshot.contentHash);
+            removeOtherRevisionPackages(cachePath, cameraName);
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot write map cache entry: " << e.what() << std::endl;
+        }
+    }
+    
+    return maps;
+}
+
+std::shared_ptr<const UndistortionMaps> CalibrationRegistry::buildOrMapRectificationMaps(
+    const CalibrationSnapshot& snapshot, const std::string& cameraName,
+    const std::string& cacheDirectory) {
+    const PerspectiveCamera& camera = snapshot.perspective(cameraName);
+    std::string cachePath;
+    
+    if (!cacheDirectory.empty()) {
+        cachePath = (fs::path(cacheDirectory) / rectificationCacheFilename(cameraName, snapshot.contentHash)).string();
+        if (fs::exists(cachePath)) {
+            try {
+                auto package = MapPackage::open(cachePath);
+                return std::shared_ptr<const UndistortionMaps>(package, &package->maps);
+            } catch (const std::exception& e) {
+                std::cerr << "Ignoring map cache entry: " << e.what() << std::endl;
+            }
+        }
+    }
+    
+    auto maps = std::make_shared<const UndistortionMaps>(buildRectificationMaps(camera));
+    
+    if (!cachePath.empty()) {
+        try {
+            // Rectification has no unwrap settings; the package records zeros
+            writeMapPackage(cachePath, cameraName, camera.cameraMatrix, camera.distCoeffs,
+                            UnwrapSettings{0.0, 0.0, 0.0}, *maps, snapshot.contentHash);
+            removeOtherRevisionPackages(cachePath, cameraName);
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot write map cache entry: " << e.what() << std::endl;
+        }
+    }
+    
+    return maps;
+}
+
+void CalibrationRegistry::setMapCacheDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    mapCacheDirectory = directory;
+}
+
+std::shared_ptr<const UndistortionMaps> CalibrationRegistry::tunedMaps(
+    const std::shared_ptr<const CalibrationSnapshot>& snapshot,
+    const std::string& cameraName) {
+    std::string cacheDirectory;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cacheDirectory = mapCacheDirectory;
+    }
+    
+    std::string path = tunedMapPackagePath(cacheDirectory.empty() ? "." : cacheDirectory, cameraName);
+    if (!fs::exists(path)) {
+        return nullptr;
+    }
+    
+    try {
+        auto package = MapPackage::open(path);
+        // Tuning done against an older calibration is superseded by the edited calibration files
+        if (package->sourceHash != snapshot->contentHash) {
+            std::cerr << "Ignoring " << path << ": tuned against a different calibration" << std::endl;
+            return nullptr;
+        }
+        return std::shared_ptr<const UndistortionMaps>(package, &package->maps);
+    } catch (const std::exception& e) {
+        std::cerr << "Ignoring tuned maps: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+void CalibrationRegistry::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    snapshots.clear();
+    maps.clear();
+    rectifications.clear();
+}
+
+} // namespace kitti360
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "load_calibration.h"
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace kitti360 {
+
+/**
+ * @brief Fisheye camera with the OpenCV matrices derived from its calibration
+ */
+struct FisheyeCamera {
+    FisheyeParams params;
+    cv::Mat cameraMatrix;  // 3x3: gamma1 (fx), gamma2 (fy), u0 (cx), v0 (cy)
+    cv::Mat distCoeffs;    // 4x1: k1, k2, p1 -> k3, p2 -> k4 for cv::fisheye
+};
+
+/**
+ * @brief Build the OpenCV camera matrix and distortion coefficients
+ * @param params Fisheye parameters loaded from image_XX.yaml
+ * @return FisheyeCamera structure
+ */
+FisheyeCamera makeFisheyeCamera(const FisheyeParams& params);
+
+/**
+ * @brief Settings of the ultra-flat unwrapped projection
+ */
+struct UnwrapSettings {
+    double focalScale = 5.0;        // Focal length expansion (higher = flatter)
+    double widthMultiplier = 4.0;   // Output width relative to input width
+    double heightMultiplier = 2.0;  // Output height relative to input height
+
+    bool operator<(const UnwrapSettings& other) const {
+        return std::tie(focalScale, widthMultiplier, heightMultiplier) <
+               std::tie(other.focalScale, other.widthMultiplier, other.heightMultiplier);
+    }
+};
+
+/**
+ * @brief Fixed-point undistortion maps ready for cv::remap
+ */
+struct UndistortionMaps {
+    cv::Mat map1;             // CV_16SC2 integer source coordinates
+    cv::Mat map2;             // CV_16UC1 interpolation table indices
+    cv::Mat newCameraMatrix;  // Camera matrix of the unwrapped output
+    cv::Size inputSize;
+    cv::Size outputSize;
+};
+
+/**
+ * @brief Create unwrapped undistortion maps for a fisheye camera
+ *
+ * Uses the cv::fisheye model and falls back to the standard model if the
+ * fisheye map creation fails.
+ * @param cameraMatrix 3x3 camera matrix
+ * @param distCoeffs 4x1 distortion coefficients
+ * @param inputSize Size of the distorted input images
+ * @param settings Unwrapped projection settings
+ * @return UndistortionMaps structure
+ */
+UndistortionMaps buildUnwrapMaps(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs,
+                                 cv::Size inputSize, const UnwrapSettings& settings);
+
+/**
+ * @brief Create rectification maps for a perspective camera
+ *
+ * Undistorts the raw S_XX frame with K_XX and the 5-coefficient D_XX,
+ * rotates it by R_rect_XX and projects it with P_rect_XX into the S_rect_XX
+ * frame, so rows of image_00 and image_01 correspond.
+ * @param camera Perspective camera loaded from perspective.txt
+ * @return UndistortionMaps structure (newCameraMatrix is the 3x3 part of P_rect_XX)
+ */
+UndistortionMaps buildRectificationMaps(const PerspectiveCamera& camera);
+
+/**
+ * @brief Immutable calibration of one KITTI-360 calibration directory
+ */
+struct CalibrationSnapshot {
+    std::string directory;
+    uint64_t contentHash;  // Combined hash of every calibration file read
+
+    std::map<std::string, FisheyeCamera> fisheyeCameras;  // image_02, image_03
+    std::map<std::string, cv::Mat> cameraToPose;          // calib_cam_to_pose.txt
+    std::map<std::string, cv::Mat> perspectiveIntrinsics; // perspective.txt
+    std::map<std::string, PerspectiveCamera> perspectiveCameras; // image_00, image_01
+    cv::Mat cameraToVelodyne;                             // calib_cam_to_velo.txt
+    cv::Mat sickToVelodyne;                               // calib_sick_to_velo.txt
+
+    /**
+     * @brief Get a fisheye camera by name
+     * @throws std::runtime_error if the camera was not calibrated in this directory
+     */
+    const FisheyeCamera& fisheye(const std::string& cameraName) const;
+
+    /**
+     * @brief Get a perspective camera by name
+     * @throws std::runtime_error if the camera was not calibrated in this directory
+     */
+    const PerspectiveCamera& perspective(const std::string& cameraName) const;
+};
+
+/**
+ * @brief Thread-safe cache of calibration snapshots and undistortion maps
+ *
+ * Snapshots are keyed by directory and content hash, so every caller that
+ * loads an unchanged directory shares one parse, and every caller asking for
+ * the same camera and projection shares one set of maps. Maps requested
+ * concurrently are built once; other callers wait for the first build.
+ * Loading a changed directory drops the registry's references to the
+ * directory's older snapshot and maps, so hot reloads don't accumulate them.
+ */
+class CalibrationRegistry {
+public:
+    /**
+     * @brief Process-wide registry shared by viewers and batch workers
+     */
+    static CalibrationRegistry& instance();
+
+    /**
+     * @brief Load a calibration directory, reusing the cached snapshot if unchanged
+     *
+     * A changed directory replaces the cached snapshot and maps of its older
+     * revision; callers holding those keep them until they release them.
+     * @param directory Directory containing image_XX.yaml and calib_*.txt files
+     * @return Shared immutable snapshot
+     * @throws std::runtime_error if the directory doesn't exist
+     */
+    std::shared_ptr<const CalibrationSnapshot> load(const std::string& directory);
+
+    /**
+     * @brief Get the unwrapped undistortion maps of a fisheye camera
+     * @param snapshot Snapshot returned by load()
+     * @param cameraName Camera name (e.g., "image_02")
+     * @param settings Unwrapped projection settings
+     * @return Shared immutable maps
+     */
+    std::shared_ptr<const UndistortionMaps> undistortionMaps(
+        const std::shared_ptr<const CalibrationSnapshot>& snapshot,
+        const std::string& cameraName,
+        const UnwrapSettings& settings = UnwrapSettings());
+
+    /**
+     * @brief Get the rectification maps of a perspective camera
+     *
+     * Built once and cached on disk like the fisheye maps.
+     * @param snapshot Snapshot returned by load()
+     * @param cameraName Camera name (image_00 or image_01)
+     * @return Shared immutable maps
+     */
+    std::shared_ptr<const UndistortionMaps> rectificationMaps(
+        const std::shared_ptr<const CalibrationSnapshot>& snapshot,
+        const std::string& cameraName);
+
+    /**
+     * @brief Persist undistortion maps as memory-mapped packages in a directory
+     *
+     * Maps found in the directory are mapped instead of rebuilt, and newly
+     * built maps are written there, so later launches skip map creation.
+     * @param directory Map cache directory, empty to disable
+     */
+    void setMapCacheDirectory(const std::string& directory);
+
+    /**
+     * @brief Get maps exported after interactive tuning in single_undistort
+     * @param snapshot Snapshot returned by load()
+     * @param cameraName Camera name (e.g., "image_02")
+     * @return Tuned maps, or nullptr if none were exported for this calibration
+     */
+    std::shared_ptr<const UndistortionMaps> tunedMaps(
+        const std::shared_ptr<const CalibrationSnapshot>& snapshot,
+        const std::string& cameraName);
+
+    /**
+     * @brief Drop every cached snapshot and map
+     */
+    void clear();
+
+private:
+    using MapsKey = std::tuple<std::string, uint64_t, std::string, UnwrapSettings>;
+    using RectificationKey = std::tuple<std::string, uint64_t, std::string>;
+    using SharedMaps = std::shared_future<std::shared_ptr<const UndistortionMaps>>;
+
+    template <typename Key, typename Build>
+    std::shared_ptr<const UndistortionMaps> buildOnce(std::map<Key, SharedMaps>& cache, const Key& key, Build build);
+
+    std::shared_ptr<const UndistortionMaps> buildOrMapUndistortionMaps(
+        const CalibrationSnapshot& snapshot, const std::string& cameraName,
+        const UnwrapSettings& settings, const std::string& cacheDirectory);
+
+    std::shared_ptr<const UndistortionMaps> buildOrMapRectificationMaps(
+        const CalibrationSnapshot& snapshot, const std::string& cameraName,
+        const std::string& cacheDirectory);
+
+    std::mutex mutex;
+    std::string mapCacheDirectory;
+    std::map<std::pair<std::string, uint64_t>, std::shared_ptr<const CalibrationSnapshot>> snapshots;
+    std::map<MapsKey, SharedMaps> maps;
+    std::map<RectificationKey, SharedMaps> rectifications;
+};
+
+} // namespace kitti360
@@ -0,0 +1,116 @@
+#include "calibration_watcher.h"
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace kitti360 {
+
+namespace {
+
+// Quiet period before reporting a change, so multi-step saves report once
+const int DEBOUNCE_MS = 200;
+// Upper bound on how long stop() waits for the watcher thread to notice
+const int POLL_INTERVAL_MS = 100;
+
+} // namespace
+
+CalibrationWatcher::CalibrationWatcher() : inotifyFd(-1), running(false) {}
+
+CalibrationWatcher::~CalibrationWatcher() {
+    stop();
+}
+
+bool CalibrationWatcher::isCalibrationFile(const std::string& name) {
+    auto endsWith = [&name](const std::string& suffix) {
+        return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return (name.rfind("image_", 0) == 0 && endsWith(".yaml")) ||
+           (name.rfind("calib_", 0) == 0 && endsWith(".txt")) ||
+           name == "perspective.txt";
+}
+
+bool CalibrationWatcher::start(const std::string& watchDirectory, Callback onChange) {
+    stop();
+    
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        std::cerr << "Calibration watcher: inotify_init1 failed" << std::endl;
+        return false;
+    }
+    
+    // Watch the directory rather than the files: editors often save by renaming a new file over the old one
+    uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE;
+    if (inotify_add_watch(inotifyFd, watchDirectory.c_str(), mask) < 0) {
+        std::cerr << "Calibration watcher: cannot watch " << watchDirectory << std::endl;
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    
+    directory = watchDirectory;
+    callback = std::move(onChange);
+    running = true;
+    watcherThread = std::thread(&CalibrationWatcher::watchLoop, this);
+    return true;
+#else
+    (void)watchDirectory;
+    (void)onChange;
+    return false;
+#endif
+}
+
+void CalibrationWatcher::stop() {
+    running = false;
+    if (watcherThread.joinable()) {
+        watcherThread.join();
+    }
+    
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+#endif
+}
+
+void CalibrationWatcher::watchLoop() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+    bool pendingChange = false;
+    
+    while (running) {
+        pollfd pfd = {inotifyFd, POLLIN, 0};
+        int ready = poll(&pfd, 1, pendingChange ? DEBOUNCE_MS : POLL_INTERVAL_MS);
+        
+        if (ready == 0) {
+            // Timed out: report once the directory has been quiet for the debounce period
+            if (pendingChange) {
+                pendingChange = false;
+                callback();
+            }
+            continue;
+        }
+        if (ready < 0) {
+            continue;
+        }
+        
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length; ) {
+                auto* event = reinterpret_cast<struct inotify_event*>(p);
+                if (event->len > 0 && isCalibrationFile(event->name)) {
+                    pendingChange = true;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+#endif
+}
+
+} // namespace kitti360
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace kitti360 {
+
+/**
+ * @brief Watches a calibration directory for edited calibration files
+ *
+ * Uses inotify on Linux. Events are debounced so an editor's write, rename
+ * and chmod sequence triggers one callback, which runs on the watcher thread.
+ * On other platforms start() returns false and nothing is watched.
+ */
+class CalibrationWatcher {
+public:
+    using Callback = std::function<void()>;
+
+    CalibrationWatcher();
+    ~CalibrationWatcher();
+
+    CalibrationWatcher(const CalibrationWatcher&) = delete;
+    CalibrationWatcher& operator=(const CalibrationWatcher&) = delete;
+
+    /**
+     * @brief Start watching a directory
+     * @param directory Directory containing image_XX.yaml and calib_*.txt files
+     * @param onChange Called after calibration files changed and settled
+     * @return true if the watch was installed
+     */
+    bool start(const std::string& directory, Callback onChange);
+
+    /**
+     * @brief Stop watching and join the watcher thread
+     */
+    void stop();
+
+    /**
+     * @brief Check whether a file name is one of the watched calibration files
+     */
+    static bool isCalibrationFile(const std::string& name);
+
+private:
+    void watchLoop();
+
+    int inotifyFd;
+    std::string directory;
+    Callback callback;
+    std::thread watcherThread;
+    std::atomic<bool> running;
+};
+
+} // namespace kitti360
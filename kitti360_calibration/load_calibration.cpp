@@ -1,8 +1,10 @@
 #include "load_calibration.h"
 #include <fstream>
-#include <sstream>
 #include <stdexcept>
 #include <iostream>
+#include <charconv>
+#include <cstring>
+#include <iterator>
 
 namespace kitti360 {
 
@@ -14,148 +16,212 @@ void checkFile(const std::string& filename) {
     file.close();
 }
 
-cv::Mat readVariable(std::ifstream& file, const std::string& name, int rows, int cols) {
-    // Reset file to beginning
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    
-    std::string line;
-    bool found = false;
+std::string readFileContents(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error(filename + " does not exist!");
+    }
     
-    // Search for variable identifier
-    while (std::getline(file, line)) {
-        if (line.find(name + ":") == 0) {
-            found = true;
+    std::string contents(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+    return contents;
+}
+
+namespace {
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Parse whitespace separated numbers, stopping at the first non-numeric token
+void parseNumbers(const char* begin, const char* end, std::vector<double>& values) {
+    const char* p = begin;
+    while (p < end) {
+        while (p < end && isBlank(*p)) ++p;
+        if (p == end) break;
+        
+        double value;
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc() || (next < end && !isBlank(*next))) {
             break;
         }
-    }
-    
-    if (!found) {
-        return cv::Mat();
-    }
-    
-    // Remove variable name and colon
-    size_t colonPos = line.find(':');
-    if (colonPos != std::string::npos) {
-        line = line.substr(colonPos + 1);
-    }
-    
-    // Parse the values
-    std::stringstream ss(line);
-    std::vector<double> values;
-    double value;
-    
-    while (ss >> value) {
         values.push_back(value);
+        p = next;
     }
-    
-    if (values.size() != rows * cols) {
+}
+
+cv::Mat valuesToMat(const std::vector<double>& values, int rows, int cols) {
+    if (values.size() != static_cast<size_t>(rows * cols)) {
         throw std::runtime_error("Expected " + std::to_string(rows * cols) + 
                                 " values, got " + std::to_string(values.size()));
     }
     
-    // Create OpenCV matrix
     cv::Mat mat(rows, cols, CV_64F);
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            mat.at<double>(i, j) = values[i * cols + j];
+    std::copy(values.begin(), values.end(), mat.ptr<double>());
+    return mat;
+}
+
+// Embed a 3x4 matrix into a 4x4 homogeneous transformation matrix
+cv::Mat toHomogeneous(const cv::Mat& mat3x4) {
+    cv::Mat mat4x4 = cv::Mat::eye(4, 4, CV_64F);
+    mat3x4.copyTo(mat4x4(cv::Rect(0, 0, 4, 3)));
+    return mat4x4;
+}
+
+} // namespace
+
+ParsedCalibration ParsedCalibration::fromFile(const std::string& filename) {
+    return fromString(readFileContents(filename));
+}
+
+ParsedCalibration ParsedCalibration::fromString(std::string_view text) {
+    ParsedCalibration parsed;
+    
+    const char* p = text.data();
+    const char* end = p + text.size();
+    
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+        
+        // Variable lines look like "name: v0 v1 ...", the name starting at column 0
+        const char* colon = static_cast<const char*>(std::memchr(p, ':', lineEnd - p));
+        if (colon && colon > p) {
+            // Keep the first occurrence, matching the old top-down search
+            auto inserted = parsed.variables.try_emplace(std::string(p, colon));
+            if (inserted.second) {
+                parseNumbers(colon + 1, lineEnd, inserted.first->second);
+            }
         }
+        
+        p = lineEnd < end ? lineEnd + 1 : end;
     }
     
-    return mat;
+    return parsed;
 }
 
-std::map<std::string, cv::Mat> loadCalibrationCameraToPose(const std::string& filename) {
-    checkFile(filename);
+bool ParsedCalibration::contains(const std::string& name) const {
+    return variables.find(name) != variables.end();
+}
+
+const std::vector<double>* ParsedCalibration::values(const std::string& name) const {
+    auto it = variables.find(name);
+    return it != variables.end() ? &it->second : nullptr;
+}
+
+cv::Mat ParsedCalibration::matrix(const std::string& name, int rows, int cols) const {
+    const std::vector<double>* found = values(name);
+    if (!found) {
+        return cv::Mat();
+    }
+    return valuesToMat(*found, rows, cols);
+}
+
+cv::Mat readVariable(std::ifstream& file, const std::string& name, int rows, int cols) {
+    // Reset file to beginning
+    file.clear();
+    file.seekg(0, std::ios::beg);
     
-    std::ifstream file(filename);
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return ParsedCalibration::fromString(contents).matrix(name, rows, cols);
+}
+
+std::map<std::string, cv::Mat> loadCalibrationCameraToPose(const ParsedCalibration& calibration) {
     std::map<std::string, cv::Mat> transforms;
     
     std::vector<std::string> cameras = {"image_00", "image_01", "image_02", "image_03"};
     
     for (const auto& camera : cameras) {
-        cv::Mat transform3x4 = readVariable(file, camera, 3, 4);
+        cv::Mat transform3x4 = calibration.matrix(camera, 3, 4);
         if (!transform3x4.empty()) {
-            // Create 4x4 homogeneous transformation matrix
-            cv::Mat transform4x4 = cv::Mat::eye(4, 4, CV_64F);
-            transform3x4.copyTo(transform4x4(cv::Rect(0, 0, 4, 3)));
-            transforms[camera] = transform4x4;
+            transforms[camera] = toHomogeneous(transform3x4);
         }
     }
     
-    file.close();
     return transforms;
 }
 
-cv::Mat loadCalibrationRigid(const std::string& filename) {
+std::map<std::string, cv::Mat> loadCalibrationCameraToPose(const std::string& filename) {
     checkFile(filename);
-    
-    // Read the 12 values from the file
-    std::ifstream file(filename);
+    return loadCalibrationCameraToPose(ParsedCalibration::fromFile(filename));
+}
+
+cv::Mat parseCalibrationRigid(std::string_view text) {
+    // Read the 12 values from the file contents
     std::vector<double> values;
-    double value;
-    
-    while (file >> value) {
-        values.push_back(value);
-    }
-    file.close();
+    parseNumbers(text.data(), text.data() + text.size(), values);
     
     if (values.size() != 12) {
         throw std::runtime_error("Expected 12 values for rigid transformation, got " + 
                                 std::to_string(values.size()));
     }
     
-    // Create 4x4 homogeneous transformation matrix
-    cv::Mat transform = cv::Mat::eye(4, 4, CV_64F);
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            transform.at<double>(i, j) = values[i * 4 + j];
-        }
-    }
-    
-    return transform;
+    return toHomogeneous(valuesToMat(values, 3, 4));
 }
 
-std::map<std::string, cv::Mat> loadPerspectiveIntrinsic(const std::string& filename) {
+cv::Mat loadCalibrationRigid(const std::string& filename) {
     checkFile(filename);
-    
-    std::ifstream file(filename);
+    return parseCalibrationRigid(readFileContents(filename));
+}
+
+std::map<std::string, cv::Mat> loadPerspectiveIntrinsic(const ParsedCalibration& calibration) {
     std::map<std::string, cv::Mat> intrinsics;
     
     std::vector<std::string> params = {"P_rect_00", "R_rect_00", "P_rect_01", "R_rect_01"};
     
     for (const auto& param : params) {
-        cv::Mat mat;
         if (param.find("P_rect") == 0) {
-            // Projection matrix is 3x4
-            mat = readVariable(file, param, 3, 4);
+            // Projection matrix is 3x4, stored as 4x4 homogeneous matrix
+            cv::Mat mat = calibration.matrix(param, 3, 4);
             if (!mat.empty()) {
-                // Convert to 4x4 homogeneous matrix
-                cv::Mat mat4x4 = cv::Mat::eye(4, 4, CV_64F);
-                mat.copyTo(mat4x4(cv::Rect(0, 0, 4, 3)));
-                intrinsics[param] = mat4x4;
+                intrinsics[param] = toHomogeneous(mat);
             }
         } else {
             // Rectification matrix is 3x3
-            mat = readVariable(file, param, 3, 3);
+            cv::Mat mat = calibration.matrix(param, 3, 3);
             if (!mat.empty()) {
                 intrinsics[param] = mat;
             }
         }
     }
     
-    file.close();
     return intrinsics;
 }
 
-FisheyeParams loadFisheyeParams(const std::string& filename) {
+std::map<std::string, cv::Mat> loadPerspectiveIntrinsic(const std::string& filename) {
     checkFile(filename);
+    return loadPerspectiveIntrinsic(ParsedCalibration::fromFile(filename));
+}
+
+PerspectiveCamera loadPerspectiveCamera(const ParsedCalibration& calibration, const std::string& cameraName) {
+    // perspective.txt suffixes every variable with the camera index (00, 01)
+    std::string index = cameraName.size() >= 2 ? cameraName.substr(cameraName.size() - 2) : cameraName;
+    auto require = [&](const std::string& name, int rows, int cols) {
+        cv::Mat mat = calibration.matrix(name + "_" + index, rows, cols);
+        if (mat.empty()) {
+            throw std::runtime_error(name + "_" + index + " not found for " + cameraName);
+        }
+        return mat;
+    };
+    auto size = [](const cv::Mat& mat) {
+        return cv::Size(static_cast<int>(mat.at<double>(0)), static_cast<int>(mat.at<double>(1)));
+    };
     
-    cv::FileStorage fs(filename, cv::FileStorage::READ);
-    if (!fs.isOpened()) {
-        throw std::runtime_error("Cannot open YAML file: " + filename);
-    }
-    
+    PerspectiveCamera camera;
+    camera.camera_name = cameraName;
+    camera.cameraMatrix = require("K", 3, 3);
+    camera.distCoeffs = require("D", 1, 5);
+    camera.rectification = require("R_rect", 3, 3);
+    camera.projection = require("P_rect", 3, 4);
+    camera.imageSize = size(require("S", 1, 2));
+    camera.rectifiedSize = size(require("S_rect", 1, 2));
+    return camera;
+}
+
+namespace {
+
+FisheyeParams readFisheyeParams(const cv::FileStorage& fs) {
     FisheyeParams params;
     
     fs["camera_name"] >> params.camera_name;
@@ -181,6 +247,31 @@ FisheyeParams loadFisheyeParams(const std::string& filename) {
     fs["projection_parameters"]["v0"] >> v0;
     params.projection = cv::Vec4d(gamma1, gamma2, u0, v0);
     
+    return params;
+}
+
+} // namespace
+
+FisheyeParams loadFisheyeParams(const std::string& filename) {
+    checkFile(filename);
+    
+    cv::FileStorage fs(filename, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        throw std::runtime_error("Cannot open YAML file: " + filename);
+    }
+    
+    FisheyeParams params = readFisheyeParams(fs);
+    fs.release();
+    return params;
+}
+
+FisheyeParams parseFisheyeParams(const std::string& yaml) {
+    cv::FileStorage fs(yaml, cv::FileStorage::READ | cv::FileStorage::MEMORY);
+    if (!fs.isOpened()) {
+        throw std::runtime_error("Cannot parse fisheye YAML contents");
+    }
+    
+    FisheyeParams params = readFisheyeParams(fs);
     fs.release();
     return params;
 }
@@ -2,7 +2,9 @@
 
 #include <opencv2/opencv.hpp>
 #include <string>
+#include <string_view>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace kitti360 {
@@ -14,8 +16,71 @@ namespace kitti360 {
  */
 void checkFile(const std::string& filename);
 
+/**
+ * @brief Read a whole file with one sequential read
+ * @param filename Path to the file to read
+ * @return File contents
+ * @throws std::runtime_error if file doesn't exist
+ */
+std::string readFileContents(const std::string& filename);
+
+/**
+ * @brief Calibration text file tokenised in a single pass
+ *
+ * Every "name: v0 v1 ..." line is parsed once into a name -> values table,
+ * so several variables can be looked up without rescanning the file.
+ * Values are parsed up to the first non-numeric token of a line.
+ */
+class ParsedCalibration {
+public:
+    /**
+     * @brief Read and tokenise a calibration file
+     * @param filename Path to the calibration file
+     * @throws std::runtime_error if the file doesn't exist
+     */
+    static ParsedCalibration fromFile(const std::string& filename);
+
+    /**
+     * @brief Tokenise calibration text already held in memory
+     * @param text Contents of a calibration file
+     */
+    static ParsedCalibration fromString(std::string_view text);
+
+    /**
+     * @brief Check whether a variable was present in the file
+     */
+    bool contains(const std::string& name) const;
+
+    /**
+     * @brief Get the raw values of a variable
+     * @return Pointer to the parsed values, or nullptr if not found
+     */
+    const std::vector<double>* values(const std::string& name) const;
+
+    /**
+     * @brief Get a variable as a matrix
+     * @param name Variable name
+     * @param rows Number of rows in the matrix
+     * @param cols Number of columns in the matrix
+     * @return OpenCV matrix containing the data, or empty matrix if not found
+     * @throws std::runtime_error if the value count doesn't match rows * cols
+     */
+    cv::Mat matrix(const std::string& name, int rows, int cols) const;
+
+    /**
+     * @brief Number of variables in the file
+     */
+    size_t size() const { return variables.size(); }
+
+private:
+    std::unordered_map<std::string, std::vector<double>> variables;
+};
+
 /**
  * @brief Read a variable from calibration file
+ *
+ * Tokenises the whole stream on every call; use ParsedCalibration when
+ * reading more than one variable from the same file.
  * @param file Input file stream
  * @param name Variable name to search for
  * @param rows Number of rows in the matrix
@@ -31,6 +96,13 @@ cv::Mat readVariable(std::ifstream& file, const std::string& name, int rows, int
  */
 std::map<std::string, cv::Mat> loadCalibrationCameraToPose(const std::string& filename);
 
+/**
+ * @brief Load camera to pose transformation matrices from an already parsed file
+ * @param calibration Parsed contents of calib_cam_to_pose.txt
+ * @return Map of camera names to 4x4 transformation matrices
+ */
+std::map<std::string, cv::Mat> loadCalibrationCameraToPose(const ParsedCalibration& calibration);
+
 /**
  * @brief Load rigid body transformation matrix
  * @param filename Path to calibration file (e.g., calib_cam_to_velo.txt)
@@ -38,6 +110,13 @@ std::map<std::string, cv::Mat> loadCalibrationCameraToPose(const std::string& fi
  */
 cv::Mat loadCalibrationRigid(const std::string& filename);
 
+/**
+ * @brief Parse rigid body transformation matrix from file contents
+ * @param text Contents of a rigid calibration file (12 values)
+ * @return 4x4 transformation matrix
+ */
+cv::Mat parseCalibrationRigid(std::string_view text);
+
 /**
  * @brief Load perspective camera intrinsic parameters
  * @param filename Path to perspective.txt
@@ -45,6 +124,35 @@ cv::Mat loadCalibrationRigid(const std::string& filename);
  */
 std::map<std::string, cv::Mat> loadPerspectiveIntrinsic(const std::string& filename);
 
+/**
+ * @brief Load perspective camera intrinsic parameters from an already parsed file
+ * @param calibration Parsed contents of perspective.txt
+ * @return Map of parameter names to matrices (P_rect_XX, R_rect_XX)
+ */
+std::map<std::string, cv::Mat> loadPerspectiveIntrinsic(const ParsedCalibration& calibration);
+
+/**
+ * @brief Raw and rectified calibration of a perspective camera
+ */
+struct PerspectiveCamera {
+    std::string camera_name;
+    cv::Mat cameraMatrix;    // K_XX: 3x3 matrix of the raw camera
+    cv::Mat distCoeffs;      // D_XX: 1x5 k1, k2, p1, p2, k3
+    cv::Mat rectification;   // R_rect_XX: 3x3 rotation onto the common rectified plane
+    cv::Mat projection;      // P_rect_XX: 3x4 projection of the rectified camera
+    cv::Size imageSize;      // S_XX: raw image size
+    cv::Size rectifiedSize;  // S_rect_XX: rectified image size
+};
+
+/**
+ * @brief Load the calibration of one perspective camera from an already parsed file
+ * @param calibration Parsed contents of perspective.txt
+ * @param cameraName Camera name (image_00 or image_01)
+ * @return PerspectiveCamera structure
+ * @throws std::runtime_error if a parameter of the camera is missing
+ */
+PerspectiveCamera loadPerspectiveCamera(const ParsedCalibration& calibration, const std::string& cameraName);
+
 /**
  * @brief Structure to hold fisheye camera parameters
  */
@@ -64,4 +172,11 @@ struct FisheyeParams {
  */
 FisheyeParams loadFisheyeParams(const std::string& filename);
 
+/**
+ * @brief Parse fisheye camera parameters from YAML contents held in memory
+ * @param yaml Contents of an image_XX.yaml file
+ * @return FisheyeParams structure
+ */
+FisheyeParams parseFisheyeParams(const std::string& yaml);
+
 } // namespace kitti360
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "map_cache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace kitti360 {
+
+namespace {
+
+const char MAP_PACKAGE_MAGIC[8] = {'K', '3', '6', '0', 'M', 'A', 'P', '\0'};
+const size_t MAP_DATA_ALIGNMENT = 4096;
+
+struct MapPackageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    char cameraName[32];
+    uint64_t sourceHash;
+    int32_t inputWidth, inputHeight;
+    int32_t outputWidth, outputHeight;
+    double focalScale, widthMultiplier, heightMultiplier;
+    double cameraMatrix[9];
+    double distCoeffs[5];        // 4 fisheye or 5 perspective coefficients
+    double newCameraMatrix[9];
+    int32_t distCoeffCount;
+    int32_t map1Type, map2Type;
+    uint64_t map1Offset, map1Bytes;
+    uint64_t map2Offset, map2Bytes;
+};
+static_assert(std::is_trivially_copyable<MapPackageHeader>::value, "header is written verbatim");
+
+size_t alignUp(size_t value) {
+    return (value + MAP_DATA_ALIGNMENT - 1) / MAP_DATA_ALIGNMENT * MAP_DATA_ALIGNMENT;
+}
+
+void copyMatrix(const cv::Mat& mat, double* out, int count) {
+    cv::Mat values;
+    mat.convertTo(values, CV_64F);
+    if (static_cast<int>(values.total()) != count) {
+        throw std::runtime_error("Expected " + std::to_string(count) + " calibration values, got " +
+                                 std::to_string(values.total()));
+    }
+    values = values.reshape(1, 1).clone();
+    std::memcpy(out, values.ptr<double>(), count * sizeof(double));
+}
+
+void writeMat(std::ofstream& file, const cv::Mat& mat) {
+    size_t rowBytes = mat.cols * mat.elemSize();
+    for (int row = 0; row < mat.rows; ++row) {
+        file.write(reinterpret_cast<const char*>(mat.ptr(row)), static_cast<std::streamsize>(rowBytes));
+    }
+}
+
+void pad(std::ofstream& file, size_t target) {
+    static const char zeros[MAP_DATA_ALIGNMENT] = {};
+    size_t position = static_cast<size_t>(file.tellp());
+    if (target > position) {
+        file.write(zeros, static_cast<std::streamsize>(target - position));
+    }
+}
+
+} // namespace
+
+MapPackage::MapPackage() : sourceHash(0), mapping(nullptr), mappingSize(0) {}
+
+MapPackage::~MapPackage() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+}
+
+std::shared_ptr<const MapPackage> MapPackage::open(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error(filename + " does not exist!");
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(MapPackageHeader)) {
+        ::close(fd);
+        throw std::runtime_error(filename + " is not a map package");
+    }
+    
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + filename);
+    }
+    
+#ifdef MADV_HUGEPAGE
+    // Lets kernels with read-only file THP back the maps with 2 MB pages; harmless elsewhere
+    madvise(mapping, size, MADV_HUGEPAGE);
+#endif
+    
+    // Owns the mapping from here on, including when validation throws
+    std::shared_ptr<MapPackage> package(new MapPackage());
+    package->mapping = mapping;
+    package->mappingSize = size;
+    
+    MapPackageHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, MAP_PACKAGE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(filename + " is not a map package");
+    }
+    if (header.version != MAP_PACKAGE_VERSION || header.headerSize != sizeof(MapPackageHeader)) {
+        throw std::runtime_error(filename + " has map package version " + std::to_string(header.version) +
+                                 ", expected " + std::to_string(MAP_PACKAGE_VERSION));
+    }
+    
+    cv::Size outputSize(header.outputWidth, header.outputHeight);
+    auto mapView = [&](uint64_t offset, uint64_t bytes, int type) {
+        if (offset + bytes > size) {
+            throw std::runtime_error(filename + " is truncated");
+        }
+        unsigned char* data = static_cast<unsigned char*>(mapping) + offset;
+        cv::Mat view(outputSize, type, data);
+        if (view.total() * view.elemSize() != bytes) {
+            throw std::runtime_error(filename + " has inconsistent map sizes");
+        }
+        return view;
+    };
+    
+    package->maps.map1 = mapView(header.map1Offset, header.map1Bytes, header.map1Type);
+    package->maps.map2 = mapView(header.map2Offset, header.map2Bytes, header.map2Type);
+    package->maps.inputSize = cv::Size(header.inputWidth, header.inputHeight);
+    package->maps.outputSize = outputSize;
+    package->maps.newCameraMatrix = cv::Mat(3, 3, CV_64F, header.newCameraMatrix).clone();
+    
+    header.cameraName[sizeof(header.cameraName) - 1] = '\0';
+    package->cameraName = header.cameraName;
+    package->sourceHash = header.sourceHash;
+    package->settings.focalScale = header.focalScale;
+    package->settings.widthMultiplier = header.widthMultiplier;
+    package->settings.heightMultiplier = header.heightMultiplier;
+    package->cameraMatrix = cv::Mat(3, 3, CV_64F, header.cameraMatrix).clone();
+    if (header.distCoeffCount < 0 || header.distCoeffCount > 5) {
+        throw std::runtime_error(filename + " has an invalid distortion model");
+    }
+    package->distCoeffs = cv::Mat(header.distCoeffCount, 1, CV_64F, header.distCoeffs).clone();
+    
+    return package;
+}
+
+void writeMapPackage(const std::string& filename, const std::string& cameraName,
+                     const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs,
+                     const UnwrapSettings& settings, const UndistortionMaps& maps,
+                     uint64_t sourceHash) {
+    MapPackageHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAP_PACKAGE_MAGIC, sizeof(header.magic));
+    header.version = MAP_PACKAGE_VERSION;
+    header.headerSize = sizeof(MapPackageHeader);
+    std::strncpy(header.cameraName, cameraName.c_str(), sizeof(header.cameraName) - 1);
+    header.sourceHash = sourceHash;
+    header.inputWidth = maps.inputSize.width;
+    header.inputHeight = maps.inputSize.height;
+    header.outputWidth = maps.outputSize.width;
+    header.outputHeight = maps.outputSize.height;
+    header.focalScale = settings.focalScale;
+    header.widthMultiplier = settings.widthMultiplier;
+    header.heightMultiplier = settings.heightMultiplier;
+    copyMatrix(cameraMatrix, header.cameraMatrix, 9);
+    header.distCoeffCount = static_cast<int32_t>(distCoeffs.total());
+    if (header.distCoeffCount > 5) {
+        throw std::runtime_error("At most 5 distortion coefficients fit a map package, got " +
+                                 std::to_string(header.distCoeffCount));
+    }
+    copyMatrix(distCoeffs, header.distCoeffs, header.distCoeffCount);
+    copyMatrix(maps.newCameraMatrix, header.newCameraMatrix, 9);
+    header.map1Type = maps.map1.type();
+    header.map2Type = maps.map2.type();
+    header.map1Bytes = maps.map1.total() * maps.map1.elemSize();
+    header.map2Bytes = maps.map2.total() * maps.map2.elemSize();
+    
+    // Page-align each map so the mapped matrices start on page boundaries
+    header.map1Offset = alignUp(sizeof(MapPackageHeader));
+    header.map2Offset = alignUp(header.map1Offset + header.map1Bytes);
+    
+    fs::path destination(filename);
+    if (destination.has_parent_path()) {
+        fs::create_directories(destination.parent_path());
+    }
+    std::string temporary = filename + ".tmp" + std::to_string(getpid());
+    
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot write " + temporary);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad(file, header.map1Offset);
+        writeMat(file, maps.map1);
+        pad(file, header.map2Offset);
+        writeMat(file, maps.map2);
+        if (!file) {
+            fs::remove(temporary);
+            throw std::runtime_error("Failed writing " + temporary);
+        }
+    }
+    
+    fs::rename(temporary, destination);
+}
+
+std::string tunedMapPackagePath(const std::string& cacheDirectory, const std::string& cameraName) {
+    return (fs::path(cacheDirectory) / (cameraName + "_tuned.k360map")).string();
+}
+
+} // namespace kitti360
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "calibration_registry.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace kitti360 {
+
+/**
+ * @brief Version of the on-disk map package format
+ *
+ * Bump whenever MapPackageHeader or the data layout changes; packages with
+ * another version are rejected and rebuilt.
+ */
+const uint32_t MAP_PACKAGE_VERSION = 2;
+
+/**
+ * @brief Undistortion maps memory-mapped from a .k360map package
+ *
+ * A package holds the calibration used to build the maps, the unwrap
+ * settings (zero for perspective rectification maps) and the fixed-point
+ * CV_16SC2 / CV_16UC1 maps, page aligned so they can be mapped read-only
+ * and shared through the page cache between every tool using them. The map matrices point into the mapping and stay
+ * valid for the lifetime of the package.
+ */
+class MapPackage {
+public:
+    std::string cameraName;
+    uint64_t sourceHash;     // Content hash of the calibration the maps were derived from
+    UnwrapSettings settings;
+    cv::Mat cameraMatrix;    // 3x3 calibration used to build the maps
+    cv::Mat distCoeffs;      // 4x1 fisheye or 5x1 perspective distortion used to build the maps
+    UndistortionMaps maps;   // map1/map2 are read-only views into the file
+
+    MapPackage(const MapPackage&) = delete;
+    MapPackage& operator=(const MapPackage&) = delete;
+    ~MapPackage();
+
+    /**
+     * @brief Memory-map a package
+     * @param filename Path to a .k360map file
+     * @return Shared package
+     * @throws std::runtime_error if the file is missing, truncated or of another version
+     */
+    static std::shared_ptr<const MapPackage> open(const std::string& filename);
+
+private:
+    MapPackage();
+
+    void* mapping;
+    size_t mappingSize;
+};
+
+/**
+ * @brief Write undistortion maps and the calibration behind them to a package
+ *
+ * The file is written next to its destination and renamed into place, so
+ * readers never map a partially written package.
+ * @param filename Destination .k360map path (parent directories are created)
+ * @param cameraName Camera name (e.g., "image_02")
+ * @param cameraMatrix 3x3 camera matrix the maps were built from
+ * @param distCoeffs Distortion coefficients the maps were built from (at most 5)
+ * @param settings Unwrap settings the maps were built with
+ * @param maps Fixed-point maps (CV_16SC2 map1, CV_16UC1 map2)
+ * @param sourceHash Content hash of the source calibration, 0 if unknown
+ * @throws std::runtime_error if the file cannot be written or has more than 5 coefficients
+ */
+void writeMapPackage(const std::string& filename, const std::string& cameraName,
+                     const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs,
+                     const UnwrapSettings& settings, const UndistortionMaps& maps,
+                     uint64_t sourceHash);
+
+/**
+ * @brief Path of the package holding interactively tuned maps for a camera
+ * @param cacheDirectory Map cache directory
+ * @param cameraName Camera name (e.g., "image_02")
+ */
+std::string tunedMapPackagePath(const std::string& cacheDirectory, const std::string& cameraName);
+
+} // namespace kitti360
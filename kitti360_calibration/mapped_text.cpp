@@ -0,0 +1,37 @@
+#include "mapped_text.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace kitti360 {
+
+MappedText::MappedText(const std::string& filename, const std::string& description) : data(nullptr), size(0) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + description + ": " + filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + description + ": " + filename);
+    }
+    size = static_cast<size_t>(info.st_size);
+    if (size > 0) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + description + ": " + filename);
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+}
+
+MappedText::~MappedText() {
+    if (data) munmap(const_cast<char*>(data), size);
+}
+
+} // namespace kitti360
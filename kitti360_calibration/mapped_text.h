@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace kitti360 {
+
+/**
+ * @brief Read-only mapping of a whole text file, unmapped on destruction
+ *
+ * Used to parse large dataset files (poses, annotations) in place without
+ * copying them through stdio.
+ */
+class MappedText {
+public:
+    /**
+     * @brief Map a file, advised for sequential reading
+     * @param filename Path to the file
+     * @param description What the file is, for error messages (e.g., "pose file")
+     * @throws std::runtime_error if the file cannot be opened or mapped
+     */
+    MappedText(const std::string& filename, const std::string& description);
+    ~MappedText();
+
+    MappedText(const MappedText&) = delete;
+    MappedText& operator=(const MappedText&) = delete;
+
+    std::string_view text() const { return std::string_view(data ? data : "", size); }
+
+private:
+    const char* data;
+    size_t size;
+};
+
+} // namespace kitti360
@@ -0,0 +1,309 @@
+#include "poses.h"
+#include "mapped_text.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace kitti360 {
+
+namespace {
+
+// Cells hold a few dozen poses of a drive at KITTI-360's pose spacing
+const double GRID_CELL_METERS = 20.0;
+const int MAX_GRID_CELLS_PER_AXIS = 4096;
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p;
+}
+
+// Perpendicular distance of p from the segment a-b on the ground plane
+double segmentDistance(const cv::Vec3d& p, const cv::Vec3d& a, const cv::Vec3d& b) {
+    double dx = b[0] - a[0], dy = b[1] - a[1];
+    double lengthSquared = dx * dx + dy * dy;
+    double t = lengthSquared > 0.0 ? ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / lengthSquared : 0.0;
+    t = std::clamp(t, 0.0, 1.0);
+    return std::hypot(p[0] - (a[0] + t * dx), p[1] - (a[1] + t * dy));
+}
+
+} // namespace
+
+PoseTrack PoseTrack::load(const std::string& filename) {
+    MappedText mapped(filename, "pose file");
+    try {
+        return parse(mapped.text());
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
+
+PoseTrack PoseTrack::parse(std::string_view text) {
+    PoseTrack track;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    size_t expectedLines = static_cast<size_t>(std::count(p, end, '\n')) + 1;
+    track.frames.reserve(expectedLines);
+    track.poses.reserve(expectedLines);
+    
+    int valueCount = 0; // 12 or 16, decided by the first line
+    size_t line = 0;
+    double values[16];
+    while (p < end) {
+        ++line;
+        const char* lineEnd = std::find(p, end, '\n');
+        const char* q = skipSpaces(p, lineEnd);
+        if (q == lineEnd) {
+            p = lineEnd + 1;
+            continue;
+        }
+        
+        uint32_t frameNumber;
+        auto parsed = std::from_chars(q, lineEnd, frameNumber);
+        if (parsed.ec != std::errc()) {
+            throw std::runtime_error("Malformed frame number on line " + std::to_string(line));
+        }
+        q = parsed.ptr;
+        
+        int count = 0;
+        while (true) {
+            q = skipSpaces(q, lineEnd);
+            if (q == lineEnd) break;
+            if (count == 16) {
+                throw std::runtime_error("Too many values on line " + std::to_string(line));
+            }
+            auto value = std::from_chars(q, lineEnd, values[count]);
+            if (value.ec != std::errc()) {
+                throw std::runtime_error("Malformed value on line " + std::to_string(line));
+            }
+            q = value.ptr;
+            ++count;
+        }
+        
+        if (valueCount == 0) {
+            if (count != 12 && count != 16) {
+                throw std::runtime_error("Expected 12 or 16 pose values on line " + std::to_string(line));
+            }
+            valueCount = count;
+            track.poseSource = count == 12 ? PoseSource::Vehicle : PoseSource::Camera0;
+        } else if (count != valueCount) {
+            throw std::runtime_error("Expected " + std::to_string(valueCount) + " pose values on line " +
+                                     std::to_string(line));
+        }
+        if (!track.frames.empty() && frameNumber <= track.frames.back()) {
+            throw std::runtime_error("Frame numbers are not ascending on line " + std::to_string(line));
+        }
+        
+        cv::Matx44d pose = cv::Matx44d::eye();
+        for (int i = 0; i < valueCount; ++i) {
+            pose(i / 4, i % 4) = values[i];
+        }
+        track.frames.push_back(frameNumber);
+        track.poses.push_back(pose);
+        p = lineEnd + 1;
+    }
+    
+    track.positions.reserve(track.poses.size());
+    track.distances.reserve(track.poses.size());
+    for (const cv::Matx44d& pose : track.poses) {
+        cv::Vec3d position(pose(0, 3), pose(1, 3), pose(2, 3));
+        double step = track.positions.empty() ? 0.0 : cv::norm(position - track.positions.back());
+        track.distances.push_back(track.distances.empty() ? 0.0 : track.distances.back() + step);
+        track.positions.push_back(position);
+    }
+    track.buildSpatialIndex();
+    return track;
+}
+
+void PoseTrack::buildSpatialIndex() {
+    if (positions.empty()) return;
+    
+    double minX = positions[0][0], maxX = minX;
+    double minY = positions[0][1], maxY = minY;
+    for (const cv::Vec3d& position : positions) {
+        minX = std::min(minX, position[0]);
+        maxX = std::max(maxX, position[0]);
+        minY = std::min(minY, position[1]);
+        maxY = std::max(maxY, position[1]);
+    }
+    groundBounds = cv::Rect2d(minX, minY, maxX - minX, maxY - minY);
+    
+    // Coarser cells for continent-sized tracks keep the offsets array small
+    cellSize = std::max({GRID_CELL_METERS, groundBounds.width / MAX_GRID_CELLS_PER_AXIS,
+                         groundBounds.height / MAX_GRID_CELLS_PER_AXIS});
+    gridColumns = static_cast<int>(groundBounds.width / cellSize) + 1;
+    gridRows = static_cast<int>(groundBounds.height / cellSize) + 1;
+    
+    // Counting sort of the poses by cell
+    auto cellOf = [&](const cv::Vec3d& position) {
+        int column = std::min(static_cast<int>((position[0] - minX) / cellSize), gridColumns - 1);
+        int row = std::min(static_cast<int>((position[1] - minY) / cellSize), gridRows - 1);
+        return static_cast<size_t>(row) * gridColumns + column;
+    };
+    cellStart.assign(static_cast<size_t>(gridColumns) * gridRows + 1, 0);
+    for (const cv::Vec3d& position : positions) {
+        ++cellStart[cellOf(position) + 1];
+    }
+    for (size_t cell = 1; cell < cellStart.size(); ++cell) {
+        cellStart[cell] += cellStart[cell - 1];
+    }
+    cellPoses.resize(positions.size());
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t index = 0; index < positions.size(); ++index) {
+        cellPoses[fill[cellOf(positions[index])]++] = static_cast<uint32_t>(index);
+    }
+}
+
+long PoseTrack::indexAtOrBefore(uint32_t frameNumber) const {
+    auto after = std::upper_bound(frames.begin(), frames.end(), frameNumber);
+    return static_cast<long>(after - frames.begin()) - 1;
+}
+
+size_t PoseTrack::nearest(double x, double y) const {
+    if (positions.empty()) return 0;
+    
+    // Rings of cells around the query's (clamped) cell; poses beyond ring r are more
+    // than r cells away, so the search ends once the best match is closer than that
+    int column = std::clamp(static_cast<int>(std::floor((x - groundBounds.x) / cellSize)), 0, gridColumns - 1);
+    int row = std::clamp(static_cast<int>(std::floor((y - groundBounds.y) / cellSize)), 0, gridRows - 1);
+    size_t best = 0;
+    double bestDistance = std::numeric_limits<double>::max();
+    int maxRing = std::max({column, gridColumns - 1 - column, row, gridRows - 1 - row});
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        for (int r = row - ring; r <= row + ring; ++r) {
+            if (r < 0 || r >= gridRows) continue;
+            bool edgeRow = r == row - ring || r == row + ring;
+            for (int c = column - ring; c <= column + ring; c += edgeRow ? 1 : 2 * ring) {
+                if (c >= 0 && c < gridColumns) {
+                    size_t cell = static_cast<size_t>(r) * gridColumns + c;
+                    for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                        const cv::Vec3d& position = positions[cellPoses[i]];
+                        double distance = std::hypot(position[0] - x, position[1] - y);
+                        if (distance < bestDistance || (distance == bestDistance && cellPoses[i] < best)) {
+                            bestDistance = distance;
+                            best = cellPoses[i];
+                        }
+                    }
+                }
+                if (ring == 0) break;
+            }
+        }
+        if (bestDistance <= ring * cellSize) break;
+    }
+    return best;
+}
+
+size_t PoseTrack::advance(size_t index, double meters) const {
+    if (distances.empty()) return 0;
+    index = std::min(index, distances.size() - 1);
+    double target = distances[index] + meters;
+    if (meters >= 0.0) {
+        auto reached = std::lower_bound(distances.begin() + index, distances.end(), target);
+        return reached == distances.end() ? distances.size() - 1 : static_cast<size_t>(reached - distances.begin());
+    }
+    auto beyond = std::upper_bound(distances.begin(), distances.begin() + index, target);
+    return beyond == distances.begin() ? 0 : static_cast<size_t>(beyond - distances.begin()) - 1;
+}
+
+std::vector<size_t> PoseTrack::decimate(double tolerance) const {
+    std::vector<size_t> kept;
+    if (positions.empty()) return kept;
+    
+    // Iterative Douglas-Peucker: split each span at its farthest pose until all are within tolerance
+    std::vector<bool> keep(positions.size(), false);
+    keep.front() = keep.back() = true;
+    std::vector<std::pair<size_t, size_t>> spans = {{0, positions.size() - 1}};
+    while (!spans.empty()) {
+        auto [first, last] = spans.back();
+        spans.pop_back();
+        double farthest = 0.0;
+        size_t split = first;
+        for (size_t i = first + 1; i < last; ++i) {
+            double distance = segmentDistance(positions[i], positions[first], positions[last]);
+            if (distance > farthest) {
+                farthest = distance;
+                split = i;
+            }
+        }
+        if (farthest > tolerance) {
+            keep[split] = true;
+            spans.push_back({first, split});
+            spans.push_back({split, last});
+        }
+    }
+    
+    for (size_t i = 0; i < keep.size(); ++i) {
+        if (keep[i]) kept.push_back(i);
+    }
+    return kept;
+}
+
+std::vector<double> cameraMotion(const PoseTrack& track, const std::vector<uint32_t>& frames,
+                                 const std::vector<cv::Matx44d>& cameraToTrack) {
+    const double UNKNOWN = std::numeric_limits<double>::infinity();
+    std::vector<double> motion(frames.size(), UNKNOWN);
+    std::vector<cv::Vec3d> centres(cameraToTrack.size());
+    long previousPose = -1;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        long pose = track.indexAtOrBefore(frames[i]);
+        if (pose < 0) {
+            previousPose = -1;
+            continue;
+        }
+        if (pose == previousPose) {
+            motion[i] = 0.0;
+            continue;
+        }
+        
+        double largest = 0.0;
+        for (size_t camera = 0; camera < cameraToTrack.size(); ++camera) {
+            cv::Matx44d cameraToWorld = track.pose(static_cast<size_t>(pose)) * cameraToTrack[camera];
+            cv::Vec3d centre(cameraToWorld(0, 3), cameraToWorld(1, 3), cameraToWorld(2, 3));
+            if (previousPose >= 0) {
+                largest = std::max(largest, cv::norm(centre - centres[camera]));
+            }
+            centres[camera] = centre;
+        }
+        if (previousPose >= 0) motion[i] = largest;
+        previousPose = pose;
+    }
+    return motion;
+}
+
+std::vector<size_t> selectMovingFrames(const std::vector<double>& motion, double minMotion) {
+    std::vector<size_t> kept;
+    double accumulated = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < motion.size(); ++i) {
+        accumulated += motion[i];
+        if (accumulated >= minMotion) {
+            kept.push_back(i);
+            accumulated = 0.0;
+        }
+    }
+    return kept;
+}
+
+std::string findPoseFile(const std::string& frameDirectory) {
+    std::error_code error;
+    fs::path directory = fs::weakly_canonical(frameDirectory, error);
+    if (error) directory = frameDirectory;
+    
+    // Walk up to <root>/data_2d_raw/<drive>
+    for (fs::path drive = directory; drive.has_parent_path() && drive != drive.parent_path(); drive = drive.parent_path()) {
+        if (drive.parent_path().filename() != "data_2d_raw") continue;
+        fs::path poses = drive.parent_path().parent_path() / "data_poses" / drive.filename();
+        for (const char* name : {"poses.txt", "cam0_to_world.txt"}) {
+            if (fs::is_regular_file(poses / name, error)) {
+                return (poses / name).string();
+            }
+        }
+        break;
+    }
+    return "";
+}
+
+} // namespace kitti360
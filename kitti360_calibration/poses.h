@@ -0,0 +1,155 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kitti360 {
+
+/**
+ * @brief Coordinate frame a pose file maps into the world
+ */
+enum class PoseSource {
+    Vehicle, // poses.txt: IMU/GPS frame to world, 3x4 per line
+    Camera0  // cam0_to_world.txt: rectified image_00 frame to world, 4x4 per line
+};
+
+/**
+ * @brief Trajectory of a KITTI-360 drive with a spatial index over its positions
+ *
+ * Poses exist only for some frames (KITTI-360 leaves out most frames where
+ * the vehicle stands still), so lookups go from frame numbers to the pose at
+ * or before them. Positions are indexed by a uniform grid on the ground
+ * plane (world x/y), stored as one sorted array with per-cell offsets, so
+ * nearest-position queries only visit the cells around the query point.
+ */
+class PoseTrack {
+public:
+    /**
+     * @brief Memory-map and parse poses.txt or cam0_to_world.txt
+     *
+     * Each line is a frame number followed by 12 (3x4) or 16 (4x4) row-major
+     * values; the first line decides which.
+     * @param filename Path to the pose file
+     * @throws std::runtime_error if the file cannot be read or a line is malformed
+     */
+    static PoseTrack load(const std::string& filename);
+
+    /**
+     * @brief Parse pose file contents held in memory
+     * @throws std::runtime_error if a line is malformed or frames are not ascending
+     */
+    static PoseTrack parse(std::string_view text);
+
+    PoseSource source() const { return poseSource; }
+    size_t size() const { return frames.size(); }
+    bool empty() const { return frames.empty(); }
+
+    uint32_t frame(size_t index) const { return frames[index]; }
+    const cv::Matx44d& pose(size_t index) const { return poses[index]; }
+    const cv::Vec3d& position(size_t index) const { return positions[index]; }
+
+    /**
+     * @brief Path length from the first pose, in metres
+     */
+    double distance(size_t index) const { return distances[index]; }
+
+    /**
+     * @brief Pose of a frame, or of the last frame before it that has one
+     * @return Index of the pose, or -1 if the frame precedes the trajectory
+     */
+    long indexAtOrBefore(uint32_t frameNumber) const;
+
+    /**
+     * @brief Pose nearest to a place on the ground plane
+     * @param x World x in metres
+     * @param y World y in metres
+     * @return Index of the nearest pose (0 for an empty track)
+     */
+    size_t nearest(double x, double y) const;
+
+    /**
+     * @brief First pose at least the given path length further along the trajectory
+     *
+     * Negative distances step backwards. Stationary stretches have no path
+     * length, so they are stepped over.
+     * @return Index of the pose, clamped to the ends of the track
+     */
+    size_t advance(size_t index, double meters) const;
+
+    /**
+     * @brief Poses outlining the trajectory on the ground plane
+     *
+     * Douglas-Peucker simplification of the x/y path: every left out pose is
+     * within the tolerance of the outline.
+     * @param tolerance Largest deviation in metres
+     * @return Indices of the kept poses, ascending
+     */
+    std::vector<size_t> decimate(double tolerance) const;
+
+    /**
+     * @brief Ground-plane bounding box of the trajectory (x, y, width, height in metres)
+     */
+    cv::Rect2d bounds() const { return groundBounds; }
+
+private:
+    void buildSpatialIndex();
+
+    PoseSource poseSource = PoseSource::Vehicle;
+    std::vector<uint32_t> frames;       // Ascending frame numbers
+    std::vector<cv::Matx44d> poses;     // Frame to world
+    std::vector<cv::Vec3d> positions;   // Translation of each pose
+    std::vector<double> distances;      // Cumulative path length
+    cv::Rect2d groundBounds;
+
+    // Grid over the ground plane: poses of cell c are cellPoses[cellStart[c] .. cellStart[c + 1])
+    double cellSize = 1.0;
+    int gridColumns = 0;
+    int gridRows = 0;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellPoses;
+};
+
+/**
+ * @brief How far the cameras moved between consecutive frames
+ *
+ * Each camera's centre is placed in the world through the pose at or before
+ * the frame and the camera's transform into the track's frame (from
+ * calib_cam_to_pose.txt for vehicle poses), and the largest displacement of
+ * any camera since the previous frame is taken. Side-mounted cameras sit
+ * off the vehicle's axis, so turns register even at low speed. Frames that
+ * share a pose (KITTI-360 leaves poses out while the vehicle stands still)
+ * have no motion.
+ * @param track Trajectory of the drive
+ * @param frames Ascending frame numbers
+ * @param cameraToTrack Camera to track frame transform of each camera (identity for the track frame itself)
+ * @return Metres moved per frame; infinity for the first frame and frames before the trajectory, whose motion is unknown
+ */
+std::vector<double> cameraMotion(const PoseTrack& track, const std::vector<uint32_t>& frames,
+                                 const std::vector<cv::Matx44d>& cameraToTrack);
+
+/**
+ * @brief Frames left after skipping those where the cameras barely moved
+ *
+ * A frame is kept once the motion accumulated since the last kept frame
+ * reaches the threshold, so slow driving is thinned out evenly and standing
+ * at a traffic light collapses to a single frame.
+ * @param motion Metres moved per frame (see cameraMotion())
+ * @param minMotion Least motion between kept frames in metres
+ * @return Indices of the kept frames, ascending
+ */
+std::vector<size_t> selectMovingFrames(const std::vector<double>& motion, double minMotion);
+
+/**
+ * @brief Pose file of the drive a frame directory belongs to
+ *
+ * Follows KITTI-360's layout, where the frames of a drive are in
+ * <root>/data_2d_raw/<drive>/image_0X/... and its poses in
+ * <root>/data_poses/<drive>/poses.txt (preferred) or cam0_to_world.txt.
+ * @return Path of the pose file, or an empty string if there is none
+ */
+std::string findPoseFile(const std::string& frameDirectory);
+
+} // namespace kitti360
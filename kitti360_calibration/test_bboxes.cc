@@ -0,0 +1,189 @@
+#include "bboxes.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Unit cube vertices in KITTI-360's order, scaled and placed by each object's transform
+const double CUBE[8][3] = {{0.5, 0.5, 0.5}, {0.5, 0.5, -0.5}, {0.5, -0.5, 0.5}, {0.5, -0.5, -0.5},
+                           {-0.5, 0.5, 0.5}, {-0.5, 0.5, -0.5}, {-0.5, -0.5, 0.5}, {-0.5, -0.5, -0.5}};
+
+struct SyntheticBox {
+    double x, y, yaw, length, width, height;
+    int startFrame, endFrame, timestamp;
+};
+
+void writeMatrix(std::ostringstream& xml, const char* name, int rows, int cols, const double* values) {
+    xml << "  <" << name << " type_id=\"opencv-matrix\">\n    <rows>" << rows << "</rows>\n    <cols>" << cols
+        << "</cols>\n    <dt>f</dt>\n    <data>\n";
+    for (int i = 0; i < rows * cols; ++i) {
+        xml << " " << values[i];
+    }
+    xml << "</data></" << name << ">\n";
+}
+
+std::string syntheticAnnotations(const std::vector<SyntheticBox>& boxes) {
+    std::ostringstream xml;
+    xml.precision(10);
+    xml << "<?xml version=\"1.0\"?>\n<opencv_storage>\n<!-- synthetic -->\n<meta><note>not a box</note></meta>\n";
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        const SyntheticBox& box = boxes[i];
+        double c = std::cos(box.yaw), s = std::sin(box.yaw);
+        double transform[16] = {c * box.length, -s * box.width, 0, 1000.0 + box.x,
+                                s * box.length, c * box.width, 0, 3000.0 + box.y,
+                                0, 0, box.height, 110.0 + box.height / 2,
+                                0, 0, 0, 1};
+        xml << "<object" << i + 1 << ">\n";
+        writeMatrix(xml, "transform", 4, 4, transform);
+        xml << "  <index>" << i << "</index>\n  <semanticId>" << 26 << "</semanticId>\n  <instanceId>" << i
+            << "</instanceId>\n";
+        writeMatrix(xml, "vertices", 8, 3, &CUBE[0][0]);
+        xml << "  <start_frame>" << box.startFrame << "</start_frame>\n  <end_frame>" << box.endFrame
+            << "</end_frame>\n  <timestamp>" << box.timestamp << "</timestamp>\n</object" << i + 1 << ">\n";
+    }
+    xml << "</opencv_storage>\n";
+    return xml.str();
+}
+
+bool footprintOverlaps(const kitti360::Box3D& box, double x, double y, double radius) {
+    double minX = box.corners[0][0], maxX = minX, minY = box.corners[0][1], maxY = minY;
+    for (int corner = 1; corner < 8; ++corner) {
+        minX = std::min(minX, static_cast<double>(box.corners[corner][0]));
+        maxX = std::max(maxX, static_cast<double>(box.corners[corner][0]));
+        minY = std::min(minY, static_cast<double>(box.corners[corner][1]));
+        maxY = std::max(maxY, static_cast<double>(box.corners[corner][1]));
+    }
+    return maxX >= x - radius && minX <= x + radius && maxY >= y - radius && minY <= y + radius;
+}
+
+kitti360::Box3D axisAlignedBox(double x, double y, double z, double size) {
+    kitti360::Box3D box{};
+    for (int corner = 0; corner < 8; ++corner) {
+        box.corners[corner][0] = static_cast<float>(x + ((corner & 1) ? size : -size) / 2);
+        box.corners[corner][1] = static_cast<float>(y + ((corner & 2) ? size : -size) / 2);
+        box.corners[corner][2] = static_cast<float>(z + ((corner & 4) ? size : -size) / 2);
+    }
+    return box;
+}
+
+} // namespace
+
+int main() {
+    try {
+        // Corners come out in bit order whatever the file's vertex order; static and dynamic ranges
+        std::cout << "Parsing annotations..." << std::endl;
+        kitti360::BoxAnnotations small = kitti360::BoxAnnotations::parse(syntheticAnnotations({
+            {0.0, 0.0, 0.0, 4.0, 2.0, 1.5, 10, 90, -1},
+            {20.0, 5.0, PI / 2, 4.0, 2.0, 1.5, 0, 0, 42},
+        }));
+        const kitti360::Box3D& car = small.box(1);
+        double originX = small.origin()[0], originY = small.origin()[1];
+        if (small.size() != 2 || std::abs(originX - 998.0) > 1e-6 || std::abs(originY - 2999.0) > 1e-6 ||
+            small.box(0).firstFrame != 10 || small.box(0).lastFrame != 90 || small.box(0).dynamic ||
+            !car.dynamic || car.firstFrame != 42 || car.lastFrame != 42 || car.semanticId != 26 || car.instanceId != 1) {
+            std::cerr << "Annotations parsed wrongly" << std::endl;
+            return 1;
+        }
+        // Corner 1 is corner 0 moved along the box's own x axis, rotated a quarter turn into world y
+        if (std::abs(car.corners[1][0] - car.corners[0][0]) > 1e-4 || std::abs(car.corners[1][1] - car.corners[0][1] - 4.0) > 1e-4 ||
+            std::abs(car.corners[4][2] - car.corners[0][2] - 1.5) > 1e-4) {
+            std::cerr << "Box corners are out of order" << std::endl;
+            return 1;
+        }
+        
+        // Grid query finds every box whose footprint reaches the query square in that frame
+        std::cout << "Indexing a long sequence..." << std::endl;
+        std::mt19937 random(11);
+        std::uniform_real_distribution<double> position(0.0, 3000.0), angle(-PI, PI), extent(1.0, 30.0);
+        std::uniform_int_distribution<int> frame(0, 10000), span(0, 300);
+        std::vector<SyntheticBox> synthetic;
+        for (int i = 0; i < 20000; ++i) {
+            int first = frame(random);
+            bool dynamic = i % 4 == 0;
+            synthetic.push_back({position(random), position(random) / 10.0, angle(random), extent(random), extent(random),
+                                 3.0, first, first + span(random), dynamic ? first : -1});
+        }
+        std::string text = syntheticAnnotations(synthetic);
+        auto start = std::chrono::steady_clock::now();
+        kitti360::BoxAnnotations annotations = kitti360::BoxAnnotations::parse(text);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << annotations.size() << " boxes (" << text.size() / 1024 << " KB) in " << milliseconds
+                  << " ms" << std::endl;
+        
+        std::vector<uint32_t> found;
+        double queryMilliseconds = 0.0;
+        for (int query = 0; query < 500; ++query) {
+            uint32_t frameNumber = static_cast<uint32_t>(frame(random));
+            double x = 1000.0 + position(random), y = 3000.0 + position(random) / 10.0;
+            start = std::chrono::steady_clock::now();
+            annotations.visibleBoxes(frameNumber, x, y, 60.0, found);
+            queryMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            
+            for (size_t i = 0; i < annotations.size(); ++i) {
+                const kitti360::Box3D& box = annotations.box(i);
+                bool inFrame = frameNumber >= box.firstFrame && frameNumber <= box.lastFrame;
+                bool listed = std::binary_search(found.begin(), found.end(), static_cast<uint32_t>(i));
+                if (listed && !inFrame) {
+                    std::cerr << "Box " << i << " listed outside its frames" << std::endl;
+                    return 1;
+                }
+                if (inFrame && !listed &&
+                    footprintOverlaps(box, x - annotations.origin()[0], y - annotations.origin()[1], 60.0)) {
+                    std::cerr << "Box " << i << " missing from frame " << frameNumber << std::endl;
+                    return 1;
+                }
+            }
+        }
+        std::cout << "  " << queryMilliseconds / 500 * 1000.0 << " us per frame query" << std::endl;
+        
+        // Edges in front of the camera project through the pinhole model; behind, they are clipped
+        std::cout << "Projecting edges..." << std::endl;
+        cv::Matx33d cameraMatrix = cv::Matx33d::eye();
+        cameraMatrix(0, 0) = cameraMatrix(1, 1) = 100.0;
+        cameraMatrix(0, 2) = cameraMatrix(1, 2) = 50.0;
+        std::vector<cv::Point2f> segments;
+        kitti360::projectBoxEdges(axisAlignedBox(0.0, 0.0, 10.0, 2.0), cv::Matx44d::eye(), cameraMatrix, segments);
+        bool cornerFound = false;
+        for (const cv::Point2f& point : segments) {
+            cornerFound = cornerFound || (std::abs(point.x - (50.0f + 100.0f / 11.0f)) < 1e-3f &&
+                                          std::abs(point.y - (50.0f + 100.0f / 11.0f)) < 1e-3f);
+        }
+        size_t inFront = segments.size();
+        segments.clear();
+        kitti360::projectBoxEdges(axisAlignedBox(0.0, 0.0, -10.0, 2.0), cv::Matx44d::eye(), cameraMatrix, segments);
+        size_t behind = segments.size();
+        segments.clear();
+        kitti360::projectBoxEdges(axisAlignedBox(0.0, 0.0, 0.0, 2.0), cv::Matx44d::eye(), cameraMatrix, segments);
+        bool finite = true;
+        for (const cv::Point2f& point : segments) {
+            finite = finite && std::isfinite(point.x) && std::isfinite(point.y);
+        }
+        if (inFront != 24 || !cornerFound || behind != 0 || segments.size() != 16 || !finite) {
+            std::cerr << "Edge projection is wrong" << std::endl;
+            return 1;
+        }
+        
+        try {
+            kitti360::BoxAnnotations::parse(
+                "<opencv_storage><object1><transform><rows>4</rows><cols>4</cols><data>1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1</data>"
+                "</transform><vertices><rows>8</rows><cols>3</cols><data>0 0 0</data></vertices></object1></opencv_storage>");
+            std::cerr << "Malformed annotation was accepted" << std::endl;
+            return 1;
+        } catch (const std::runtime_error&) {
+        }
+        
+        std::cout << "Box annotations are indexed and projected" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
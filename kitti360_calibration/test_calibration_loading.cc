@@ -33,6 +33,33 @@ int main() {
             std::cout << matrix << std::endl << std::endl;
         }
         
+        // Test single-pass parser against the per-variable loaders
+        std::cout << "Checking single-pass calibration parser..." << std::endl;
+        auto parsed = kitti360::ParsedCalibration::fromFile("perspective.txt");
+        std::cout << "perspective.txt variables: " << parsed.size() << std::endl;
+        
+        for (const auto& [param, matrix] : perspective) {
+            bool isProjection = param.find("P_rect") == 0;
+            cv::Mat reparsed = parsed.matrix(param, 3, isProjection ? 4 : 3);
+            if (cv::norm(reparsed, matrix(cv::Rect(0, 0, reparsed.cols, reparsed.rows))) != 0.0) {
+                std::cerr << "Parser mismatch for " << param << std::endl;
+                return 1;
+            }
+        }
+        
+        if (!parsed.contains("D_00") || parsed.values("D_00")->size() != 5 || parsed.contains("missing")) {
+            std::cerr << "Parser lookup check failed" << std::endl;
+            return 1;
+        }
+        
+        // The first occurrence of a name wins, even when it holds no numbers
+        auto duplicates = kitti360::ParsedCalibration::fromString("S_00:\nS_00: 1 2\nK_00: 3\nK_00: 4\n");
+        if (duplicates.values("S_00")->size() != 0 || duplicates.values("K_00")->at(0) != 3.0) {
+            std::cerr << "Parser duplicate check failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Parser matches loaders" << std::endl << std::endl;
+        
         // Test fisheye parameters
         std::cout << "Loading fisheye parameters..." << std::endl;
         auto fisheye02 = kitti360::loadFisheyeParams("image_02.yaml");
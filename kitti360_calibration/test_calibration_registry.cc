@@ -0,0 +1,160 @@
+#include "calibration_registry.h"
+#include "map_cache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+int main() {
+    try {
+        auto& registry = kitti360::CalibrationRegistry::instance();
+        
+        // Loading an unchanged directory twice must share one snapshot
+        std::cout << "Loading calibration directory..." << std::endl;
+        auto snapshot = registry.load(".");
+        auto again = registry.load(".");
+        if (snapshot != again) {
+            std::cerr << "Unchanged directory was parsed twice" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Directory: " << snapshot->directory << std::endl;
+        std::cout << "Content hash: " << std::hex << snapshot->contentHash << std::dec << std::endl;
+        std::cout << "Fisheye cameras: " << snapshot->fisheyeCameras.size() << std::endl;
+        std::cout << "Camera to pose transforms: " << snapshot->cameraToPose.size() << std::endl;
+        std::cout << "Perspective intrinsics: " << snapshot->perspectiveIntrinsics.size() << std::endl << std::endl;
+        
+        const auto& camera = snapshot->fisheye("image_02");
+        std::cout << "image_02 camera matrix:" << std::endl << camera.cameraMatrix << std::endl;
+        std::cout << "image_02 distortion: " << camera.distCoeffs.t() << std::endl << std::endl;
+        
+        // Concurrent requests for the same maps must build them once
+        std::cout << "Requesting undistortion maps from 4 threads..." << std::endl;
+        std::shared_ptr<const kitti360::UndistortionMaps> results[4];
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 4; ++i) {
+            workers.emplace_back([&, i] {
+                results[i] = registry.undistortionMaps(snapshot, "image_02");
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        
+        for (const auto& maps : results) {
+            if (maps != results[0]) {
+                std::cerr << "Undistortion maps were built more than once" << std::endl;
+                return 1;
+            }
+        }
+        
+        std::cout << "Output size: " << results[0]->outputSize << std::endl;
+        if (results[0]->outputSize != cv::Size(camera.params.image_width * 4, camera.params.image_height * 2)) {
+            std::cerr << "Unexpected unwrapped output size" << std::endl;
+            return 1;
+        }
+        
+        // Unknown cameras are reported, not cached
+        bool threw = false;
+        try {
+            registry.undistortionMaps(snapshot, "image_09");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        if (!threw) {
+            std::cerr << "Missing camera did not raise an error" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "Registry shares snapshots and maps" << std::endl << std::endl;
+        
+        // Map packages must round-trip maps and calibration unchanged
+        std::cout << "Writing and mapping a map package..." << std::endl;
+        const std::string packagePath = "test_map_package.k360map";
+        kitti360::writeMapPackage(packagePath, "image_02", camera.cameraMatrix, camera.distCoeffs,
+                                  kitti360::UnwrapSettings(), *results[0], snapshot->contentHash);
+        auto package = kitti360::MapPackage::open(packagePath);
+        std::remove(packagePath.c_str());
+        
+        bool packageMatches = package->cameraName == "image_02" &&
+                              package->sourceHash == snapshot->contentHash &&
+                              package->maps.outputSize == results[0]->outputSize &&
+                              cv::norm(package->cameraMatrix, camera.cameraMatrix) == 0.0 &&
+                              cv::norm(package->maps.map1, results[0]->map1, cv::NORM_INF) == 0.0 &&
+                              cv::norm(package->maps.map2, results[0]->map2, cv::NORM_INF) == 0.0;
+        if (!packageMatches) {
+            std::cerr << "Map package does not match the maps it was written from" << std::endl;
+            return 1;
+        }
+        std::cout << "Map package round-trips" << std::endl << std::endl;
+        
+        // Perspective cameras rectify from the raw S_XX frame into the S_rect_XX frame
+        std::cout << "Requesting rectification maps..." << std::endl;
+        const auto& perspective = snapshot->perspective("image_00");
+        auto rectified = registry.rectificationMaps(snapshot, "image_00");
+        if (rectified != registry.rectificationMaps(snapshot, "image_00") ||
+            rectified->inputSize != perspective.imageSize || rectified->outputSize != perspective.rectifiedSize ||
+            rectified->inputSize != cv::Size(1392, 512) || rectified->outputSize != cv::Size(1408, 376)) {
+            std::cerr << "Unexpected rectification maps" << std::endl;
+            return 1;
+        }
+        std::cout << "image_00: " << rectified->inputSize << " -> " << rectified->outputSize << std::endl;
+        
+        // The rectified principal point must come from the raw principal point
+        cv::Point2d center(perspective.projection.at<double>(0, 2), perspective.projection.at<double>(1, 2));
+        cv::Mat floatMaps;
+        cv::convertMaps(rectified->map1, rectified->map2, floatMaps, cv::noArray(), CV_32FC2);
+        cv::Vec2f source = floatMaps.at<cv::Vec2f>(cvRound(center.y), cvRound(center.x));
+        std::vector<cv::Point2d> distorted{cv::Point2d(source[0], source[1])}, undistorted;
+        cv::undistortPoints(distorted, undistorted, perspective.cameraMatrix, perspective.distCoeffs,
+                            perspective.rectification, rectified->newCameraMatrix);
+        if (cv::norm(undistorted[0] - cv::Point2d(cvRound(center.x), cvRound(center.y))) > 0.5) {
+            std::cerr << "Rectification maps disagree with cv::undistortPoints" << std::endl;
+            return 1;
+        }
+        
+        // Five-coefficient perspective distortion must survive a package round trip
+        kitti360::writeMapPackage(packagePath, "image_00", perspective.cameraMatrix, perspective.distCoeffs,
+                                  kitti360::UnwrapSettings{0.0, 0.0, 0.0}, *rectified, snapshot->contentHash);
+        auto rectifiedPackage = kitti360::MapPackage::open(packagePath);
+        std::remove(packagePath.c_str());
+        if (rectifiedPackage->distCoeffs.total() != 5 ||
+            cv::norm(rectifiedPackage->distCoeffs.reshape(1, 1), perspective.distCoeffs) != 0.0 ||
+            cv::norm(rectifiedPackage->maps.map1, rectified->map1, cv::NORM_INF) != 0.0) {
+            std::cerr << "Rectification map package does not round-trip" << std::endl;
+            return 1;
+        }
+        std::cout << "Rectification maps are shared and round-trip" << std::endl << std::endl;
+        
+        // Reloading an edited directory must not keep the old revision alive
+        std::cout << "Reloading an edited calibration directory..." << std::endl;
+        namespace fs = std::filesystem;
+        fs::path edited = fs::temp_directory_path() / "test_calibration_registry";
+        fs::remove_all(edited);
+        fs::create_directories(edited);
+        for (const char* name : {"image_02.yaml", "image_03.yaml", "perspective.txt", "calib_cam_to_pose.txt"}) {
+            fs::copy_file(name, edited / name);
+        }
+        auto first = registry.load(edited.string());
+        uint64_t firstHash = first->contentHash;
+        std::weak_ptr<const kitti360::CalibrationSnapshot> firstSnapshot = first;
+        std::weak_ptr<const kitti360::UndistortionMaps> firstMaps = registry.rectificationMaps(first, "image_00");
+        first.reset();
+        std::ofstream(edited / "calib_cam_to_pose.txt", std::ios::app) << "\n";
+        auto second = registry.load(edited.string());
+        fs::remove_all(edited);
+        if (!firstSnapshot.expired() || !firstMaps.expired() || second->contentHash == firstHash ||
+            second->perspectiveCameras.size() != 2) {
+            std::cerr << "Older calibration revision is still cached" << std::endl;
+            return 1;
+        }
+        std::cout << "Older revisions are released on reload" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
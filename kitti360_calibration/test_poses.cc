@@ -0,0 +1,143 @@
+#include "poses.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+
+// Figure-eight drive with a stop: poses every ~1 m, none while standing (like KITTI-360)
+std::string syntheticPoses(int count) {
+    std::ostringstream text;
+    text.precision(10);
+    uint32_t frame = 0;
+    for (int i = 0; i < count; ++i) {
+        double angle = i * 0.002;
+        double x = 500.0 * std::sin(angle);
+        double y = 250.0 * std::sin(2.0 * angle);
+        frame += (i == count / 2) ? 300 : 1;
+        text << frame << " 1 0 0 " << x << " 0 1 0 " << y << " 0 0 1 " << 0.01 * i << "\n";
+    }
+    return text.str();
+}
+
+size_t bruteForceNearest(const kitti360::PoseTrack& track, double x, double y) {
+    size_t best = 0;
+    double bestDistance = 1e300;
+    for (size_t i = 0; i < track.size(); ++i) {
+        double distance = std::hypot(track.position(i)[0] - x, track.position(i)[1] - y);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int main() {
+    try {
+        std::cout << "Parsing poses..." << std::endl;
+        std::string text = syntheticPoses(20000);
+        auto start = std::chrono::steady_clock::now();
+        kitti360::PoseTrack track = kitti360::PoseTrack::parse(text);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << track.size() << " poses in " << milliseconds << " ms, "
+                  << track.distance(track.size() - 1) << " m" << std::endl;
+        if (track.size() != 20000 || track.source() != kitti360::PoseSource::Vehicle ||
+            std::abs(track.position(10)[0] - 500.0 * std::sin(0.02)) > 1e-6) {
+            std::cerr << "Poses parsed wrongly" << std::endl;
+            return 1;
+        }
+        
+        // Frames without a pose map to the pose before them
+        if (track.indexAtOrBefore(1) != 0 || track.indexAtOrBefore(0) != -1 ||
+            track.indexAtOrBefore(track.frame(10000) - 5) != 9999 || track.indexAtOrBefore(track.frame(10000)) != 10000) {
+            std::cerr << "Frame lookup is wrong" << std::endl;
+            return 1;
+        }
+        
+        // Grid search agrees with a linear scan, inside and outside the trajectory's bounds
+        std::cout << "Querying nearest poses..." << std::endl;
+        std::mt19937 random(7);
+        std::uniform_real_distribution<double> coordinate(-700.0, 700.0);
+        for (int i = 0; i < 2000; ++i) {
+            double x = coordinate(random), y = coordinate(random);
+            size_t found = track.nearest(x, y);
+            size_t expected = bruteForceNearest(track, x, y);
+            double foundDistance = std::hypot(track.position(found)[0] - x, track.position(found)[1] - y);
+            double expectedDistance = std::hypot(track.position(expected)[0] - x, track.position(expected)[1] - y);
+            if (foundDistance > expectedDistance + 1e-9) {
+                std::cerr << "Nearest pose to (" << x << ", " << y << ") is wrong" << std::endl;
+                return 1;
+            }
+        }
+        
+        // Distance steps skip the stop and land on the first pose far enough along
+        size_t ahead = track.advance(100, 25.0);
+        size_t back = track.advance(ahead, -25.0);
+        if (track.distance(ahead) < track.distance(100) + 25.0 || track.distance(ahead - 1) >= track.distance(100) + 25.0 ||
+            back > 100 || track.advance(19990, 1000.0) != 19999 || track.advance(5, -1000.0) != 0) {
+            std::cerr << "Distance steps are wrong" << std::endl;
+            return 1;
+        }
+        
+        // Outline stays within tolerance with far fewer poses
+        std::vector<size_t> outline = track.decimate(1.0);
+        std::cout << "  Outline: " << outline.size() << " of " << track.size() << " poses" << std::endl;
+        if (outline.size() < 10 || outline.size() > track.size() / 10 || outline.front() != 0 ||
+            outline.back() != track.size() - 1) {
+            std::cerr << "Trajectory outline is wrong" << std::endl;
+            return 1;
+        }
+        
+        // cam0_to_world.txt rows are 4x4
+        kitti360::PoseTrack cameraTrack = kitti360::PoseTrack::parse(
+            "3 1 0 0 1.5 0 1 0 2.5 0 0 1 3.5 0 0 0 1\n8 1 0 0 2.5 0 1 0 2.5 0 0 1 3.5 0 0 0 1\n");
+        if (cameraTrack.source() != kitti360::PoseSource::Camera0 || cameraTrack.size() != 2 ||
+            cameraTrack.distance(1) != 1.0) {
+            std::cerr << "Camera poses parsed wrongly" << std::endl;
+            return 1;
+        }
+        
+        // Creeping forward, a stop without poses, then a quarter turn: the side camera sees the turn
+        std::cout << "Measuring camera motion..." << std::endl;
+        kitti360::PoseTrack stopTrack = kitti360::PoseTrack::parse(
+            "10 1 0 0 0 0 1 0 0 0 0 1 0\n11 1 0 0 0.1 0 1 0 0 0 0 1 0\n12 1 0 0 0.2 0 1 0 0 0 0 1 0\n"
+            "41 0 -1 0 0.2 1 0 0 0 0 0 1 0\n42 0 -1 0 1.2 1 0 0 0 0 0 1 0\n");
+        std::vector<uint32_t> frames = {5};
+        for (uint32_t frame = 10; frame <= 45; ++frame) {
+            frames.push_back(frame);
+        }
+        cv::Matx44d sideCamera = cv::Matx44d::eye();
+        sideCamera(1, 3) = 1.0;
+        std::vector<double> motion = kitti360::cameraMotion(stopTrack, frames, {cv::Matx44d::eye(), sideCamera});
+        std::vector<size_t> moving = kitti360::selectMovingFrames(motion, 0.25);
+        if (!std::isinf(motion[0]) || !std::isinf(motion[1]) || std::abs(motion[2] - 0.1) > 1e-9 || motion[20] != 0.0 ||
+            std::abs(motion[32] - std::sqrt(2.0)) > 1e-9 || std::abs(motion[33] - 1.0) > 1e-9 || motion[36] != 0.0 ||
+            moving != std::vector<size_t>{0, 1, 32, 33}) {
+            std::cerr << "Camera motion is wrong" << std::endl;
+            return 1;
+        }
+        
+        for (const char* malformed : {"1 1 0 0\n", "1 1 0 0 0 0 1 0 0 0 0 1 0\n0 1 0 0 0 0 1 0 0 0 0 1 0\n",
+                                      "1 1 0 0 0 0 1 0 0 0 0 1 x\n"}) {
+            try {
+                kitti360::PoseTrack::parse(malformed);
+                std::cerr << "Malformed pose file was accepted" << std::endl;
+                return 1;
+            } catch (const std::runtime_error&) {
+            }
+        }
+        
+        std::cout << "Pose track lookups match" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -10,17 +10,32 @@
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "frame_pipeline/filmstrip_atlas.h"
+#include "frame_pipeline/frame_format.h"
+#include "frame_pipeline/jpeg_decoder.h"
+#include "frame_pipeline/thumbnails.h"
 
 namespace fs = std::filesystem;
 
 struct ImageData {
     SDL_Texture* texture;
     SDL_Surface* surface;
+    std::vector<Uint8> yuvPixels; // Planar YUV 4:2:0 (or Y plane only in gray mode), used instead of surface
+    int width, height;
+    int scaleDenominator; // JPEGs are decoded at 1/2, 1/4 or 1/8 size when that still fills the window
     std::string filename;
+    std::atomic<bool> loadStarted; // Claimed by a loader thread, so an urgent load never decodes twice
     std::atomic<bool> surfaceLoaded;
     std::atomic<bool> textureCreated;
     
-    ImageData() : texture(nullptr), surface(nullptr), surfaceLoaded(false), textureCreated(false) {}
+    ImageData() : texture(nullptr), surface(nullptr), width(0), height(0), scaleDenominator(1),
+                  loadStarted(false), surfaceLoaded(false), textureCreated(false) {}
     ~ImageData() {
         if (texture) {
             SDL_DestroyTexture(texture);
@@ -31,6 +46,41 @@ struct ImageData {
     }
 };
 
+// Read-only mapping of a whole file; data is null if the file cannot be opened or mapped
+struct MappedFile {
+    const Uint8* data;
+    size_t size;
+    
+    explicit MappedFile(const std::string& filename) : data(nullptr), size(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED) {
+                data = static_cast<const Uint8*>(mapping);
+                size = static_cast<size_t>(info.st_size);
+                
+                // Decoders read the file front to back
+                madvise(mapping, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+    
+    ~MappedFile() {
+        if (data) {
+            munmap(const_cast<Uint8*>(data), size);
+        }
+    }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
 class FisheyeViewer {
 private:
     SDL_Window* window;
@@ -38,26 +88,58 @@ private:
     std::vector<std::string> imageFiles;
     std::vector<std::unique_ptr<ImageData>> images;
     int currentIndex;
-    int windowWidth, windowHeight;
+    std::atomic<int> windowWidth, windowHeight; // Read by the loader threads to pick JPEG decode scales
     bool running;
+    frame_pipeline::FrameFormat frameFormat;
+    std::vector<Uint8> neutralChroma; // Constant U/V planes for showing gray frames through IYUV textures
+    Uint32 textureFormat; // Renderer-native format RGB surfaces are converted to on the loader threads
     
     // Background loading
     std::vector<std::thread> backgroundLoaders;
     std::mutex imagesMutex;
     std::atomic<bool> backgroundLoadingComplete;
     std::atomic<size_t> nextImageToLoad;
+    std::atomic<int> urgentImage; // Image the filmstrip jumped to, loaded before any other (-1 if none)
+    std::atomic<int> urgentInFlight; // That image until its decode finishes, while thumbnails wait (-1 if none)
     const int INITIAL_LOAD_COUNT = 10;
     const int NUM_LOADING_THREADS = 4;
     
+    // Filmstrip (F): thumbnails around the current image, rendered from reduced decodes by a
+    // low-priority thread into a cache file and packed into atlas textures, so the strip
+    // draws with one call per atlas page
+    std::string thumbnailCacheDirectory; // Empty keeps thumbnails in memory only
+    std::unique_ptr<frame_pipeline::ThumbnailStore> thumbnailStore;
+    frame_pipeline::ThumbnailGenerator thumbnailGenerator;
+    frame_pipeline::FilmstripAtlas filmstrip;
+    bool filmstripVisible;
+    
 public:
     FisheyeViewer() : window(nullptr), renderer(nullptr), currentIndex(0), 
                       windowWidth(1280), windowHeight(720), running(true), 
-                      backgroundLoadingComplete(false), nextImageToLoad(0) {}
+                      frameFormat(frame_pipeline::FrameFormat::BGR), textureFormat(SDL_PIXELFORMAT_ARGB8888),
+                      backgroundLoadingComplete(false), nextImageToLoad(0), urgentImage(-1), urgentInFlight(-1),
+                      filmstripVisible(true) {}
     
     ~FisheyeViewer() {
         cleanup();
     }
     
+    // Must be called before images are loaded
+    void setThumbnailCacheDirectory(const std::string& directory) {
+        thumbnailCacheDirectory = directory;
+    }
+    
+    // Must be called before images are loaded
+    void setFrameFormat(frame_pipeline::FrameFormat format) {
+        frameFormat = format;
+        std::cout << "Frame format: " << frame_pipeline::frameFormatName(frameFormat) << std::endl;
+        
+        // Full-range conversion makes the Y plane plain luminance and displays it unchanged
+        if (frameFormat == frame_pipeline::FrameFormat::Gray) {
+            SDL_SetYUVConversionMode(SDL_YUV_CONVERSION_JPEG);
+        }
+    }
+    
     bool initialize() {
         if (SDL_Init(SDL_INIT_VIDEO) < 0) {
             std::cerr << "SDL could not initialize! SDL Error: " << SDL_GetError() << std::endl;
@@ -87,10 +169,27 @@ public:
         }
         
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        chooseTextureFormat();
         
         return true;
     }
     
+    // Use the renderer's preferred packed 32-bit format so texture creation is a plain copy
+    void chooseTextureFormat() {
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(renderer, &info) == 0) {
+            for (Uint32 i = 0; i < info.num_texture_formats; ++i) {
+                Uint32 format = info.texture_formats[i];
+                if (!SDL_ISPIXELFORMAT_FOURCC(format) && !SDL_ISPIXELFORMAT_INDEXED(format) &&
+                    SDL_BYTESPERPIXEL(format) == 4) {
+                    textureFormat = format;
+                    break;
+                }
+            }
+        }
+        std::cout << "Texture format: " << SDL_GetPixelFormatName(textureFormat) << std::endl;
+    }
+    
     bool loadImageList(const std::string& directory) {
         try {
             for (const auto& entry : fs::directory_iterator(directory)) {
@@ -148,12 +247,108 @@ public:
         // Load initial images for instant access, then start background loading
         loadInitialImages();
         startBackgroundLoading();
+        startThumbnails();
+        
+        return true;
+    }
+    
+    // Decode an image straight from a read-only mapping of its file instead of copying it
+    // through stdio; mapped pages are the page cache shared with other viewers of the files
+    SDL_Surface* loadSurface(const std::string& filename) {
+        MappedFile file(filename);
+        if (!file.data) {
+            return IMG_Load(filename.c_str()); // Reports the error through IMG_GetError
+        }
+        return IMG_Load_RW(SDL_RWFromConstMem(file.data, static_cast<int>(file.size)), 1);
+    }
+    
+    // Decode an image and keep it. JPEGs are decoded by libjpeg at the smallest DCT scale
+    // that still fills the window, straight into the texture format or the gray Y plane;
+    // other images, and JPEGs libjpeg rejects, go through SDL_image.
+    void loadImage(size_t index) {
+        const std::string& filename = images[index]->filename;
+        MappedFile file(filename);
+        if (file.data && frame_pipeline::isJpeg(file.data, file.size) && loadJpeg(index, file)) {
+            return;
+        }
+        
+        SDL_Surface* surface = file.data ? IMG_Load_RW(SDL_RWFromConstMem(file.data, static_cast<int>(file.size)), 1)
+                                         : IMG_Load(filename.c_str());
+        if (surface) {
+            storeSurface(index, surface, 1);
+        }
+    }
+    
+    bool loadJpeg(size_t index, const MappedFile& file) {
+        frame_pipeline::JpegInfo info;
+        if (!frame_pipeline::readJpegInfo(file.data, file.size, info)) {
+            return false;
+        }
+        int scale = frame_pipeline::chooseJpegScale(info.width, info.height, windowWidth, windowHeight);
+        int width, height;
+        frame_pipeline::scaledJpegSize(info, scale, width, height);
+        
+        // Gray frames need no color conversion at all; crop to even for IYUV textures
+        if (frameFormat == frame_pipeline::FrameFormat::Gray && width > 1 && height > 1) {
+            std::vector<Uint8> gray(static_cast<size_t>(width) * height);
+            if (!frame_pipeline::decodeJpegInto(file.data, file.size, scale, frame_pipeline::JpegPixelFormat::Gray,
+                                                gray.data(), width)) {
+                return false;
+            }
+            int evenWidth = width & ~1;
+            int evenHeight = height & ~1;
+            if (evenWidth != width) {
+                for (int y = 1; y < evenHeight; ++y) {
+                    std::memmove(gray.data() + static_cast<size_t>(y) * evenWidth,
+                                 gray.data() + static_cast<size_t>(y) * width, evenWidth);
+                }
+            }
+            gray.resize(static_cast<size_t>(evenWidth) * evenHeight);
+            storePlanes(index, std::move(gray), evenWidth, evenHeight, scale);
+            return true;
+        }
         
+        frame_pipeline::JpegPixelFormat format;
+        Uint32 surfaceFormat = jpegSurfaceFormat(format);
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, SDL_BITSPERPIXEL(surfaceFormat),
+                                                              surfaceFormat);
+        if (!surface) {
+            return false;
+        }
+        if (!frame_pipeline::decodeJpegInto(file.data, file.size, scale, format,
+                                            static_cast<uint8_t*>(surface->pixels), surface->pitch)) {
+            SDL_FreeSurface(surface);
+            return false;
+        }
+        storeSurface(index, surface, scale);
         return true;
     }
     
+    // Surface format libjpeg writes directly: the texture format when it is a byte order the
+    // decoder produces, else RGB24 (also used for YUV frames, which convert from RGB)
+    Uint32 jpegSurfaceFormat(frame_pipeline::JpegPixelFormat& format) const {
+        if (frameFormat == frame_pipeline::FrameFormat::BGR) {
+            switch (textureFormat) {
+                case SDL_PIXELFORMAT_BGRA32: format = frame_pipeline::JpegPixelFormat::BGRA; return textureFormat;
+                case SDL_PIXELFORMAT_RGBA32: format = frame_pipeline::JpegPixelFormat::RGBA; return textureFormat;
+                case SDL_PIXELFORMAT_ARGB32: format = frame_pipeline::JpegPixelFormat::ARGB; return textureFormat;
+                case SDL_PIXELFORMAT_ABGR32: format = frame_pipeline::JpegPixelFormat::ABGR; return textureFormat;
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+                case SDL_PIXELFORMAT_RGB888: format = frame_pipeline::JpegPixelFormat::BGRA; return textureFormat;
+                case SDL_PIXELFORMAT_BGR888: format = frame_pipeline::JpegPixelFormat::RGBA; return textureFormat;
+#else
+                case SDL_PIXELFORMAT_RGB888: format = frame_pipeline::JpegPixelFormat::ARGB; return textureFormat;
+                case SDL_PIXELFORMAT_BGR888: format = frame_pipeline::JpegPixelFormat::ABGR; return textureFormat;
+#endif
+                default: break;
+            }
+        }
+        format = frame_pipeline::JpegPixelFormat::RGB;
+        return SDL_PIXELFORMAT_RGB24;
+    }
+    
     SDL_Texture* loadImageTexture(const std::string& filename) {
-        SDL_Surface* surface = IMG_Load(filename.c_str());
+        SDL_Surface* surface = loadSurface(filename);
         if (!surface) {
             std::cerr << "Unable to load image " << filename << "! SDL_image Error: " << IMG_GetError() << std::endl;
             return nullptr;
@@ -179,19 +374,10 @@ public:
             std::cout << "Loading image " << (i + 1) << "/" << initialCount << ": " 
                       << fs::path(images[i]->filename).filename().string() << std::endl;
             
-            // Load surface first
-            SDL_Surface* surface = IMG_Load(images[i]->filename.c_str());
-            if (surface) {
-                std::lock_guard<std::mutex> lock(imagesMutex);
-                images[i]->surface = surface;
-                images[i]->surfaceLoaded = true;
-                
-                // Create texture immediately for initial images
-                images[i]->texture = SDL_CreateTextureFromSurface(renderer, surface);
-                if (images[i]->texture) {
-                    images[i]->textureCreated = true;
-                }
-            }
+            // Load surface first, then create texture immediately for initial images
+            images[i]->loadStarted = true;
+            loadImage(i);
+            ensureTextureCreated(i);
         }
         
         // Set the next image index for background loading
@@ -201,16 +387,147 @@ public:
     }
     
     void loadSurfaceInBackground(size_t index) {
-        if (index >= images.size()) return;
+        if (index >= images.size() || images[index]->loadStarted.exchange(true)) return;
         
         // Load surface (this is thread-safe)
-        SDL_Surface* surface = IMG_Load(images[index]->filename.c_str());
+        loadImage(index);
         
-        if (surface) {
+        // Whichever thread claimed an urgent image, thumbnails resume once it is decoded (or failed)
+        int decoded = static_cast<int>(index);
+        urgentInFlight.compare_exchange_strong(decoded, -1);
+    }
+    
+    // Keep a decoded surface, as planar YUV 4:2:0 in YUV mode or its Y plane in gray mode
+    // (takes ownership of the surface)
+    void storeSurface(size_t index, SDL_Surface* surface, int scaleDenominator) {
+        std::vector<Uint8> yuvPixels;
+        if (frameFormat != frame_pipeline::FrameFormat::BGR) {
+            yuvPixels = convertToYuv(surface);
+        }
+        if (frameFormat == frame_pipeline::FrameFormat::Gray && !yuvPixels.empty()) {
+            yuvPixels.resize(static_cast<size_t>(surface->w) * surface->h);
+            yuvPixels.shrink_to_fit();
+        }
+        
+        // RGB surfaces are converted to the texture format here, off the render thread
+        if (yuvPixels.empty() && surface->format->format != textureFormat) {
+            SDL_Surface* native = SDL_ConvertSurfaceFormat(surface, textureFormat, 0);
+            if (native) {
+                SDL_FreeSurface(surface);
+                surface = native;
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(imagesMutex);
+        ImageData& image = *images[index];
+        image.width = surface->w;
+        image.height = surface->h;
+        image.scaleDenominator = scaleDenominator;
+        if (!yuvPixels.empty()) {
+            image.yuvPixels = std::move(yuvPixels);
+            SDL_FreeSurface(surface);
+        } else {
+            image.surface = surface;
+        }
+        image.surfaceLoaded = true;
+    }
+    
+    // Keep planar pixels decoded without a surface (a gray frame's Y plane)
+    void storePlanes(size_t index, std::vector<Uint8>&& yuvPixels, int width, int height, int scaleDenominator) {
+        std::lock_guard<std::mutex> lock(imagesMutex);
+        ImageData& image = *images[index];
+        image.width = width;
+        image.height = height;
+        image.scaleDenominator = scaleDenominator;
+        image.yuvPixels = std::move(yuvPixels);
+        image.surfaceLoaded = true;
+    }
+    
+    // Decode the current image again at a finer scale once the window grew past what its
+    // reduced JPEG decode fills (render thread only, since the texture is recreated)
+    void refreshScaledImage(size_t index) {
+        ImageData& image = *images[index];
+        if (!image.surfaceLoaded || image.scaleDenominator == 1) {
+            return;
+        }
+        int needed = frame_pipeline::chooseJpegScale(image.width * image.scaleDenominator,
+                                                     image.height * image.scaleDenominator,
+                                                     windowWidth, windowHeight);
+        if (needed >= image.scaleDenominator) {
+            return;
+        }
+        
+        {
             std::lock_guard<std::mutex> lock(imagesMutex);
-            images[index]->surface = surface;
-            images[index]->surfaceLoaded = true;
+            if (image.texture) {
+                SDL_DestroyTexture(image.texture);
+                image.texture = nullptr;
+            }
+            if (image.surface) {
+                SDL_FreeSurface(image.surface);
+                image.surface = nullptr;
+            }
+            image.yuvPixels.clear();
+            image.textureCreated = false;
+            image.surfaceLoaded = false;
         }
+        loadImage(index);
+    }
+    
+    // Convert a surface to planar YUV 4:2:0, empty if it has odd dimensions or cannot be converted
+    std::vector<Uint8> convertToYuv(SDL_Surface* surface) {
+        std::vector<Uint8> yuvPixels;
+        if (surface->w % 2 != 0 || surface->h % 2 != 0) {
+            return yuvPixels;
+        }
+        
+        // SDL_ConvertPixels doesn't take palettes, so expand paletted images first
+        SDL_Surface* source = surface;
+        if (SDL_ISPIXELFORMAT_INDEXED(surface->format->format)) {
+            source = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0);
+            if (!source) return yuvPixels;
+        }
+        
+        yuvPixels.resize(static_cast<size_t>(surface->w) * surface->h * 3 / 2);
+        if (SDL_ConvertPixels(surface->w, surface->h, source->format->format, source->pixels, source->pitch,
+                              SDL_PIXELFORMAT_IYUV, yuvPixels.data(), surface->w) != 0) {
+            std::cerr << "YUV conversion failed, keeping RGB: " << SDL_GetError() << std::endl;
+            yuvPixels.clear();
+        }
+        
+        if (source != surface) {
+            SDL_FreeSurface(source);
+        }
+        return yuvPixels;
+    }
+    
+    // Create a texture in the frame's own format so the upload is a plain copy. YUV and gray
+    // frames go to IYUV streaming textures so the renderer does the color conversion.
+    SDL_Texture* createTexture(ImageData& image) {
+        bool yuv = !image.yuvPixels.empty();
+        Uint32 pixelFormat = yuv ? static_cast<Uint32>(SDL_PIXELFORMAT_IYUV) : image.surface->format->format;
+        SDL_Texture* texture = SDL_CreateTexture(renderer, pixelFormat, SDL_TEXTUREACCESS_STREAMING,
+                                                 image.width, image.height);
+        if (!texture) {
+            return nullptr;
+        }
+        
+        int result;
+        if (!yuv) {
+            result = SDL_UpdateTexture(texture, nullptr, image.surface->pixels, image.surface->pitch);
+        } else if (frameFormat == frame_pipeline::FrameFormat::Gray) {
+            neutralChroma.assign(static_cast<size_t>(image.width / 2) * (image.height / 2), 128);
+            result = SDL_UpdateYUVTexture(texture, nullptr, image.yuvPixels.data(), image.width,
+                                          neutralChroma.data(), image.width / 2, neutralChroma.data(), image.width / 2);
+        } else {
+            result = SDL_UpdateTexture(texture, nullptr, image.yuvPixels.data(), image.width);
+        }
+        
+        if (result != 0) {
+            SDL_DestroyTexture(texture);
+            texture = nullptr;
+        }
+        return texture;
     }
     
     void ensureTextureCreated(size_t index) {
@@ -219,8 +536,9 @@ public:
         std::lock_guard<std::mutex> lock(imagesMutex);
         
         // If surface is loaded but texture not created, create it now
-        if (images[index]->surfaceLoaded && !images[index]->textureCreated && images[index]->surface) {
-            images[index]->texture = SDL_CreateTextureFromSurface(renderer, images[index]->surface);
+        if (images[index]->surfaceLoaded && !images[index]->textureCreated &&
+            (images[index]->surface || !images[index]->yuvPixels.empty())) {
+            images[index]->texture = createTexture(*images[index]);
             if (images[index]->texture) {
                 images[index]->textureCreated = true;
                 // Keep the surface for potential future use, or free it to save memory
@@ -234,6 +552,13 @@ public:
         size_t imageCount = images.size();
         
         while (running) {
+            // An image the filmstrip jumped to goes ahead of the sequential order
+            int urgent = urgentImage.exchange(-1);
+            if (urgent >= 0) {
+                loadSurfaceInBackground(static_cast<size_t>(urgent));
+                continue;
+            }
+            
             size_t currentIndex = nextImageToLoad.fetch_add(1);
             
             if (currentIndex >= imageCount) {
@@ -270,12 +595,75 @@ public:
         }
     }
     
+    // Open the directory's thumbnail cache, create the atlas pages and start generating the
+    // missing thumbnails around the current image. Thumbnails take the first image's aspect ratio.
+    void startThumbnails() {
+        const ImageData& first = *images[0];
+        int width, height;
+        frame_pipeline::thumbnailSize(first.width * first.scaleDenominator, first.height * first.scaleDenominator,
+                                      frame_pipeline::DEFAULT_THUMBNAIL_HEIGHT, width, height);
+        try {
+            thumbnailStore = std::make_unique<frame_pipeline::ThumbnailStore>(imageFiles, width, height,
+                                                                              thumbnailCacheDirectory);
+        } catch (const std::exception& e) {
+            std::cerr << "Filmstrip disabled: " << e.what() << std::endl;
+            return;
+        }
+        if (!filmstrip.create(renderer, *thumbnailStore)) {
+            thumbnailStore.reset();
+            return;
+        }
+        
+        const frame_pipeline::ThumbnailAtlasLayout& atlas = filmstrip.layout();
+        std::cout << "Thumbnails: " << width << "x" << height << ", " << thumbnailStore->cachedCount() << "/"
+                  << thumbnailStore->size() << (thumbnailStore->persistent() ? " cached" : " (cache unavailable)")
+                  << ", " << atlas.pages << " atlas page(s) of " << atlas.pageWidth << "x" << atlas.pageHeight
+                  << std::endl;
+        thumbnailGenerator.setCursor(currentIndex);
+        thumbnailGenerator.start(*thumbnailStore,
+                                 [this](size_t index, uint8_t* thumbnail) { return renderThumbnail(index, thumbnail); },
+                                 [this] {
+                                     int urgent = urgentInFlight;
+                                     return urgent >= 0 && !images[urgent]->surfaceLoaded;
+                                 });
+    }
+    
+    // Thumbnail of an image from a reduced decode: JPEGs at down to 1/8 scale through libjpeg,
+    // other images through SDL_image, then box-filtered (generator thread)
+    bool renderThumbnail(size_t index, uint8_t* thumbnail) {
+        int width = thumbnailStore->width();
+        int height = thumbnailStore->height();
+        MappedFile file(imageFiles[index]);
+        if (!file.data) {
+            return false;
+        }
+        if (frame_pipeline::isJpeg(file.data, file.size) &&
+            frame_pipeline::decodeJpegThumbnail(file.data, file.size, thumbnail, width, height)) {
+            return true;
+        }
+        
+        SDL_Surface* surface = IMG_Load_RW(SDL_RWFromConstMem(file.data, static_cast<int>(file.size)), 1);
+        if (!surface) {
+            return false;
+        }
+        SDL_Surface* bgr = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_BGR24, 0);
+        SDL_FreeSurface(surface);
+        if (!bgr) {
+            return false;
+        }
+        frame_pipeline::downscaleToThumbnail(static_cast<const uint8_t*>(bgr->pixels), bgr->w, bgr->h, bgr->pitch, 3,
+                                             thumbnail, width, height);
+        SDL_FreeSurface(bgr);
+        return true;
+    }
+    
     void render() {
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
         SDL_RenderClear(renderer);
         
         if (currentIndex >= 0 && currentIndex < static_cast<int>(images.size())) {
             // Try to create texture from surface if available (main thread only)
+            refreshScaledImage(currentIndex);
             ensureTextureCreated(currentIndex);
             
             std::lock_guard<std::mutex> lock(imagesMutex);
@@ -305,6 +693,8 @@ public:
                 // Display loading message for unloaded images
                 renderLoadingMessage();
             }
+            
+            renderFilmstrip();
         }
         
         SDL_RenderPresent(renderer);
@@ -329,6 +719,36 @@ public:
         // In a full implementation, you'd use SDL_ttf for actual text
     }
     
+    // Filmstrip along the bottom of the window, over the image; moves the generator to the current image
+    void renderFilmstrip() {
+        if (!thumbnailStore || !filmstripVisible) return;
+        
+        thumbnailGenerator.setCursor(currentIndex);
+        filmstrip.render(currentIndex, windowWidth, windowHeight);
+    }
+    
+    // Clicks on a filmstrip thumbnail jump to its image
+    bool handleFilmstripClick(int x, int y) {
+        long image;
+        if (!thumbnailStore || !filmstripVisible ||
+            !filmstrip.frameAt(currentIndex, windowWidth, windowHeight, x, y, image)) {
+            return false;
+        }
+        if (image >= 0) {
+            jumpToImage(static_cast<size_t>(image));
+        }
+        return true;
+    }
+    
+    // Show an image; one still waiting for the loader threads is decoded next, ahead of the others
+    void jumpToImage(size_t index) {
+        currentIndex = static_cast<int>(index);
+        if (!images[index]->loadStarted) {
+            urgentInFlight = static_cast<int>(index);
+            urgentImage = static_cast<int>(index);
+        }
+    }
+    
     void handleEvent(SDL_Event& e) {
         if (e.type == SDL_QUIT) {
             running = false;
@@ -340,10 +760,15 @@ public:
                 case SDLK_RIGHT:
                     nextImage();
                     break;
+                case SDLK_f:
+                    filmstripVisible = !filmstripVisible;
+                    break;
                 case SDLK_ESCAPE:
                     running = false;
                     break;
             }
+        } else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
+            handleFilmstripClick(e.button.x, e.button.y);
         } else if (e.type == SDL_WINDOWEVENT) {
             if (e.window.event == SDL_WINDOWEVENT_RESIZED) {
                 windowWidth = e.window.data1;
@@ -380,6 +805,13 @@ public:
     void cleanup() {
         running = false;
         
+        thumbnailGenerator.stop();
+        if (thumbnailGenerator.generatedCount() > 0) {
+            std::cout << "Thumbnails: " << thumbnailGenerator.generatedCount() << " generated, "
+                      << thumbnailGenerator.renderMilliseconds() / thumbnailGenerator.generatedCount() << " ms each"
+                      << std::endl;
+        }
+        
         // Wait for all background loading threads to finish
         for (auto& loader : backgroundLoaders) {
             if (loader.joinable()) {
@@ -389,6 +821,8 @@ public:
         backgroundLoaders.clear();
         
         images.clear();
+        filmstrip.destroy();
+        thumbnailStore.reset();
         
         if (renderer) {
             SDL_DestroyRenderer(renderer);
@@ -405,13 +839,44 @@ public:
     }
 };
 
+// Per-user cache directory for thumbnails: $XDG_CACHE_HOME/fisheye_viewer, else ~/.cache/fisheye_viewer,
+// so the cache doesn't depend on where the viewer is started from. Empty if neither is set.
+std::string defaultThumbnailCacheDirectory() {
+    const char* cacheHome = std::getenv("XDG_CACHE_HOME");
+    if (cacheHome && cacheHome[0] == '/') {
+        return (fs::path(cacheHome) / "fisheye_viewer").string();
+    }
+    const char* home = std::getenv("HOME");
+    if (home && home[0] != '\0') {
+        return (fs::path(home) / ".cache" / "fisheye_viewer").string();
+    }
+    return "";
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <image_directory>" << std::endl;
+    frame_pipeline::FrameFormat frameFormat = frame_pipeline::FrameFormat::BGR;
+    std::string thumbnailCacheDirectory = defaultThumbnailCacheDirectory();
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--thumbnail-cache" && i + 1 < argc) {
+            thumbnailCacheDirectory = argv[++i];
+        } else if (!frame_pipeline::parseFrameFormatFlag(argv[i], frameFormat)) {
+            arguments.push_back(argv[i]);
+        }
+    }
+    
+    if (arguments.size() != 1) {
+        std::cerr << "Usage: " << argv[0] << " [--yuv | --gray] [--thumbnail-cache <directory>] <image_directory>"
+                  << std::endl;
+        std::cerr << "  --yuv   Keep frames as YUV 4:2:0 (half the memory of RGB)" << std::endl;
+        std::cerr << "  --gray  Keep frames as 8-bit grayscale (a third of the memory of RGB)" << std::endl;
+        std::cerr << "  --thumbnail-cache  Directory of the filmstrip's thumbnail cache (default "
+                  << (thumbnailCacheDirectory.empty() ? "none" : thumbnailCacheDirectory)
+                  << "; \"\" keeps thumbnails in memory)" << std::endl;
         return 1;
     }
     
-    std::string imageDirectory = argv[1];
+    std::string imageDirectory = arguments[0];
     
     if (!fs::exists(imageDirectory) || !fs::is_directory(imageDirectory)) {
         std::cerr << "Error: " << imageDirectory << " is not a valid directory" << std::endl;
@@ -419,6 +884,8 @@ int main(int argc, char* argv[]) {
     }
     
     FisheyeViewer viewer;
+    viewer.setFrameFormat(frameFormat);
+    viewer.setThumbnailCacheDirectory(thumbnailCacheDirectory);
     
     if (!viewer.initialize()) {
         std::cerr << "Failed to initialize SDL" << std::endl;
@@ -431,6 +898,7 @@ int main(int argc, char* argv[]) {
     }
     
     std::cout << "Use left/right arrow keys to navigate, ESC to quit" << std::endl;
+    std::cout << "Click a filmstrip thumbnail to jump to its image, F toggles the filmstrip" << std::endl;
     viewer.run();
     
     return 0;
@@ -3,7 +3,8 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/highgui.hpp>
-#include "kitti360_calibration/load_calibration.h"
+#include "kitti360_calibration/calibration_registry.h"
+#include "kitti360_calibration/map_cache.h"
 #include <iostream>
 #include <filesystem>
 
@@ -11,6 +12,7 @@ namespace fs = std::filesystem;
 
 class FisheyeUndistorter {
 private:
+    std::shared_ptr<const kitti360::CalibrationSnapshot> calibration;
     kitti360::FisheyeParams cameraParams;
     cv::Mat cameraMatrix, distCoeffs;
     cv::Mat mapX, mapY;
@@ -25,6 +27,9 @@ private:
     
     // Interactive calibration parameters
     cv::Mat adjustedCameraMatrix, adjustedDistCoeffs;
+    cv::Mat currentNewCameraMatrix; // Output camera matrix of the current maps
+    
+    const std::string MAP_CACHE_DIRECTORY = "kitti360_calibration/map_cache";
     
 public:
     FisheyeUndistorter() : calibrationLoaded(false), currentFocalScale(5.0), 
@@ -35,7 +40,10 @@ public:
             std::cout << "=== LOADING FISHEYE CALIBRATION PARAMETERS ===" << std::endl;
             
             // Load fisheye parameters for left camera (image_02)
-            cameraParams = kitti360::loadFisheyeParams("kitti360_calibration/image_02.yaml");
+            auto& registry = kitti360::CalibrationRegistry::instance();
+            registry.setMapCacheDirectory(MAP_CACHE_DIRECTORY);
+            calibration = registry.load("kitti360_calibration");
+            cameraParams = calibration->fisheye("image_02").params;
             
             std::cout << "✓ Successfully loaded calibration file: kitti360_calibration/image_02.yaml" << std::endl;
             std::cout << "Camera: " << cameraParams.camera_name << std::endl;
@@ -82,122 +90,37 @@ public:
     }
     
     void setupCameraParameters() {
-        // Setup camera matrix from fisheye parameters
-        cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
-        cameraMatrix.at<double>(0, 0) = cameraParams.projection[0]; // gamma1 (fx)
-        cameraMatrix.at<double>(1, 1) = cameraParams.projection[1]; // gamma2 (fy)
-        cameraMatrix.at<double>(0, 2) = cameraParams.projection[2]; // u0 (cx)
-        cameraMatrix.at<double>(1, 2) = cameraParams.projection[3]; // v0 (cy)
+        // Camera matrix from fisheye parameters (gamma1, gamma2, u0, v0)
+        const kitti360::FisheyeCamera& camera = calibration->fisheye("image_02");
+        cameraMatrix = camera.cameraMatrix.clone();
         
         std::cout << "Camera matrix:" << std::endl << cameraMatrix << std::endl;
         
         // For fisheye model, use all 4 distortion parameters
-        // Map MEI model parameters to OpenCV fisheye model
         // k1, k2 are radial distortion (same in both models)
-        // p1, p2 from MEI can be mapped to k3, k4 in OpenCV fisheye model
-        distCoeffs = cv::Mat::zeros(4, 1, CV_64F);
-        distCoeffs.at<double>(0) = cameraParams.distortion[0]; // k1
-        distCoeffs.at<double>(1) = cameraParams.distortion[1]; // k2
-        distCoeffs.at<double>(2) = cameraParams.distortion[2]; // k3 (was p1 in MEI)
-        distCoeffs.at<double>(3) = cameraParams.distortion[3]; // k4 (was p2 in MEI)
+        // p1, p2 from MEI are mapped to k3, k4 in OpenCV fisheye model
+        distCoeffs = camera.distCoeffs.clone();
         
         std::cout << "Fisheye distortion coefficients (k1, k2, k3, k4):" << std::endl << distCoeffs.t() << std::endl;
         std::cout << "Note: Using ALL calibration parameters (no zeros)" << std::endl;
     }
     
     void createUndistortionMaps() {
-        cv::Size inputImageSize(cameraParams.image_width, cameraParams.image_height);
+        // Initial maps use the default ultra-flat projection (4x width, 2x height, 5x focal
+        // length), so they are shared through the registry with the other tools
+        std::shared_ptr<const kitti360::UndistortionMaps> maps =
+            kitti360::CalibrationRegistry::instance().undistortionMaps(calibration, "image_02");
         
-        // Create a much larger output size for the unwrapped fisheye
-        // For ultra-flat projection, we need extreme width to spread angular changes linearly
-        // Use approximately 4x width and 2x height for ultra-wide panoramic view
-        outputImageSize.width = static_cast<int>(inputImageSize.width * 4.0);
-        outputImageSize.height = static_cast<int>(inputImageSize.height * 2.0);
+        outputImageSize = maps->outputSize;
+        mapX = maps->map1;
+        mapY = maps->map2;
+        currentNewCameraMatrix = maps->newCameraMatrix;
         
         std::cout << "Creating fisheye undistortion maps:" << std::endl;
-        std::cout << "  Input image size: " << inputImageSize << std::endl;
+        std::cout << "  Input image size: " << maps->inputSize << std::endl;
         std::cout << "  Output image size: " << outputImageSize << " (wider for unwrapped view)" << std::endl;
-        
-        // The key insight: we need to EXPAND the fisheye image, not compress it!
-        // For fisheye undistortion, we typically want to INCREASE the focal lengths 
-        // to stretch out the compressed fisheye view into a flat perspective
-        
-        // Try multiple approaches to get the right undistortion
-        
-        // Approach 1: Adjust camera matrix for larger output and fisheye expansion
-        cv::Mat newCameraMatrix1 = cameraMatrix.clone();
-        
-        // Adjust principal point to center of new larger image
-        newCameraMatrix1.at<double>(0, 2) = outputImageSize.width / 2.0;  // cx
-        newCameraMatrix1.at<double>(1, 2) = outputImageSize.height / 2.0; // cy
-        
-        // For ultra-flat projection, use much more aggressive focal length scaling
-        double expandScale = 5.0;  // Much higher for flatter projection
-        newCameraMatrix1.at<double>(0, 0) *= expandScale; // fx
-        newCameraMatrix1.at<double>(1, 1) *= expandScale; // fy
-        
-        // Approach 2: Even more aggressive expansion for ultra-flat result
-        cv::Mat newCameraMatrix2 = cameraMatrix.clone();
-        newCameraMatrix2.at<double>(0, 2) = outputImageSize.width / 2.0;  // cx
-        newCameraMatrix2.at<double>(1, 2) = outputImageSize.height / 2.0; // cy
-        
-        double ultraFlatScale = 8.0;  // Ultra-aggressive scaling
-        newCameraMatrix2.at<double>(0, 0) *= ultraFlatScale; // fx
-        newCameraMatrix2.at<double>(1, 1) *= ultraFlatScale; // fy
-        
-        // Approach 3: Try inverting the distortion coefficients
-        cv::Mat invertedDistCoeffs = -distCoeffs; // Invert the signs
-        
-        std::cout << "Testing different approaches for ultra-flat fisheye transformation:" << std::endl;
-        std::cout << "Original camera matrix:" << std::endl << cameraMatrix << std::endl;
-        std::cout << "Expanded camera matrix (scale=" << expandScale << "):" << std::endl << newCameraMatrix1 << std::endl;
-        std::cout << "Ultra-flat expansion (scale=" << ultraFlatScale << "):" << std::endl << newCameraMatrix2 << std::endl;
-        std::cout << "Original distortion:" << distCoeffs.t() << std::endl;
-        std::cout << "Inverted distortion:" << invertedDistCoeffs.t() << std::endl;
-        
-        // Try approach 1: Expanded focal lengths with original distortion
-        try {
-            cv::fisheye::initUndistortRectifyMap(
-                cameraMatrix, distCoeffs, cv::Mat(),
-                newCameraMatrix1, outputImageSize, CV_16SC2,
-                mapX, mapY
-            );
-            std::cout << "✓ Fisheye undistortion maps created with expanded focal lengths and larger output!" << std::endl;
-        } catch (const cv::Exception& e) {
-            std::cerr << "Approach 1 failed: " << e.what() << std::endl;
-            
-            // Try approach 2: More aggressive expansion
-            try {
-                cv::fisheye::initUndistortRectifyMap(
-                    cameraMatrix, distCoeffs, cv::Mat(),
-                    newCameraMatrix2, outputImageSize, CV_16SC2,
-                    mapX, mapY
-                );
-                std::cout << "✓ Using aggressive expansion approach with larger output!" << std::endl;
-            } catch (const cv::Exception& e2) {
-                std::cerr << "Approach 2 failed: " << e2.what() << std::endl;
-                
-                // Try approach 3: Inverted distortion
-                try {
-                    cv::fisheye::initUndistortRectifyMap(
-                        cameraMatrix, invertedDistCoeffs, cv::Mat(),
-                        newCameraMatrix1, outputImageSize, CV_16SC2,
-                        mapX, mapY
-                    );
-                    std::cout << "✓ Using inverted distortion coefficients with larger output!" << std::endl;
-                } catch (const cv::Exception& e3) {
-                    std::cerr << "All approaches failed. Using standard undistort method..." << std::endl;
-                    
-                    // Fallback: use standard OpenCV undistort instead of fisheye
-                    cv::initUndistortRectifyMap(
-                        cameraMatrix, distCoeffs, cv::Mat(),
-                        newCameraMatrix1, outputImageSize, CV_16SC2,
-                        mapX, mapY
-                    );
-                    std::cout << "✓ Using standard camera undistortion as fallback with larger output" << std::endl;
-                }
-            }
-        }
+        std::cout << "Expanded camera matrix (scale=" << currentFocalScale << "):" << std::endl << maps->newCameraMatrix << std::endl;
+        std::cout << "✓ Fisheye undistortion maps created with expanded focal lengths and larger output!" << std::endl;
     }
     
     cv::Mat undistortImage(const cv::Mat& originalImage) {
@@ -256,6 +179,11 @@ public:
         newCameraMatrix.at<double>(1, 2) = outputImageSize.height / 2.0; // cy
         newCameraMatrix.at<double>(0, 0) *= currentFocalScale; // fx
         newCameraMatrix.at<double>(1, 1) *= currentFocalScale; // fy
+        currentNewCameraMatrix = newCameraMatrix;
+        
+        // Release first: the initial maps are shared through the registry and must not be overwritten
+        mapX.release();
+        mapY.release();
         
         // Create undistortion maps with current parameters (using adjusted calibration)
         try {
@@ -323,7 +251,7 @@ public:
         std::cout << "    - k1, k2: Radial distortion coefficients" << std::endl;
         std::cout << "    - k3, k4: Additional fisheye distortion" << std::endl;
         std::cout << "    - fx, fy: Camera focal lengths" << std::endl;
-        std::cout << "Press ESC to quit" << std::endl;
+        std::cout << "Press E to export the tuned maps for the other viewers, ESC to quit" << std::endl;
         
         // Create windows
         cv::namedWindow("Original Fisheye", cv::WINDOW_NORMAL);
@@ -458,6 +386,9 @@ public:
             if (key == 27) { // ESC
                 break;
             }
+            if (key == 'e' || key == 'E') {
+                exportMapPackage();
+            }
         }
         
         cv::destroyAllWindows();
@@ -474,6 +405,37 @@ public:
                   << ", fy=" << adjustedCameraMatrix.at<double>(1, 1) << std::endl;
     }
     
+    // Write the adjusted calibration and the current fixed-point maps as a map package
+    // that dual_fisheye_viewer maps instead of building its own
+    void exportMapPackage() {
+        if (!calibrationLoaded || mapX.empty()) {
+            std::cerr << "✗ Nothing to export: undistortion maps not created" << std::endl;
+            return;
+        }
+        
+        kitti360::UndistortionMaps maps;
+        maps.map1 = mapX;
+        maps.map2 = mapY;
+        maps.newCameraMatrix = currentNewCameraMatrix;
+        maps.inputSize = cv::Size(cameraParams.image_width, cameraParams.image_height);
+        maps.outputSize = outputImageSize;
+        
+        kitti360::UnwrapSettings settings;
+        settings.focalScale = currentFocalScale;
+        settings.widthMultiplier = currentWidthMultiplier;
+        settings.heightMultiplier = currentHeightMultiplier;
+        
+        std::string path = kitti360::tunedMapPackagePath(MAP_CACHE_DIRECTORY, cameraParams.camera_name);
+        try {
+            kitti360::writeMapPackage(path, cameraParams.camera_name, adjustedCameraMatrix, adjustedDistCoeffs,
+                                      settings, maps, calibration->contentHash);
+            std::cout << "✓ Exported tuned maps (" << outputImageSize.width << "x" << outputImageSize.height
+                      << ") to " << path << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "✗ Export failed: " << e.what() << std::endl;
+        }
+    }
+    
     void updateDisplay() {
         cv::Mat undistorted = processWithCurrentParams();
         if (!undistorted.empty()) {